@@ -0,0 +1,414 @@
+#define GLM_ENABLE_EXPERIMENTAL
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <iterator>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "glm/gtx/transform.hpp"
+
+#include "m3/board.hpp"
+#include "m3/solver.hpp"
+#include "renderer/texture.hpp"
+
+// Mede trechos de CPU isolados, sem contexto de OpenGL. Cada kernel roda em lotes que dobram de
+// tamanho até passar de MIN_BATCH_SECONDS; o resultado é o melhor de REPETITIONS lotes. Antes das
+// métricas de cor confere o ΔE2000 com os pares de referência e sai com código 1 se algum errar.
+//
+//     ./microbenchmarks [--filter texto]
+
+constexpr double MIN_BATCH_SECONDS = 0.2;
+constexpr int REPETITIONS = 5;
+
+// Acumula resultados em uma variável volátil para o compilador não descartar o kernel.
+volatile float sink = 0.0f;
+
+// Os 34 pares de Sharma, Wu e Dalal (2005): L, a e b das duas cores e o ΔE00 esperado. Os de 9 a 16
+// caem nas bordas do matiz médio (matizes opostos, cromas quase zero).
+constexpr float DELTA_E2000_PAIRS[][7] = {
+    {50.0000f, 2.6772f, -79.7751f, 50.0000f, 0.0000f, -82.7485f, 2.0425f},
+    {50.0000f, 3.1571f, -77.2803f, 50.0000f, 0.0000f, -82.7485f, 2.8615f},
+    {50.0000f, 2.8361f, -74.0200f, 50.0000f, 0.0000f, -82.7485f, 3.4412f},
+    {50.0000f, -1.3802f, -84.2814f, 50.0000f, 0.0000f, -82.7485f, 1.0000f},
+    {50.0000f, -1.1848f, -84.8006f, 50.0000f, 0.0000f, -82.7485f, 1.0000f},
+    {50.0000f, -0.9009f, -85.5211f, 50.0000f, 0.0000f, -82.7485f, 1.0000f},
+    {50.0000f, 0.0000f, 0.0000f, 50.0000f, -1.0000f, 2.0000f, 2.3669f},
+    {50.0000f, -1.0000f, 2.0000f, 50.0000f, 0.0000f, 0.0000f, 2.3669f},
+    {50.0000f, 2.4900f, -0.0010f, 50.0000f, -2.4900f, 0.0009f, 7.1792f},
+    {50.0000f, 2.4900f, -0.0010f, 50.0000f, -2.4900f, 0.0010f, 7.1792f},
+    {50.0000f, 2.4900f, -0.0010f, 50.0000f, -2.4900f, 0.0011f, 7.2195f},
+    {50.0000f, 2.4900f, -0.0010f, 50.0000f, -2.4900f, 0.0012f, 7.2195f},
+    {50.0000f, -0.0010f, 2.4900f, 50.0000f, 0.0009f, -2.4900f, 4.8045f},
+    {50.0000f, -0.0010f, 2.4900f, 50.0000f, 0.0010f, -2.4900f, 4.8045f},
+    {50.0000f, -0.0010f, 2.4900f, 50.0000f, 0.0011f, -2.4900f, 4.7461f},
+    {50.0000f, 2.5000f, 0.0000f, 50.0000f, 0.0000f, -2.5000f, 4.3065f},
+    {50.0000f, 2.5000f, 0.0000f, 73.0000f, 25.0000f, -18.0000f, 27.1492f},
+    {50.0000f, 2.5000f, 0.0000f, 61.0000f, -5.0000f, 29.0000f, 22.8977f},
+    {50.0000f, 2.5000f, 0.0000f, 56.0000f, -27.0000f, -3.0000f, 31.9030f},
+    {50.0000f, 2.5000f, 0.0000f, 58.0000f, 24.0000f, 15.0000f, 19.4535f},
+    {50.0000f, 2.5000f, 0.0000f, 50.0000f, 3.1736f, 0.5854f, 1.0000f},
+    {50.0000f, 2.5000f, 0.0000f, 50.0000f, 3.2972f, 0.0000f, 1.0000f},
+    {50.0000f, 2.5000f, 0.0000f, 50.0000f, 1.8634f, 0.5757f, 1.0000f},
+    {50.0000f, 2.5000f, 0.0000f, 50.0000f, 3.2592f, 0.3350f, 1.0000f},
+    {60.2574f, -34.0099f, 36.2677f, 60.4626f, -34.1751f, 39.4387f, 1.2644f},
+    {63.0109f, -31.0961f, -5.8663f, 62.8187f, -29.7946f, -4.0864f, 1.2630f},
+    {61.2901f, 3.7196f, -5.3901f, 61.4292f, 2.2480f, -4.9620f, 1.8731f},
+    {35.0831f, -44.1164f, 3.7933f, 35.0232f, -40.0716f, 1.5901f, 1.8645f},
+    {22.7233f, 20.0904f, -46.6940f, 23.0331f, 14.9730f, -42.5619f, 2.0373f},
+    {36.4612f, 47.8580f, 18.3852f, 36.2715f, 50.5065f, 21.2231f, 1.4146f},
+    {90.8027f, -2.0831f, 1.4410f, 91.1528f, -1.6435f, 0.0447f, 1.4441f},
+    {90.9257f, -0.5406f, -0.9208f, 88.6381f, -0.8985f, -0.7239f, 1.5381f},
+    {6.7747f, -0.2908f, -2.4247f, 5.8714f, -0.0985f, -2.2286f, 0.6377f},
+    {2.0776f, 0.0795f, -1.1350f, 0.9033f, -0.0636f, -0.5514f, 0.9082f},
+};
+
+// Diferença aceita, em ΔE, entre as contas em float e os valores da tabela (com quatro casas).
+constexpr float DELTA_E2000_CHECK_TOLERANCE = 1e-3f;
+
+struct MicrobenchmarkResult {
+    std::string name;
+    double nanosecondsPerItem = 0.0;
+    double bytesPerSecond = 0.0;
+};
+
+// items e bytes são por chamada do kernel; ns/op é por item.
+template <typename Kernel>
+MicrobenchmarkResult runMicrobenchmark(const std::string& name, const long long items, const long long bytes,
+                                       Kernel kernel) {
+    using Clock = std::chrono::steady_clock;
+
+    kernel();
+
+    long long calls = 1;
+    double seconds = 0.0;
+    while (true) {
+        const Clock::time_point start = Clock::now();
+        for (long long i = 0; i < calls; i++) {
+            kernel();
+        }
+        seconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+        if (seconds >= MIN_BATCH_SECONDS) {
+            break;
+        }
+        calls *= 2;
+    }
+
+    double best = seconds;
+    for (int repetition = 1; repetition < REPETITIONS; repetition++) {
+        const Clock::time_point start = Clock::now();
+        for (long long i = 0; i < calls; i++) {
+            kernel();
+        }
+        best = std::min(best, std::chrono::duration<double>(Clock::now() - start).count());
+    }
+
+    MicrobenchmarkResult result;
+    result.name = name;
+    result.nanosecondsPerItem = best * 1e9 / static_cast<double>(calls * items);
+    result.bytesPerSecond = static_cast<double>(calls * bytes) / best;
+    return result;
+}
+
+void printResult(const MicrobenchmarkResult& result) {
+    std::cout << std::left << std::setw(48) << result.name << std::right << std::fixed
+              << std::setw(12) << std::setprecision(2) << result.nanosecondsPerItem << " ns/op"
+              << std::setw(12) << std::setprecision(1) << result.bytesPerSecond / (1024.0 * 1024.0) << " MiB/s"
+              << std::endl;
+}
+
+// Mesma composição translate * rotate * scale do antigo Sprite::processModel, uma matriz por sprite.
+void benchmarkSpriteModel(const int sprites) {
+    std::vector<glm::vec3> positions(sprites);
+    for (int i = 0; i < sprites; i++) {
+        positions[i] = glm::vec3(randomFloat() * 800.0f, randomFloat() * 600.0f, 0.0f);
+    }
+
+    printResult(runMicrobenchmark(
+        "sprite model matrix (" + std::to_string(sprites) + " sprites)", sprites,
+        static_cast<long long>(sprites) * sizeof(glm::mat4),
+        [&positions] {
+            float sum = 0.0f;
+            for (const glm::vec3& position : positions) {
+                glm::mat4 model = glm::mat4(1);
+                model = glm::translate(model, position);
+                model = glm::rotate(model, glm::radians(180.0f), glm::vec3(0, 0, 1));
+                model = glm::scale(model, glm::vec3(25.0f, 25.0f, 1.0f));
+                sum += model[3][0];
+            }
+            sink = sink + sum;
+        }
+    ));
+}
+
+Board createBoard(const int side) {
+    Board board;
+    board.resize(side, side, 800.0f, 800.0f);
+    board.generate();
+    return board;
+}
+
+// O teste de distância percorre o tabuleiro todo a cada clique, visível ou não; depois da primeira
+// chamada nada mais some, mas o custo por célula é o mesmo.
+void benchmarkColorDistance(const int side) {
+    Board board = createBoard(side);
+    const glm::vec3 selected = board.color(board.index(side / 2, side / 2));
+    const long long quads = static_cast<long long>(side) * side;
+
+    printResult(runMicrobenchmark(
+        "color distance (" + std::to_string(quads) + " quads)", quads,
+        quads * static_cast<long long>(3 * sizeof(float)),
+        [&board, selected] {
+            sink = sink + static_cast<float>(board.eliminateSimilar(selected));
+        }
+    ));
+}
+
+// Só o kernel de um bloco, com e sem SIMD, sobre as cores de um tabuleiro de 1000x1000.
+void benchmarkColorMask() {
+    Board board = createBoard(1000);
+    const glm::vec3 selected = board.color(0);
+    const long long quads = static_cast<long long>(board.red.size());
+
+    printResult(runMicrobenchmark(
+        "similarColorMask (" + std::to_string(quads) + " quads)", quads, quads * 3 * sizeof(float),
+        [&board, selected] {
+            uint64_t bits = 0;
+            for (size_t offset = 0; offset < board.red.size(); offset += BOARD_BLOCK) {
+                bits ^= similarColorMask(&board.red[offset], &board.green[offset], &board.blue[offset], selected);
+            }
+            sink = sink + static_cast<float>(bits & 1u);
+        }
+    ));
+
+    printResult(runMicrobenchmark(
+        "similarColorMaskScalar (" + std::to_string(quads) + " quads)", quads, quads * 3 * sizeof(float),
+        [&board, selected] {
+            uint64_t bits = 0;
+            for (size_t offset = 0; offset < board.red.size(); offset += BOARD_BLOCK) {
+                bits ^= similarColorMaskScalar(&board.red[offset], &board.green[offset], &board.blue[offset],
+                                               selected);
+            }
+            sink = sink + static_cast<float>(bits & 1u);
+        }
+    ));
+}
+
+// A mesma eliminação com cada métrica; as ΔE percorrem as cores já convertidas para CIELAB.
+void benchmarkColorMetric(const ColorMetric metric) {
+    Board board = createBoard(1000);
+    board.metric = metric;
+    const glm::vec3 selected = board.color(board.index(500, 500));
+    const long long quads = board.cells();
+
+    printResult(runMicrobenchmark(
+        std::string("color metric ") + colorMetricName(metric) + " (" + std::to_string(quads) + " quads)", quads,
+        quads * static_cast<long long>((metric == ColorMetric::Rgb ? 3 : 4) * sizeof(float)),
+        [&board, selected] {
+            sink = sink + static_cast<float>(board.eliminateSimilar(selected));
+        }
+    ));
+}
+
+// A prévia do hover pela ColorGrid, contra o custo de percorrer o tabuleiro (color distance acima).
+void benchmarkColorPreview(const int side) {
+    Board board = createBoard(side);
+    const glm::vec3 selected = board.color(board.index(side / 2, side / 2));
+    const long long quads = static_cast<long long>(side) * side;
+    std::vector<int> cells;
+
+    printResult(runMicrobenchmark(
+        "color grid preview (" + std::to_string(quads) + " quads)", quads,
+        quads * static_cast<long long>(3 * sizeof(float)),
+        [&board, &cells, selected] {
+            board.previewSimilar(selected, cells);
+            sink = sink + static_cast<float>(cells.size());
+        }
+    ));
+}
+
+// Rotulagem de todas as regiões do modo conectado, com uma thread e com uma por núcleo.
+void benchmarkRegionLabeling(const int side, const unsigned threads) {
+    Board board = createBoard(side);
+    const long long quads = static_cast<long long>(side) * side;
+
+    printResult(runMicrobenchmark(
+        "labelRegions (" + std::to_string(quads) + " quads, " + std::to_string(threads) + " threads)", quads,
+        quads * static_cast<long long>(3 * sizeof(float)),
+        [&board, threads] {
+            board.labelRegions(threads);
+            sink = sink + static_cast<float>(board.regionSize[0]);
+        }
+    ));
+}
+
+// Solução ótima de um tabuleiro inteiro em uma thread; ns/op é por célula.
+void benchmarkSolver(const int side) {
+    Board board = createBoard(side);
+    const long long quads = static_cast<long long>(side) * side;
+
+    SolverOptions options;
+    options.threads = 1;
+    Solution solution;
+
+    printResult(runMicrobenchmark(
+        "solveBoard (" + std::to_string(quads) + " quads)", quads,
+        quads * static_cast<long long>(3 * sizeof(float)),
+        [&board, &options, &solution] {
+            solveBoard(board, options, solution);
+            sink = sink + static_cast<float>(solution.plays());
+        }
+    ));
+}
+
+void benchmarkGenerateBoard(const int side) {
+    Board board;
+    board.resize(side, side, 800.0f, 800.0f);
+    const long long quads = static_cast<long long>(side) * side;
+
+    printResult(runMicrobenchmark(
+        "generateBoard (" + std::to_string(quads) + " quads)", quads,
+        quads * static_cast<long long>(3 * sizeof(float)),
+        [&board] {
+            board.generate();
+            sink = sink + board.red[0];
+        }
+    ));
+}
+
+// bytes/s conta os pixels decodificados (RGBA8), não o tamanho do PNG.
+void benchmarkImageDecode(const std::string& filePath) {
+    Image image;
+    if (!loadImage(filePath, image)) {
+        return;
+    }
+
+    printResult(runMicrobenchmark(
+        "loadImage " + filePath, 1, static_cast<long long>(image.pixels.size()),
+        [&filePath] {
+            Image decoded;
+            loadImage(filePath, decoded);
+            sink = sink + static_cast<float>(decoded.width);
+        }
+    ));
+}
+
+// Confere deltaE2000 e os dois kernels de bloco (com e sem SIMD) com os pares de referência: cada
+// bloco é a segunda cor repetida, e um limite logo acima do esperado precisa aceitar todas as
+// células enquanto um logo abaixo não aceita nenhuma.
+bool checkDeltaE2000() {
+    static_assert(BOARD_BLOCK == 64, "o bloco cheio abaixo supõe 64 células");
+    const uint64_t allCells = ~uint64_t(0);
+
+    const int pairs = static_cast<int>(std::size(DELTA_E2000_PAIRS));
+    int failures = 0;
+
+    for (int i = 0; i < pairs; i++) {
+        const float* pair = DELTA_E2000_PAIRS[i];
+        const glm::vec3 reference(pair[0], pair[1], pair[2]);
+        const glm::vec3 sample(pair[3], pair[4], pair[5]);
+        const float expected = pair[6];
+
+        std::vector<float> lightness(BOARD_BLOCK, sample.x);
+        std::vector<float> a(BOARD_BLOCK, sample.y);
+        std::vector<float> b(BOARD_BLOCK, sample.z);
+        std::vector<float> chroma(BOARD_BLOCK, std::sqrt(sample.y * sample.y + sample.z * sample.z));
+        const LabBlock block{lightness.data(), a.data(), b.data(), chroma.data()};
+
+        const float above = expected + 2.0f * DELTA_E2000_CHECK_TOLERANCE;
+        const float below = expected - 2.0f * DELTA_E2000_CHECK_TOLERANCE;
+        const float value = deltaE2000(reference, sample);
+
+        const bool correct = std::fabs(value - expected) <= DELTA_E2000_CHECK_TOLERANCE
+                             && similarLabMask(ColorMetric::DeltaE2000, block, reference, above) == allCells
+                             && similarLabMask(ColorMetric::DeltaE2000, block, reference, below) == 0
+                             && similarLabMaskScalar(ColorMetric::DeltaE2000, block, reference, above) == allCells
+                             && similarLabMaskScalar(ColorMetric::DeltaE2000, block, reference, below) == 0;
+        if (!correct) {
+            std::cout << "CIEDE2000 pair " << i + 1 << ": got " << value << ", expected " << expected << std::endl;
+            failures++;
+        }
+    }
+
+    std::cout << std::left << std::setw(48) << "CIEDE2000 reference pairs" << std::right << std::setw(12)
+              << pairs - failures << " / " << pairs << " ok" << std::endl;
+    return failures == 0;
+}
+
+bool selected(const std::string& filter, const std::string& group) {
+    return filter.empty() || group.find(filter) != std::string::npos;
+}
+
+int main(int argc, char** argv) {
+    std::string filter;
+    for (int i = 1; i < argc; i++) {
+        if (std::strcmp(argv[i], "--filter") == 0 && i + 1 < argc) {
+            filter = argv[++i];
+        }
+    }
+
+    srand(1);
+
+    bool failed = false;
+
+    if (selected(filter, "sprite")) {
+        for (const int sprites : {100, 10000, 1000000}) {
+            benchmarkSpriteModel(sprites);
+        }
+    }
+
+    if (selected(filter, "color")) {
+        failed = !checkDeltaE2000();
+
+        for (const int side : {10, 100, 1000}) {
+            benchmarkColorDistance(side);
+        }
+        benchmarkColorMask();
+        for (const int side : {10, 100, 1000}) {
+            benchmarkColorPreview(side);
+        }
+        for (int metric = 0; metric < COLOR_METRIC_COUNT; metric++) {
+            benchmarkColorMetric(static_cast<ColorMetric>(metric));
+        }
+    }
+
+    if (selected(filter, "region")) {
+        const unsigned cores = std::max(1u, std::thread::hardware_concurrency());
+        for (const int side : {1000, 4096}) {
+            benchmarkRegionLabeling(side, 1);
+            if (cores > 1) {
+                benchmarkRegionLabeling(side, cores);
+            }
+        }
+    }
+
+    if (selected(filter, "solve")) {
+        for (const int side : {5, 8, 10}) {
+            benchmarkSolver(side);
+        }
+    }
+
+    if (selected(filter, "generate")) {
+        for (const int side : {10, 100, 1000}) {
+            benchmarkGenerateBoard(side);
+        }
+    }
+
+    if (selected(filter, "image")) {
+        for (int i = 0; i < 6; i++) {
+            benchmarkImageDecode("../assets/m4/" + std::to_string(i) + ".png");
+        }
+        benchmarkImageDecode("../assets/m4/character.png");
+        benchmarkImageDecode("../assets/m5/background.png");
+        benchmarkImageDecode("../assets/m5/character.png");
+    }
+
+    return failed ? 1 : 0;
+}
@@ -5,9 +5,18 @@
 
 #include "GLFW/glfw3.h"
 
+#include "renderer/buffer.hpp"
+#include "renderer/gl_state.hpp"
+#include "renderer/profiler.hpp"
+#include "renderer/render_context.hpp"
+#include "renderer/shader.hpp"
+
 constexpr int WIDTH = 800;
 constexpr int HEIGHT = 600;
 
+// Triângulos concêntricos desenhados quando --scale não é informado.
+constexpr int DEFAULT_TRIANGLES = 5;
+
 constexpr auto vertexShaderSource =
 R"GLSL(
 #version 330 core
@@ -40,57 +49,6 @@ void processInput(GLFWwindow* window) {
     }
 }
 
-GLuint compileShader(const char* shaderSource, int shaderType) {
-    const GLuint shaderId = glCreateShader(shaderType);
-    glShaderSource(shaderId, 1, &shaderSource, nullptr);
-    glCompileShader(shaderId);
-
-    int success;
-    glGetShaderiv(shaderId, GL_COMPILE_STATUS, &success);
-
-    if (!success) {
-        char infoLog[512];
-        glGetShaderInfoLog(shaderId, sizeof(infoLog), nullptr, infoLog);
-        std::cout << "ERROR::SHADER::COMPILATION_FAILED\n" << infoLog << std::endl;
-    }
-
-    return shaderId;
-}
-
-GLuint createShaderProgram() {
-    const GLuint vertexShader = compileShader(vertexShaderSource, GL_VERTEX_SHADER);
-    const GLuint fragmentShader = compileShader(fragmentShaderSource, GL_FRAGMENT_SHADER);
-
-    const GLuint shaderProgram = glCreateProgram();
-    glAttachShader(shaderProgram, vertexShader);
-    glAttachShader(shaderProgram, fragmentShader);
-    glLinkProgram(shaderProgram);
-
-    int success;
-    glGetProgramiv(shaderProgram, GL_LINK_STATUS, &success);
-    if (!success) {
-        char infoLog[512];
-        glGetProgramInfoLog(shaderProgram, sizeof(infoLog), nullptr, infoLog);
-        std::cout << "ERROR::SHADER::PROGRAM::LINKING_FAILED\n" << infoLog << std::endl;
-    }
-
-    glDeleteShader(vertexShader);
-    glDeleteShader(fragmentShader);
-
-    return shaderProgram;
-}
-
-GLuint createVBOAndBind(const GLuint VAO, const float* vertices, const int verticesLength) {
-    GLuint VBO;
-    glGenBuffers(1, &VBO);
-    glBindVertexArray(VAO);
-
-    glBindBuffer(GL_ARRAY_BUFFER, VBO);
-    glBufferData(GL_ARRAY_BUFFER, verticesLength * sizeof(float), vertices, GL_STATIC_DRAW);
-
-    return VBO;
-}
-
 GLuint createTriangle(
     const float x1,
     const float y1,
@@ -113,72 +71,81 @@ GLuint createTriangle(
     glEnableVertexAttribArray(0);
 
     glBindBuffer(GL_ARRAY_BUFFER, 0);
-    glBindVertexArray(0);
+    bindVertexArray(0);
 
     return VAO;
 }
 
-int main() {
-    glfwInit();
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
-    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
-
-    GLFWwindow* window = glfwCreateWindow(WIDTH, HEIGHT, "Otavio Triangulos", nullptr, nullptr);
-
-    if (window == nullptr) {
-        std::cout << "Failed to create GLFW window" << std::endl;
-        glfwTerminate();
+int main(int argc, char** argv) {
+    ContextOptions options;
+    if (!parseContextOptions(argc, argv, options)) {
         return -1;
     }
 
-    glfwMakeContextCurrent(window);
-
-    if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress)) {
-        std::cout << "Failed to initialize GLAD" << std::endl;
+    RenderContext context;
+    if (!context.create(WIDTH, HEIGHT, "Otavio Triangulos", options)) {
         return -1;
     }
 
-    glViewport(0, 0, WIDTH, HEIGHT);
-    glfwSetFramebufferSizeCallback(window, framebufferSizeCallback);
+    GLFWwindow* window = context.window;
+
+    glViewport(0, 0, context.width, context.height);
+    if (window != nullptr) {
+        glfwSetFramebufferSizeCallback(window, framebufferSizeCallback);
+    }
 
-    const GLuint shaderProgram = createShaderProgram();
+    const GLuint shaderProgram = createShaderProgram(vertexShaderSource, fragmentShaderSource);
+    // Com o padrão de 5 triângulos os tamanhos são 0.5, 0.4, 0.3, 0.2 e 0.1, como no exercício.
+    const int triangleCount = options.scale > 0 ? options.scale : DEFAULT_TRIANGLES;
     std::vector<GLuint> VAOs;
-    VAOs.push_back(createTriangle(-0.5f,  -0.5f, 0.5f, -0.5f, 0.0, 0.5f));
-    VAOs.push_back(createTriangle(-0.4f,  -0.4f, 0.4f, -0.4f, 0.0, 0.4f));
-    VAOs.push_back(createTriangle(-0.3f,  -0.3f, 0.3f, -0.3f, 0.0, 0.3f));
-    VAOs.push_back(createTriangle(-0.2f,  -0.2f, 0.2f, -0.2f, 0.0, 0.2f));
-    VAOs.push_back(createTriangle(-0.1f,  -0.1f, 0.1f, -0.1f, 0.0, 0.1f));
+    for (int i = 0; i < triangleCount; i++) {
+        const float size = 0.5f * static_cast<float>(triangleCount - i) / static_cast<float>(triangleCount);
+        VAOs.push_back(createTriangle(-size, -size, size, -size, 0.0, size));
+    }
 
     glDrawArrays(GL_TRIANGLES, 0, 3);
 
     glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
 
-    glUseProgram(shaderProgram);
+    useProgram(shaderProgram);
 
-    while(!glfwWindowShouldClose(window))
+    while(!context.shouldClose())
     {
-        glfwPollEvents();
-        processInput(window);
-
-        glClearColor(0.2f, 0.3f, 0.3f, 1.0f);
-        glClear(GL_COLOR_BUFFER_BIT);
+        PROFILE_ZONE("frame");
+
+        {
+            PROFILE_ZONE("input");
+            context.pollEvents();
+            if (window != nullptr) {
+                processInput(window);
+            }
+        }
 
-        for (const unsigned int VAO : VAOs) {
-            glBindVertexArray(VAO);
-            glDrawArrays(GL_TRIANGLES, 0, 3);
-            glBindVertexArray(0);
+        {
+            PROFILE_GPU_ZONE("draw");
+            // A cena é estática: com --on-demand só é desenhada de novo quando a janela muda de tamanho.
+            context.drawDamaged([&] {
+                glClearColor(0.2f, 0.3f, 0.3f, 1.0f);
+                glClear(GL_COLOR_BUFFER_BIT);
+
+                for (const unsigned int VAO : VAOs) {
+                    bindVertexArray(VAO);
+                    drawArrays(GL_TRIANGLES, 0, 3);
+                }
+            });
         }
 
-        glfwSwapBuffers(window);
+        context.swapBuffers();
     }
 
     for (const unsigned int VAO : VAOs) {
-        glDeleteVertexArrays(1, &VAO);
+        deleteVertexArray(VAO);
     }
 
-    glDeleteProgram(shaderProgram);
+    deleteProgram(shaderProgram);
 
-    glfwTerminate();
-    return 0;
+    context.writeBenchmarkReport("m2_p1", triangleCount);
+    const bool goldenPassed = context.checkGoldenImages("m2_p1");
+    context.destroy();
+    return goldenPassed ? 0 : 1;
 }
\ No newline at end of file
@@ -1,8 +1,11 @@
 #define GLM_ENABLE_EXPERIMENTAL
 
 #include <algorithm>
+#include <cmath>
+#include <cstddef>
 #include <glad.h>
 #include <iostream>
+#include <memory>
 #include <vector>
 
 #include "GLFW/glfw3.h"
@@ -13,6 +16,14 @@
 #include "glm/gtc/type_ptr.hpp"
 #include "glm/gtx/transform.hpp"
 
+#include "renderer/buffer.hpp"
+#include "renderer/gl_state.hpp"
+#include "renderer/profiler.hpp"
+#include "renderer/render_context.hpp"
+#include "renderer/shader.hpp"
+#include "renderer/software_rasterizer.hpp"
+#include "renderer/uniform_buffer.hpp"
+
 constexpr int WIDTH = 800;
 constexpr int HEIGHT = 600;
 
@@ -41,27 +52,48 @@ glm::vec3 randomColor()
 };
 
 
+constexpr float TRIANGLE_SCALE = 100.0f;
+const float TRIANGLE_ROTATION = glm::radians(180.0f);
+constexpr int SPRAY_TRIANGLES_PER_FRAME = 1000;
+constexpr float SPRAY_RADIUS = 50.0f;
+
+// A matriz de modelo de cada triângulo (translate * rotate * scale) é montada no vertex shader
+// a partir dos atributos por instância, assim todos os triângulos saem em um único draw instanciado.
 constexpr auto vertexShaderSource =
+"#version 330 core\n"
+FRAME_UNIFORM_BLOCK_GLSL
 R"GLSL(
-#version 330 core
 layout (location = 0) in vec3 aPos;
-uniform mat4 projection;
-uniform mat4 model;
+layout (location = 1) in vec2 instancePosition;
+layout (location = 2) in vec3 instanceColor;
+uniform float rotation;
+uniform vec2 scale;
+out vec3 vertexColor;
 
 void main()
 {
+    float c = cos(rotation);
+    float s = sin(rotation);
+    mat4 model = mat4(
+        c * scale.x, s * scale.x, 0.0, 0.0,
+        -s * scale.y, c * scale.y, 0.0, 0.0,
+        0.0, 0.0, 1.0, 0.0,
+        instancePosition.x, instancePosition.y, 0.0, 1.0
+    );
+
+    vertexColor = instanceColor;
     gl_Position = projection * model * vec4(aPos.x, aPos.y, aPos.z, 1.0);
 }
 )GLSL";
 
 constexpr auto fragmentShaderSource = R"GLSL(
 #version 330 core
-uniform vec4 inputColor;
+in vec3 vertexColor;
 out vec4 FragColor;
 
 void main()
 {
-    FragColor = inputColor;
+    FragColor = vec4(vertexColor, 1.0);
 }
 )GLSL";
 
@@ -78,57 +110,6 @@ void processInput(GLFWwindow* window) {
     }
 }
 
-GLuint compileShader(const char* shaderSource, int shaderType) {
-    const GLuint shaderId = glCreateShader(shaderType);
-    glShaderSource(shaderId, 1, &shaderSource, nullptr);
-    glCompileShader(shaderId);
-
-    int success;
-    glGetShaderiv(shaderId, GL_COMPILE_STATUS, &success);
-
-    if (!success) {
-        char infoLog[512];
-        glGetShaderInfoLog(shaderId, sizeof(infoLog), nullptr, infoLog);
-        std::cout << "ERROR::SHADER::COMPILATION_FAILED\n" << infoLog << std::endl;
-    }
-
-    return shaderId;
-}
-
-GLuint createShaderProgram() {
-    const GLuint vertexShader = compileShader(vertexShaderSource, GL_VERTEX_SHADER);
-    const GLuint fragmentShader = compileShader(fragmentShaderSource, GL_FRAGMENT_SHADER);
-
-    const GLuint shaderProgram = glCreateProgram();
-    glAttachShader(shaderProgram, vertexShader);
-    glAttachShader(shaderProgram, fragmentShader);
-    glLinkProgram(shaderProgram);
-
-    int success;
-    glGetProgramiv(shaderProgram, GL_LINK_STATUS, &success);
-    if (!success) {
-        char infoLog[512];
-        glGetProgramInfoLog(shaderProgram, sizeof(infoLog), nullptr, infoLog);
-        std::cout << "ERROR::SHADER::PROGRAM::LINKING_FAILED\n" << infoLog << std::endl;
-    }
-
-    glDeleteShader(vertexShader);
-    glDeleteShader(fragmentShader);
-
-    return shaderProgram;
-}
-
-GLuint createVBOAndBind(const GLuint VAO, const float* vertices, const int verticesLength) {
-    GLuint VBO;
-    glGenBuffers(1, &VBO);
-    glBindVertexArray(VAO);
-
-    glBindBuffer(GL_ARRAY_BUFFER, VBO);
-    glBufferData(GL_ARRAY_BUFFER, verticesLength * sizeof(float), vertices, GL_STATIC_DRAW);
-
-    return VBO;
-}
-
 GLuint createTriangle(
     const float x1,
     const float y1,
@@ -151,115 +132,284 @@ GLuint createTriangle(
     glEnableVertexAttribArray(0);
 
     glBindBuffer(GL_ARRAY_BUFFER, 0);
-    glBindVertexArray(0);
+    bindVertexArray(0);
 
     return VAO;
 }
 
-int main() {
-    std::vector<Triangle> triangles;
+struct InstanceBuffer
+{
+    GLuint VBO = 0;
+    size_t capacity = 0;
+    size_t uploaded = 0;
+};
 
-    glfwInit();
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
-    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+InstanceBuffer createInstanceBuffer(const GLuint VAO) {
+    InstanceBuffer buffer = {};
+    glGenBuffers(1, &buffer.VBO);
 
-    GLFWwindow* window = glfwCreateWindow(WIDTH, HEIGHT, "Otavio Triangulos", nullptr, nullptr);
+    bindVertexArray(VAO);
+    glBindBuffer(GL_ARRAY_BUFFER, buffer.VBO);
 
-    if (window == nullptr) {
-        std::cout << "Failed to create GLFW window" << std::endl;
-        glfwTerminate();
-        return -1;
+    glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, sizeof(Triangle), (void*)offsetof(Triangle, position));
+    glEnableVertexAttribArray(1);
+    glVertexAttribDivisor(1, 1);
+
+    glVertexAttribPointer(2, 3, GL_FLOAT, GL_FALSE, sizeof(Triangle), (void*)offsetof(Triangle, color));
+    glEnableVertexAttribArray(2);
+    glVertexAttribDivisor(2, 1);
+
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    bindVertexArray(0);
+
+    return buffer;
+}
+
+// Os triângulos só são adicionados ao final do vetor, então basta enviar os novos.
+// Quando a capacidade estoura o buffer é realocado com o dobro do tamanho e reenviado inteiro.
+void uploadNewTriangles(InstanceBuffer& buffer, const std::vector<Triangle>& triangles) {
+    if (buffer.uploaded == triangles.size()) {
+        return;
+    }
+
+    glBindBuffer(GL_ARRAY_BUFFER, buffer.VBO);
+
+    if (triangles.size() > buffer.capacity) {
+        buffer.capacity = std::max(triangles.size(), buffer.capacity * 2);
+        glBufferData(GL_ARRAY_BUFFER, buffer.capacity * sizeof(Triangle), nullptr, GL_DYNAMIC_DRAW);
+        buffer.uploaded = 0;
+    }
+
+    glBufferSubData(
+        GL_ARRAY_BUFFER,
+        buffer.uploaded * sizeof(Triangle),
+        (triangles.size() - buffer.uploaded) * sizeof(Triangle),
+        triangles.data() + buffer.uploaded
+    );
+    buffer.uploaded = triangles.size();
+
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+// A cena usa sempre coordenadas de WIDTH x HEIGHT, qualquer que seja o tamanho da janela.
+glm::vec2 cursorScenePosition(GLFWwindow* window) {
+    double xpos, ypos;
+    glfwGetCursorPos(window, &xpos, &ypos);
+
+    int windowWidth, windowHeight;
+    glfwGetWindowSize(window, &windowWidth, &windowHeight);
+
+    return glm::vec2(xpos * WIDTH / windowWidth, ypos * HEIGHT / windowHeight);
+}
+
+void sprayTriangles(RenderContext& context, GLFWwindow* window, std::vector<Triangle>& triangles) {
+    if (glfwGetMouseButton(window, GLFW_MOUSE_BUTTON_RIGHT) != GLFW_PRESS) {
+        return;
+    }
+
+    // Segurar o botão parado não gera eventos, mas o spray continua.
+    context.requestFrame();
+
+    const glm::vec2 cursor = cursorScenePosition(window);
+
+    for (int i = 0; i < SPRAY_TRIANGLES_PER_FRAME; i++) {
+        const float angle = glm::radians(static_cast<float>(rand() % 360));
+        const float radius = SPRAY_RADIUS * static_cast<float>(rand()) / static_cast<float>(RAND_MAX);
+
+        Triangle triangle = {};
+        triangle.position = glm::vec2(cursor.x + cos(angle) * radius, cursor.y + sin(angle) * radius);
+        triangle.color = randomColor();
+
+        triangles.push_back(triangle);
+    }
+}
+
+// Com --on-demand só a área dos triângulos ainda não enviados é redesenhada. A cena tem y para baixo e
+// o framebuffer, y para cima.
+void damageNewTriangles(RenderContext& context, const std::vector<Triangle>& triangles, const size_t first) {
+    if (!context.onDemand() || first >= triangles.size()) {
+        return;
+    }
+
+    glm::vec2 low = triangles[first].position;
+    glm::vec2 high = low;
+    for (size_t i = first + 1; i < triangles.size(); i++) {
+        low = glm::vec2(std::min(low.x, triangles[i].position.x), std::min(low.y, triangles[i].position.y));
+        high = glm::vec2(std::max(high.x, triangles[i].position.x), std::max(high.y, triangles[i].position.y));
+    }
+
+    // Meio triângulo para cada lado, mais um pixel de folga para o arredondamento.
+    const float extent = TRIANGLE_SCALE * 0.5f + 1.0f;
+    const float scaleX = static_cast<float>(context.width) / WIDTH;
+    const float scaleY = static_cast<float>(context.height) / HEIGHT;
+
+    const int left = static_cast<int>(std::floor((low.x - extent) * scaleX));
+    const int right = static_cast<int>(std::ceil((high.x + extent) * scaleX));
+    const int bottom = static_cast<int>(std::floor(context.height - (high.y + extent) * scaleY));
+    const int top = static_cast<int>(std::ceil(context.height - (low.y - extent) * scaleY));
+    context.damage(left, bottom, right - left, top - bottom);
+}
+
+// Mesma matriz de modelo do vertex shader, aplicada na CPU para o --software.
+void drawTrianglesSoftware(SoftwareRasterizer& software, const std::vector<Triangle>& triangles,
+                           const GLuint framebuffer, const std::vector<DamageRect>& damage) {
+    const float c = cos(TRIANGLE_ROTATION);
+    const float s = sin(TRIANGLE_ROTATION);
+    const glm::vec2 corners[3] = {glm::vec2(-0.5f, -0.5f), glm::vec2(0.5f, -0.5f), glm::vec2(0.0f, 0.5f)};
+
+    glm::vec2 offsets[3];
+    for (int i = 0; i < 3; i++) {
+        const glm::vec2 scaled = corners[i] * TRIANGLE_SCALE;
+        offsets[i] = glm::vec2(c * scaled.x - s * scaled.y, s * scaled.x + c * scaled.y);
+    }
+
+    software.clear(glm::vec4(0.2f, 0.3f, 0.3f, 1.0f));
+    for (const Triangle& triangle : triangles) {
+        software.drawTriangle(triangle.position + offsets[0], triangle.position + offsets[1],
+                              triangle.position + offsets[2], glm::vec4(triangle.color, 1.0f));
+    }
+    software.present(framebuffer, damage);
+}
+
+// Espalha triângulos pela tela inteira, para o modo benchmark começar com uma cena grande.
+void scatterTriangles(std::vector<Triangle>& triangles, const int count) {
+    triangles.reserve(triangles.size() + count);
+
+    for (int i = 0; i < count; i++) {
+        Triangle triangle = {};
+        triangle.position = glm::vec2(rand() % WIDTH, rand() % HEIGHT);
+        triangle.color = randomColor();
+
+        triangles.push_back(triangle);
     }
+}
 
-    glfwMakeContextCurrent(window);
+int main(int argc, char** argv) {
+    std::vector<Triangle> triangles;
 
-    if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress)) {
-        std::cout << "Failed to initialize GLAD" << std::endl;
+    ContextOptions options;
+    if (!parseContextOptions(argc, argv, options)) {
         return -1;
     }
 
-    glViewport(0, 0, WIDTH, HEIGHT);
-    glfwSetFramebufferSizeCallback(window, framebufferSizeCallback);
+    RenderContext context;
+    if (!context.create(WIDTH, HEIGHT, "Otavio Triangulos", options)) {
+        return -1;
+    }
 
-    glfwSetWindowUserPointer(window, &triangles);
-    glfwSetMouseButtonCallback(window,
-    [] (GLFWwindow* window, int button, int action, int mods)
-        {
+    GLFWwindow* window = context.window;
+    srand(options.seed);
+
+    glViewport(0, 0, context.width, context.height);
+
+    if (window != nullptr) {
+        glfwSetFramebufferSizeCallback(window, framebufferSizeCallback);
 
-            if (button == GLFW_MOUSE_BUTTON_LEFT && action == GLFW_PRESS)
+        glfwSetWindowUserPointer(window, &triangles);
+        glfwSetMouseButtonCallback(window,
+        [] (GLFWwindow* window, int button, int action, int mods)
             {
-                auto triangles = static_cast<std::vector<Triangle>*>(glfwGetWindowUserPointer(window));
-                double xpos, ypos;
-                glfwGetCursorPos(window, &xpos, &ypos);
 
-                Triangle triangle = {};
-                triangle.position = glm::vec2(xpos,ypos);
-                triangle.color = randomColor();
+                if (button == GLFW_MOUSE_BUTTON_LEFT && action == GLFW_PRESS)
+                {
+                    auto triangles = static_cast<std::vector<Triangle>*>(glfwGetWindowUserPointer(window));
+                    Triangle triangle = {};
+                    triangle.position = cursorScenePosition(window);
+                    triangle.color = randomColor();
 
-                triangles->push_back(triangle);
+                    triangles->push_back(triangle);
+                }
             }
-        }
-    );
+        );
+    }
 
-    const GLuint shaderProgram = createShaderProgram();
+    const GLuint shaderProgram = createShaderProgram(vertexShaderSource, fragmentShaderSource);
     GLuint triangleVAO = createTriangle(-0.5f,  -0.5f, 0.5f, -0.5f, 0.0, 0.5f);
+    InstanceBuffer instanceBuffer = createInstanceBuffer(triangleVAO);
+
+    if (options.scale > 0) {
+        scatterTriangles(triangles, options.scale);
+    } else {
+        Triangle baseTriangle = {};
+        baseTriangle.position = glm::vec2(400.0f, 300.0f);
+        baseTriangle.color = randomColor();
+        triangles.push_back(baseTriangle);
+    }
 
-    Triangle baseTriangle = {};
-    baseTriangle.position = glm::vec2(400.0f, 300.0f);
-    baseTriangle.color = randomColor();
-    triangles.push_back(baseTriangle);
-
-    glUseProgram(shaderProgram);
-
-    GLint colorLoc = glGetUniformLocation(shaderProgram, "inputColor");
-    glm::mat4 projection = glm::ortho(0.0, 800.0, 600.0, 0.0, -1.0, 1.0);
-    glUniformMatrix4fv(
-        glGetUniformLocation(shaderProgram, "projection"),
-        1,
-        GL_FALSE,
-        value_ptr(projection)
-    );
-
-    while(!glfwWindowShouldClose(window))
-    {
-        glfwPollEvents();
-        processInput(window);
+    bindUniformBlocks(shaderProgram);
+    useProgram(shaderProgram);
 
-        glClearColor(0.2f, 0.3f, 0.3f, 1.0f);
-        glClear(GL_COLOR_BUFFER_BIT);
+    FrameUniformBuffer frameUniformBuffer;
+    frameUniformBuffer.create();
 
-        glLineWidth(10);
-        glPointSize(20);
+    FrameUniforms frameUniforms;
+    frameUniforms.projection = glm::ortho(0.0, (double) WIDTH, (double) HEIGHT, 0.0, -1.0, 1.0);
+    glUniform1f(glGetUniformLocation(shaderProgram, "rotation"), TRIANGLE_ROTATION);
+    glUniform2f(glGetUniformLocation(shaderProgram, "scale"), TRIANGLE_SCALE, TRIANGLE_SCALE);
 
+    std::unique_ptr<SoftwareRasterizer> software;
+    if (options.software) {
+        software = std::make_unique<SoftwareRasterizer>();
+        software->create(context.width, context.height);
+        software->setProjection(frameUniforms.projection);
+    }
 
-        glBindVertexArray(triangleVAO);
-        for (const Triangle triangle : triangles) {
-            glm::mat4 model = glm::mat4(1);
+    while(!context.shouldClose())
+    {
+        PROFILE_ZONE("frame");
 
-            model = glm::translate(model, glm::vec3(triangle.position,  0.0));
-            model = glm::rotate(model, glm::radians(180.0f), glm::vec3(0,0,1));
-            model = glm::scale(model, glm::vec3(100, 100, 1.0));
+        {
+            PROFILE_ZONE("input");
+            context.pollEvents();
+            if (window != nullptr) {
+                processInput(window);
+                sprayTriangles(context, window, triangles);
+            }
+        }
 
-            glUniformMatrix4fv(
-                glGetUniformLocation(shaderProgram, "model"),
-                1,
-                GL_FALSE,
-                value_ptr(model)
-            );
+        {
+            PROFILE_ZONE("update");
+            frameUniforms.time = static_cast<float>(context.time());
+            frameUniformBuffer.update(frameUniforms);
 
-            glUniform4f(colorLoc, triangle.color.r, triangle.color.g, triangle.color.b, 1.0f);
+            damageNewTriangles(context, triangles, instanceBuffer.uploaded);
+            uploadNewTriangles(instanceBuffer, triangles);
+        }
 
-            glDrawArrays(GL_TRIANGLES, 0, 3);
+        {
+            PROFILE_GPU_ZONE("draw");
+            // A CPU monta o frame uma vez só e copia cada retângulo; a GPU redesenha por retângulo.
+            if (software) {
+                context.drawDamagedFrame([&](const std::vector<DamageRect>& damage) {
+                    drawTrianglesSoftware(*software, triangles, context.framebuffer(), damage);
+                });
+            } else {
+                context.drawDamaged([&] {
+                    glClearColor(0.2f, 0.3f, 0.3f, 1.0f);
+                    glClear(GL_COLOR_BUFFER_BIT);
+
+                    glLineWidth(10);
+                    glPointSize(20);
+
+                    bindVertexArray(triangleVAO);
+                    drawArraysInstanced(GL_TRIANGLES, 0, 3, static_cast<GLsizei>(triangles.size()));
+                });
+            }
         }
 
-        glBindVertexArray(0);
-        glfwSwapBuffers(window);
+        context.swapBuffers();
     }
 
-    glDeleteVertexArrays(1, &triangleVAO);
-    glDeleteProgram(shaderProgram);
-
-    glfwTerminate();
-    return 0;
+    if (software) {
+        software->destroy();
+    }
+    glDeleteBuffers(1, &instanceBuffer.VBO);
+    frameUniformBuffer.destroy();
+    deleteVertexArray(triangleVAO);
+    deleteProgram(shaderProgram);
+
+    context.writeBenchmarkReport("m2_p2", static_cast<long long>(triangles.size()));
+    const bool goldenPassed = context.checkGoldenImages("m2_p2");
+    context.destroy();
+    return goldenPassed ? 0 : 1;
 }
\ No newline at end of file
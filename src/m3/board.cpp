@@ -0,0 +1,528 @@
+#include "m3/board.hpp"
+
+#include <algorithm>
+#include <bitset>
+#include <cmath>
+#include <cstdlib>
+#include <thread>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define BOARD_USE_SSE2
+#endif
+
+namespace {
+    // Raiz de index com path halving. Com a raiz sempre na menor célula, ela é o rótulo da região.
+    int findRegion(std::vector<int>& parent, int index) {
+        while (parent[index] != index) {
+            parent[index] = parent[parent[index]];
+            index = parent[index];
+        }
+        return index;
+    }
+
+    void uniteRegions(std::vector<int>& parent, const int a, const int b) {
+        const int rootA = findRegion(parent, a);
+        const int rootB = findRegion(parent, b);
+
+        if (rootA < rootB) {
+            parent[rootB] = rootA;
+        } else if (rootB < rootA) {
+            parent[rootA] = rootB;
+        }
+    }
+
+    // Roda work(strip, firstColumn, lastColumn) em uma thread por faixa de colunas e espera todas.
+    template <typename Work>
+    void forEachStrip(const int strips, const int columns, Work work) {
+        // Com uma faixa só não vale criar uma thread.
+        if (strips == 1) {
+            work(0, 0, columns);
+            return;
+        }
+
+        std::vector<std::thread> workers;
+        workers.reserve(strips);
+
+        for (int strip = 0; strip < strips; strip++) {
+            const int first = static_cast<int>(static_cast<long long>(columns) * strip / strips);
+            const int last = static_cast<int>(static_cast<long long>(columns) * (strip + 1) / strips);
+            workers.emplace_back(work, strip, first, last);
+        }
+
+        for (std::thread& worker : workers) {
+            worker.join();
+        }
+    }
+}
+
+float randomFloat() {
+    return static_cast <float> (rand()) / static_cast <float> (RAND_MAX);;
+}
+
+glm::vec3 randomColor()
+{
+    return {randomFloat(), randomFloat(), randomFloat()};
+};
+
+uint64_t similarColorMaskScalar(const float* red, const float* green, const float* blue, const glm::vec3& color,
+                                const float limitSquared) {
+    uint64_t mask = 0;
+    for (int i = 0; i < BOARD_BLOCK; i++) {
+        const float dr = red[i] - color.r;
+        const float dg = green[i] - color.g;
+        const float db = blue[i] - color.b;
+        if (dr * dr + dg * dg + db * db <= limitSquared) {
+            mask |= uint64_t(1) << i;
+        }
+    }
+    return mask;
+}
+
+#ifdef BOARD_USE_SSE2
+
+uint64_t similarColorMask(const float* red, const float* green, const float* blue, const glm::vec3& color,
+                          const float limitSquared) {
+    const __m128 r = _mm_set1_ps(color.r);
+    const __m128 g = _mm_set1_ps(color.g);
+    const __m128 b = _mm_set1_ps(color.b);
+    const __m128 limit = _mm_set1_ps(limitSquared);
+
+    uint64_t mask = 0;
+    for (int i = 0; i < BOARD_BLOCK; i += 4) {
+        const __m128 dr = _mm_sub_ps(_mm_loadu_ps(red + i), r);
+        const __m128 dg = _mm_sub_ps(_mm_loadu_ps(green + i), g);
+        const __m128 db = _mm_sub_ps(_mm_loadu_ps(blue + i), b);
+
+        const __m128 distance = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dr, dr), _mm_mul_ps(dg, dg)), _mm_mul_ps(db, db));
+        const int lanes = _mm_movemask_ps(_mm_cmple_ps(distance, limit));
+
+        mask |= static_cast<uint64_t>(lanes) << i;
+    }
+    return mask;
+}
+
+#else
+
+uint64_t similarColorMask(const float* red, const float* green, const float* blue, const glm::vec3& color,
+                          const float limitSquared) {
+    return similarColorMaskScalar(red, green, blue, color, limitSquared);
+}
+
+#endif
+
+void Board::resize(const int columns, const int rows, const float width, const float height) {
+    this->columns = columns;
+    this->rows = rows;
+    this->quadWidth = width / (float) columns;
+    this->quadHeight = height / (float) rows;
+
+    const size_t blocks = (static_cast<size_t>(cells()) + BOARD_BLOCK - 1) / BOARD_BLOCK;
+    const size_t padded = blocks * BOARD_BLOCK;
+
+    this->red.assign(padded, 0.0f);
+    this->green.assign(padded, 0.0f);
+    this->blue.assign(padded, 0.0f);
+    this->lightness.assign(padded, 0.0f);
+    this->labA.assign(padded, 0.0f);
+    this->labB.assign(padded, 0.0f);
+    this->chroma.assign(padded, 0.0f);
+    this->visibleBits.assign(blocks, 0);
+    this->remaining = 0;
+    markClean();
+}
+
+void Board::generate() {
+    // Mesma ordem de sorteio de antes (coluna por coluna, r, g, b), então a semente gera o mesmo tabuleiro.
+    for (int i = 0; i < cells(); i++) {
+        const glm::vec3 color = randomColor();
+        this->red[i] = color.r;
+        this->green[i] = color.g;
+        this->blue[i] = color.b;
+    }
+
+    finishGenerate();
+}
+
+void Board::generate(std::mt19937& random) {
+    std::uniform_real_distribution<float> channel(0.0f, 1.0f);
+
+    for (int i = 0; i < cells(); i++) {
+        this->red[i] = channel(random);
+        this->green[i] = channel(random);
+        this->blue[i] = channel(random);
+    }
+
+    finishGenerate();
+}
+
+void Board::finishGenerate() {
+    for (int i = 0; i < cells(); i++) {
+        const glm::vec3 lab = rgbToLab(color(i));
+        this->lightness[i] = lab.x;
+        this->labA[i] = lab.y;
+        this->labB[i] = lab.z;
+        this->chroma[i] = std::sqrt(lab.y * lab.y + lab.z * lab.z);
+    }
+
+    std::fill(this->visibleBits.begin(), this->visibleBits.end(), ~uint64_t(0));
+    if (cells() % 64 != 0) {
+        this->visibleBits.back() = (uint64_t(1) << (cells() % 64)) - 1;
+    }
+    this->remaining = cells();
+    this->grid.build(this->red.data(), this->green.data(), this->blue.data(), cells());
+    this->regionsStale = true;
+    markDirty(0, cells() - 1);
+}
+
+int Board::nthVisible(int n) const {
+    for (size_t block = 0; block < this->visibleBits.size(); block++) {
+        const int count = static_cast<int>(std::bitset<64>(this->visibleBits[block]).count());
+        if (n >= count) {
+            n -= count;
+            continue;
+        }
+
+        uint64_t rest = this->visibleBits[block];
+        for (; n > 0; n--) {
+            rest &= rest - 1;
+        }
+        const int bit = static_cast<int>(std::bitset<64>((rest & (~rest + 1)) - 1).count());
+        return static_cast<int>(block * BOARD_BLOCK) + bit;
+    }
+    return -1;
+}
+
+glm::vec2 Board::position(const int index) const {
+    const int x = index / this->rows;
+    const int y = index % this->rows;
+    return glm::vec2(
+        (this->quadWidth / 2) + x * this->quadWidth,
+        (this->quadHeight / 2) + y * this->quadHeight);
+}
+
+uint64_t Board::similarMask(const size_t block, const glm::vec3& color, const glm::vec3& lab) const {
+    const size_t offset = block * BOARD_BLOCK;
+
+    if (this->metric == ColorMetric::Rgb) {
+        return similarColorMask(&this->red[offset], &this->green[offset], &this->blue[offset], color,
+                                similarDistanceSquared());
+    }
+
+    const LabBlock cells = {&this->lightness[offset], &this->labA[offset], &this->labB[offset], &this->chroma[offset]};
+    return similarLabMask(this->metric, cells, lab, labLimit());
+}
+
+int Board::eliminateSimilar(const glm::vec3& color) {
+    const glm::vec3 lab = rgbToLab(color);
+    int chain = 0;
+
+    for (size_t block = 0; block < this->visibleBits.size(); block++) {
+        const size_t offset = block * BOARD_BLOCK;
+        const uint64_t hits = similarMask(block, color, lab) & this->visibleBits[block];
+
+        this->visibleBits[block] &= ~hits;
+        chain += static_cast<int>(std::bitset<64>(hits).count());
+
+        int first = -1;
+        int last = -1;
+        for (uint64_t rest = hits; rest != 0; rest &= rest - 1) {
+            // Bits abaixo do menor bit ligado: a contagem deles é a posição desse bit.
+            const int bit = static_cast<int>(std::bitset<64>((rest & (~rest + 1)) - 1).count());
+            this->grid.remove(static_cast<int>(offset) + bit);
+
+            if (first < 0) {
+                first = bit;
+            }
+            last = bit;
+        }
+
+        if (first >= 0) {
+            markDirty(static_cast<int>(offset) + first, static_cast<int>(offset) + last);
+        }
+    }
+
+    this->remaining -= chain;
+    if (chain > 0) {
+        this->regionsStale = true;
+    }
+    return chain;
+}
+
+bool Board::similarCells(const int a, const int b) const {
+    if (this->metric == ColorMetric::Rgb) {
+        const float dr = this->red[a] - this->red[b];
+        const float dg = this->green[a] - this->green[b];
+        const float db = this->blue[a] - this->blue[b];
+        return dr * dr + dg * dg + db * db <= similarDistanceSquared();
+    }
+
+    const glm::vec3 labA = glm::vec3(this->lightness[a], this->labA[a], this->labB[a]);
+    const glm::vec3 labB = glm::vec3(this->lightness[b], this->labA[b], this->labB[b]);
+
+    // O ΔE94 não é simétrico; para a vizinhança valer nos dois sentidos basta um deles passar.
+    if (this->metric == ColorMetric::DeltaE94) {
+        return similarLab(this->metric, labA, labB, labLimit()) || similarLab(this->metric, labB, labA, labLimit());
+    }
+    return similarLab(this->metric, labA, labB, labLimit());
+}
+
+void Board::similarNeighbors(const int first, const int offset, const int count, unsigned char* similar) const {
+    if (this->metric != ColorMetric::Rgb) {
+        for (int i = 0; i < count; i++) {
+            similar[i] = similarCells(first + i, first + i + offset);
+        }
+        return;
+    }
+
+    // Sem desvios, para o compilador vetorizar.
+    const float* red = &this->red[first];
+    const float* green = &this->green[first];
+    const float* blue = &this->blue[first];
+
+    const float limitSquared = similarDistanceSquared();
+
+    for (int i = 0; i < count; i++) {
+        const float dr = red[i] - red[i + offset];
+        const float dg = green[i] - green[i + offset];
+        const float db = blue[i] - blue[i + offset];
+        similar[i] = dr * dr + dg * dg + db * db <= limitSquared;
+    }
+}
+
+void Board::labelRegions(unsigned threads) {
+    if (threads == 0) {
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    const int strips = std::max(1, std::min(static_cast<int>(threads), this->columns));
+
+    const int count = cells();
+    this->regionParent.resize(count);
+    this->regionOf.resize(count);
+    this->regionSize.resize(count);
+
+    // Cada faixa só liga células dela mesma, então as threads nunca escrevem no mesmo lugar.
+    forEachStrip(strips, this->columns, [this](const int /*strip*/, const int first, const int last) {
+        std::vector<int>& parent = this->regionParent;
+
+        for (int i = first * this->rows; i < last * this->rows; i++) {
+            parent[i] = i;
+        }
+
+        std::vector<unsigned char> below(this->rows, 0);
+        std::vector<unsigned char> right(this->rows, 0);
+
+        for (int x = first; x < last; x++) {
+            const int column = x * this->rows;
+
+            similarNeighbors(column, 1, this->rows - 1, below.data());
+            if (x + 1 < last) {
+                similarNeighbors(column, this->rows, this->rows, right.data());
+            }
+
+            for (int y = 0; y < this->rows; y++) {
+                const int cell = column + y;
+                if (!visible(cell)) {
+                    continue;
+                }
+
+                if (y + 1 < this->rows && below[y] && visible(cell + 1)) {
+                    uniteRegions(parent, cell, cell + 1);
+                }
+                if (x + 1 < last && right[y] && visible(cell + this->rows)) {
+                    uniteRegions(parent, cell, cell + this->rows);
+                }
+            }
+        }
+    });
+
+    // Costura as faixas pelas colunas de fronteira, agora sem threads.
+    for (int strip = 1; strip < strips; strip++) {
+        const int x = static_cast<int>(static_cast<long long>(this->columns) * strip / strips) - 1;
+
+        for (int y = 0; y < this->rows; y++) {
+            const int cell = index(x, y);
+            if (visible(cell) && visible(cell + this->rows) && similarCells(cell, cell + this->rows)) {
+                uniteRegions(this->regionParent, cell, cell + this->rows);
+            }
+        }
+    }
+
+    // Com o union-find pronto só há leituras nele. Cada faixa conta as regiões com raiz nela; as
+    // células cuja raiz ficou em outra faixa (só regiões que cruzam fronteiras) são contadas depois.
+    std::vector<std::vector<int>> crossing(strips);
+
+    forEachStrip(strips, this->columns, [this, &crossing](const int strip, const int first, const int last) {
+        const int begin = first * this->rows;
+        const int end = last * this->rows;
+        std::vector<int>& deferred = crossing[strip];
+
+        std::fill(this->regionSize.begin() + begin, this->regionSize.begin() + end, 0);
+
+        for (int i = begin; i < end; i++) {
+            if (!visible(i)) {
+                this->regionOf[i] = -1;
+                continue;
+            }
+
+            int root = i;
+            while (this->regionParent[root] != root) {
+                root = this->regionParent[root];
+            }
+
+            this->regionOf[i] = root;
+            if (root >= begin) {
+                this->regionSize[root]++;
+            } else {
+                deferred.push_back(root);
+            }
+        }
+    });
+
+    for (const std::vector<int>& roots : crossing) {
+        for (const int root : roots) {
+            this->regionSize[root]++;
+        }
+    }
+
+    this->labeledMetric = this->metric;
+    this->labeledTolerance = this->tolerance;
+    this->regionsStale = false;
+}
+
+int Board::eliminateRegion(const int index) {
+    if (!visible(index)) {
+        return 0;
+    }
+    if (!regionsValid()) {
+        labelRegions(this->labelThreads);
+    }
+
+    const int region = this->regionOf[index];
+    int first = -1;
+    int last = -1;
+
+    for (int i = 0; i < cells(); i++) {
+        if (this->regionOf[i] != region) {
+            continue;
+        }
+
+        hide(i);
+        this->regionOf[i] = -1;
+
+        if (first < 0) {
+            first = i;
+        }
+        last = i;
+    }
+
+    const int chain = this->regionSize[region];
+    this->remaining -= chain;
+    markDirty(first, last);
+    return chain;
+}
+
+void Board::previewRegion(const int index, std::vector<int>& cells) {
+    cells.clear();
+
+    if (!visible(index)) {
+        return;
+    }
+    if (!regionsValid()) {
+        labelRegions(this->labelThreads);
+    }
+
+    const int region = this->regionOf[index];
+    for (int i = 0; i < this->cells(); i++) {
+        if (this->regionOf[i] == region) {
+            cells.push_back(i);
+        }
+    }
+}
+
+int Board::eliminate(const int index) {
+    if (this->mode == EliminationMode::Connected) {
+        return eliminateRegion(index);
+    }
+    return eliminateSimilar(color(index));
+}
+
+void Board::preview(const int index, std::vector<int>& cells) {
+    if (this->mode == EliminationMode::Connected) {
+        previewRegion(index, cells);
+        return;
+    }
+
+    cells.clear();
+    if (visible(index)) {
+        previewSimilar(color(index), cells);
+    }
+}
+
+void Board::hide(const int index) {
+    this->visibleBits[index / 64] &= ~(uint64_t(1) << (index % 64));
+    this->grid.remove(index);
+}
+
+void Board::previewSimilar(const glm::vec3& color, std::vector<int>& cells) const {
+    cells.clear();
+
+    if (this->metric != ColorMetric::Rgb) {
+        const glm::vec3 lab = rgbToLab(color);
+
+        for (size_t block = 0; block < this->visibleBits.size(); block++) {
+            const uint64_t hits = similarMask(block, color, lab) & this->visibleBits[block];
+
+            for (uint64_t rest = hits; rest != 0; rest &= rest - 1) {
+                const int bit = static_cast<int>(std::bitset<64>((rest & (~rest + 1)) - 1).count());
+                cells.push_back(static_cast<int>(block * BOARD_BLOCK) + bit);
+            }
+        }
+        return;
+    }
+
+    const float limitSquared = similarDistanceSquared();
+
+    this->grid.query(color, limitSquared, [this, &color, &cells, limitSquared](const int bucket, const bool inside) {
+        for (int i = this->grid.bucketStart[bucket]; i < this->grid.bucketStart[bucket + 1]; i++) {
+            const int cell = this->grid.cells[i];
+            if (!visible(cell)) {
+                continue;
+            }
+
+            if (!inside) {
+                const float dr = this->red[cell] - color.r;
+                const float dg = this->green[cell] - color.g;
+                const float db = this->blue[cell] - color.b;
+                if (dr * dr + dg * dg + db * db > limitSquared) {
+                    continue;
+                }
+            }
+
+            cells.push_back(cell);
+        }
+    });
+}
+
+void Board::markClean() {
+    this->dirtyFirstColumn = 0;
+    this->dirtyLastColumn = -1;
+}
+
+void Board::markDirty(const int firstIndex, const int lastIndex) {
+    if (lastIndex < firstIndex) {
+        return;
+    }
+
+    const int first = firstIndex / this->rows;
+    const int last = lastIndex / this->rows;
+
+    if (!dirty()) {
+        this->dirtyFirstColumn = first;
+        this->dirtyLastColumn = last;
+        return;
+    }
+
+    this->dirtyFirstColumn = std::min(this->dirtyFirstColumn, first);
+    this->dirtyLastColumn = std::max(this->dirtyLastColumn, last);
+}
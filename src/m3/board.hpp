@@ -0,0 +1,182 @@
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+#include "glm/vec2.hpp"
+#include "glm/vec3.hpp"
+#include "m3/color_grid.hpp"
+#include "m3/color_metric.hpp"
+
+constexpr double MAX_DISTANCE = sqrt(3.0);
+constexpr double TOLERANCE = 0.2;
+
+// distance / MAX_DISTANCE <= TOLERANCE sem raiz: distance² <= (TOLERANCE * MAX_DISTANCE)².
+constexpr float SIMILAR_DISTANCE_SQUARED = static_cast<float>(TOLERANCE * TOLERANCE * 3.0);
+
+// Células processadas por vez: uma palavra do bitset de visibilidade.
+constexpr int BOARD_BLOCK = 64;
+
+float randomFloat();
+
+glm::vec3 randomColor();
+
+// Bit i ligado se a cor i do bloco (BOARD_BLOCK cores a partir de red/green/blue) está a uma
+// distância ao quadrado de no máximo limitSquared de color. Usa SSE2 quando disponível.
+uint64_t similarColorMask(const float* red, const float* green, const float* blue, const glm::vec3& color,
+                          float limitSquared = SIMILAR_DISTANCE_SQUARED);
+
+// Mesma coisa sem SIMD; é o caminho das plataformas sem SSE2.
+uint64_t similarColorMaskScalar(const float* red, const float* green, const float* blue, const glm::vec3& color,
+                                float limitSquared = SIMILAR_DISTANCE_SQUARED);
+
+// Global esconde todas as células parecidas com a clicada, em qualquer lugar do tabuleiro.
+// Connected só esconde a região da célula clicada: as células ligadas a ela por vizinhos (acima,
+// abaixo, esquerda, direita) parecidos entre si, como um balde de tinta.
+enum class EliminationMode {
+    Global,
+    Connected,
+};
+
+// Tabuleiro do jogo das cores, sem nada de OpenGL, para poder ser usado e medido fora do m3.
+// Ocupa sempre width x height, com colunas e linhas definidas em tempo de execução.
+//
+// Célula (x, y) fica no índice x * rows + y. As cores ficam em três vetores separados e a
+// visibilidade em um bitset, ambos com folga até um múltiplo de BOARD_BLOCK; os bits da folga
+// são sempre zero, então ela nunca entra nas contas.
+class Board {
+public:
+    int columns = 0;
+    int rows = 0;
+    float quadWidth = 0.0f;
+    float quadHeight = 0.0f;
+
+    std::vector<float> red;
+    std::vector<float> green;
+    std::vector<float> blue;
+    std::vector<uint64_t> visibleBits;
+
+    // As mesmas cores em CIELAB, convertidas uma vez em generate(), para as métricas ΔE.
+    std::vector<float> lightness;
+    std::vector<float> labA;
+    std::vector<float> labB;
+    std::vector<float> chroma;
+
+    ColorMetric metric = ColorMetric::Rgb;
+
+    // Em fração de MAX_DISTANCE, como TOLERANCE. As métricas ΔE usam os limites delas escalados
+    // pela mesma proporção, então mudar a tolerância afeta todas do mesmo jeito.
+    double tolerance = TOLERANCE;
+
+    EliminationMode mode = EliminationMode::Global;
+
+    // Regiões do modo Connected, calculadas por labelRegions(). regionOf[i] é a menor célula da
+    // região de i (ou -1 se i está escondida) e regionSize[r] é o tamanho da região r.
+    std::vector<int> regionOf;
+    std::vector<int> regionSize;
+
+    // Threads usadas quando eliminateRegion() e previewRegion() precisam rotular (0 usa uma por
+    // núcleo). Quem já joga vários tabuleiros em paralelo deve deixar em 1.
+    unsigned labelThreads = 0;
+
+    // Índice das cores, reconstruído em generate() e atualizado a cada eliminação.
+    ColorGrid grid;
+
+    void resize(int columns, int rows, float width, float height);
+
+    // Sorteia novas cores com rand() e deixa tudo visível.
+    void generate();
+
+    // O mesmo com um gerador próprio, para vários tabuleiros serem sorteados ao mesmo tempo.
+    void generate(std::mt19937& random);
+
+    int cells() const { return this->columns * this->rows; }
+
+    int index(int x, int y) const { return x * this->rows + y; }
+
+    // Centro da célula, derivado do índice.
+    glm::vec2 position(int index) const;
+
+    glm::vec3 color(int index) const {
+        return glm::vec3(this->red[index], this->green[index], this->blue[index]);
+    }
+
+    bool visible(int index) const { return (this->visibleBits[index / 64] >> (index % 64)) & 1u; }
+
+    // Esconde todas as células visíveis com cor parecida com color (em RGB), segundo a métrica
+    // atual, e devolve quantas foram.
+    int eliminateSimilar(const glm::vec3& color);
+
+    // As células que eliminateSimilar(color) esconderia, sem mudar nada. Em RGB usa a ColorGrid em
+    // vez de percorrer o tabuleiro, para poder rodar todo frame; as métricas ΔE percorrem tudo.
+    void previewSimilar(const glm::vec3& color, std::vector<int>& cells) const;
+
+    // Rotula todas as regiões de células visíveis com union-find, dividindo as colunas em faixas
+    // entre threads (0 usa uma por núcleo). As faixas são unidas depois pelas colunas de fronteira.
+    void labelRegions(unsigned threads = 0);
+
+    // Se os rótulos ainda valem: eles são refeitos por generate(), por uma eliminação Global e
+    // por troca de métrica ou de tolerância. Esconder uma região inteira não muda as outras.
+    bool regionsValid() const {
+        return this->labeledMetric == this->metric && this->labeledTolerance == this->tolerance && !this->regionsStale;
+    }
+
+    // Esconde a região de index (rotulando antes, se preciso) e devolve quantas células foram.
+    int eliminateRegion(int index);
+
+    void previewRegion(int index, std::vector<int>& cells);
+
+    // Elimina a partir da célula clicada segundo o modo atual.
+    int eliminate(int index);
+
+    void preview(int index, std::vector<int>& cells);
+
+    int visibleCount() const { return this->remaining; }
+
+    // A n-ésima célula visível em ordem de índice (n em [0, visibleCount())).
+    int nthVisible(int n) const;
+
+    bool cleared() const { return this->remaining == 0; }
+
+    // Limite da distância RGB ao quadrado para a tolerância atual.
+    float similarDistanceSquared() const { return static_cast<float>(this->tolerance * this->tolerance * 3.0); }
+
+    // Faixa de colunas [dirtyFirstColumn, dirtyLastColumn] que mudou desde o último markClean(),
+    // para quem espelha o tabuleiro (uma textura, por exemplo) atualizar só essa parte.
+    int dirtyFirstColumn = 0;
+    int dirtyLastColumn = -1;
+
+    bool dirty() const { return this->dirtyFirstColumn <= this->dirtyLastColumn; }
+
+    void markClean();
+
+private:
+    // Converte as cores para CIELAB, deixa tudo visível e refaz os índices.
+    void finishGenerate();
+
+    // Bits das células do bloco parecidas com color, visíveis ou não.
+    uint64_t similarMask(size_t block, const glm::vec3& color, const glm::vec3& lab) const;
+
+    void markDirty(int firstIndex, int lastIndex);
+
+    void hide(int index);
+
+    float labLimit() const {
+        return static_cast<float>(colorMetricTolerance(this->metric) * (this->tolerance / TOLERANCE));
+    }
+
+    // Se as células vizinhas a e b (as duas visíveis) são parecidas segundo a métrica atual.
+    bool similarCells(int a, int b) const;
+
+    // similar[i] = similarCells(first + i, first + i + offset), para i em [0, count).
+    void similarNeighbors(int first, int offset, int count, unsigned char* similar) const;
+
+    int remaining = 0;
+
+    std::vector<int> regionParent;
+    ColorMetric labeledMetric = ColorMetric::Rgb;
+    double labeledTolerance = TOLERANCE;
+    bool regionsStale = true;
+};
@@ -0,0 +1,219 @@
+#include "m3/board_compute.hpp"
+
+#include <iostream>
+#include <vector>
+
+#include "renderer/gl_state.hpp"
+#include "renderer/profiler.hpp"
+#include "renderer/shader.hpp"
+
+namespace {
+    constexpr int COMPUTE_GROUP_SIZE = 8;
+
+    // Pontos de ligação dos buffers, iguais nos dois shaders.
+    constexpr GLuint COLOR_BINDING = 0;
+    constexpr GLuint SELECTION_BINDING = 1;
+    constexpr GLuint COUNTER_BINDING = 0;
+
+    constexpr auto computeHeader = R"GLSL(
+#version 430 core
+layout (rgba8, binding = 0) uniform image2D board;
+
+layout (std430, binding = 0) readonly buffer Colors
+{
+    vec4 colors[];
+};
+
+// Cor da célula clicada e se ela ainda estava visível, escritas pelo primeiro passo.
+layout (std430, binding = 1) buffer Selection
+{
+    vec4 selectedColor;
+    uint selectedVisible;
+};
+
+uniform int rows;
+)GLSL";
+
+    // Uma invocação só: lê a célula clicada antes de qualquer uma sumir. Se o segundo passo fizesse
+    // isso, a invocação da própria célula poderia escondê-la antes das outras lerem.
+    constexpr auto selectShaderSource = R"GLSL(
+layout (local_size_x = 1) in;
+uniform ivec2 selected;
+
+void main()
+{
+    selectedColor = colors[selected.x * rows + selected.y];
+    selectedVisible = imageLoad(board, selected).a > 0.0 ? 1u : 0u;
+}
+)GLSL";
+
+    constexpr auto eliminateShaderSource = R"GLSL(
+layout (local_size_x = 8, local_size_y = 8) in;
+layout (binding = 0, offset = 0) uniform atomic_uint removed;
+uniform float limitSquared;
+
+void main()
+{
+    ivec2 cell = ivec2(gl_GlobalInvocationID.xy);
+    if (selectedVisible == 0u || any(greaterThanEqual(cell, imageSize(board)))) {
+        return;
+    }
+
+    vec4 texel = imageLoad(board, cell);
+    vec3 difference = colors[cell.x * rows + cell.y].rgb - selectedColor.rgb;
+    if (texel.a > 0.0 && dot(difference, difference) <= limitSquared) {
+        imageStore(board, cell, vec4(texel.rgb, 0.0));
+        atomicCounterIncrement(removed);
+    }
+}
+)GLSL";
+
+    bool fenceSignaled(const GLsync fence, const GLuint64 timeout) {
+        const GLenum status = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, timeout);
+        return status == GL_ALREADY_SIGNALED || status == GL_CONDITION_SATISFIED;
+    }
+}
+
+bool BoardCompute::create() {
+    if (!GLAD_GL_VERSION_4_3) {
+        std::cout << "Failed to create board compute: compute shaders need OpenGL 4.3" << std::endl;
+        return false;
+    }
+
+    this->selectProgram = createComputeProgram((std::string(computeHeader) + selectShaderSource).c_str());
+    this->eliminateProgram = createComputeProgram((std::string(computeHeader) + eliminateShaderSource).c_str());
+
+    glGenBuffers(1, &this->colorBuffer);
+
+    glGenBuffers(1, &this->selectionBuffer);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, this->selectionBuffer);
+    glBufferData(GL_SHADER_STORAGE_BUFFER, 8 * sizeof(float), nullptr, GL_DYNAMIC_COPY);
+
+    const std::vector<GLuint> zeros(COMPUTE_COUNT_SLOTS, 0);
+    glGenBuffers(1, &this->counterBuffer);
+    glBindBuffer(GL_ATOMIC_COUNTER_BUFFER, this->counterBuffer);
+    glBufferData(GL_ATOMIC_COUNTER_BUFFER, COMPUTE_COUNT_SLOTS * sizeof(GLuint), zeros.data(), GL_DYNAMIC_COPY);
+
+    glGenBuffers(1, &this->readbackBuffer);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, this->readbackBuffer);
+    glBufferData(GL_COPY_WRITE_BUFFER, COMPUTE_COUNT_SLOTS * sizeof(GLuint), nullptr, GL_STREAM_READ);
+
+    return true;
+}
+
+void BoardCompute::destroy() {
+    discardPending();
+
+    deleteProgram(this->selectProgram);
+    deleteProgram(this->eliminateProgram);
+    for (GLuint* buffer : {&this->colorBuffer, &this->selectionBuffer, &this->counterBuffer, &this->readbackBuffer}) {
+        glDeleteBuffers(1, buffer);
+        *buffer = 0;
+    }
+
+    this->selectProgram = 0;
+    this->eliminateProgram = 0;
+}
+
+void BoardCompute::upload(const Board& board) {
+    PROFILE_ZONE("board compute upload");
+
+    discardPending();
+    this->columns = board.columns;
+    this->rows = board.rows;
+
+    std::vector<float> colors(static_cast<size_t>(board.cells()) * 4);
+    for (int i = 0; i < board.cells(); i++) {
+        colors[i * 4] = board.red[i];
+        colors[i * 4 + 1] = board.green[i];
+        colors[i * 4 + 2] = board.blue[i];
+        colors[i * 4 + 3] = 1.0f;
+    }
+
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, this->colorBuffer);
+    glBufferData(GL_SHADER_STORAGE_BUFFER, static_cast<GLsizeiptr>(colors.size() * sizeof(float)), colors.data(),
+                 GL_STATIC_DRAW);
+}
+
+void BoardCompute::eliminate(const GLuint boardTexture, const int index, const float limitSquared) {
+    PROFILE_ZONE("board compute eliminate");
+
+    // Com todos os espaços ocupados espera o mais antigo, guardando a contagem para o poll().
+    if (this->inFlight.size() == COMPUTE_COUNT_SLOTS) {
+        const PendingCount oldest = this->inFlight.front();
+        while (!fenceSignaled(oldest.fence, 1000000)) {
+        }
+        this->ready.push_back(readCount(oldest));
+        this->inFlight.pop_front();
+    }
+
+    const int slot = this->nextSlot;
+    this->nextSlot = (this->nextSlot + 1) % COMPUTE_COUNT_SLOTS;
+
+    const GLuint zero = 0;
+    glBindBuffer(GL_ATOMIC_COUNTER_BUFFER, this->counterBuffer);
+    glBufferSubData(GL_ATOMIC_COUNTER_BUFFER, slot * sizeof(GLuint), sizeof(GLuint), &zero);
+    glBindBufferRange(GL_ATOMIC_COUNTER_BUFFER, COUNTER_BINDING, this->counterBuffer, slot * sizeof(GLuint),
+                      sizeof(GLuint));
+
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, COLOR_BINDING, this->colorBuffer);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, SELECTION_BINDING, this->selectionBuffer);
+    glBindImageTexture(0, boardTexture, 0, GL_FALSE, 0, GL_READ_WRITE, GL_RGBA8);
+
+    useProgram(this->selectProgram);
+    glUniform1i(glGetUniformLocation(this->selectProgram, "rows"), this->rows);
+    glUniform2i(glGetUniformLocation(this->selectProgram, "selected"), index / this->rows, index % this->rows);
+    glDispatchCompute(1, 1, 1);
+    glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+
+    useProgram(this->eliminateProgram);
+    glUniform1i(glGetUniformLocation(this->eliminateProgram, "rows"), this->rows);
+    glUniform1f(glGetUniformLocation(this->eliminateProgram, "limitSquared"), limitSquared);
+    glDispatchCompute((this->columns + COMPUTE_GROUP_SIZE - 1) / COMPUTE_GROUP_SIZE,
+                      (this->rows + COMPUTE_GROUP_SIZE - 1) / COMPUTE_GROUP_SIZE, 1);
+
+    // O próximo clique lê a imagem e a seleção, o desenho amostra a textura, o BoardRenderer pode
+    // reenviá-la e a contagem é copiada a seguir.
+    glMemoryBarrier(GL_SHADER_IMAGE_ACCESS_BARRIER_BIT | GL_SHADER_STORAGE_BARRIER_BIT
+                    | GL_TEXTURE_FETCH_BARRIER_BIT | GL_TEXTURE_UPDATE_BARRIER_BIT
+                    | GL_ATOMIC_COUNTER_BARRIER_BIT | GL_BUFFER_UPDATE_BARRIER_BIT);
+
+    glBindBuffer(GL_COPY_READ_BUFFER, this->counterBuffer);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, this->readbackBuffer);
+    glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, slot * sizeof(GLuint), slot * sizeof(GLuint),
+                        sizeof(GLuint));
+
+    this->inFlight.push_back(PendingCount{slot, glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0)});
+}
+
+bool BoardCompute::poll(int& removed) {
+    if (!this->ready.empty()) {
+        removed = this->ready.front();
+        this->ready.pop_front();
+        return true;
+    }
+
+    if (this->inFlight.empty() || !fenceSignaled(this->inFlight.front().fence, 0)) {
+        return false;
+    }
+
+    removed = readCount(this->inFlight.front());
+    this->inFlight.pop_front();
+    return true;
+}
+
+int BoardCompute::readCount(const PendingCount& pending) {
+    GLuint count = 0;
+    glBindBuffer(GL_COPY_READ_BUFFER, this->readbackBuffer);
+    glGetBufferSubData(GL_COPY_READ_BUFFER, pending.slot * sizeof(GLuint), sizeof(GLuint), &count);
+    glDeleteSync(pending.fence);
+    return static_cast<int>(count);
+}
+
+void BoardCompute::discardPending() {
+    for (const PendingCount& pending : this->inFlight) {
+        glDeleteSync(pending.fence);
+    }
+    this->inFlight.clear();
+    this->ready.clear();
+}
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <glad.h>
+
+#include <deque>
+
+#include "glm/vec3.hpp"
+#include "m3/board.hpp"
+
+// Quantas eliminações podem estar esperando a contagem voltar da GPU ao mesmo tempo.
+constexpr int COMPUTE_COUNT_SLOTS = 8;
+
+// Eliminação em RGB feita por um compute shader (GL 4.3) direto na textura do BoardRenderer: cada
+// invocação compara uma célula com a cor escolhida e zera o alpha (a visibilidade) das que somem,
+// contando-as em um atomic counter. As cores ficam em float em um shader storage buffer, enviado
+// uma vez por tabuleiro, então um clique não manda nem lê nada do tamanho do tabuleiro.
+//
+// A contagem é a única coisa que volta: ela é copiada para um buffer de leitura e marcada com um
+// fence, e poll() só a lê depois que a GPU terminou, sem travar o frame. Cada eliminação usa um
+// dos COMPUTE_COUNT_SLOTS espaços dos buffers, para vários cliques seguidos não esperarem uns aos outros.
+//
+// Clicar em uma célula que já sumiu não elimina nada e a contagem volta 0, como em Board::eliminate().
+class BoardCompute {
+public:
+    // false se o contexto não tem compute shaders.
+    bool create();
+
+    void destroy();
+
+    // Envia as cores do tabuleiro; chamar depois de cada Board::generate(). Descarta as contagens pendentes.
+    void upload(const Board& board);
+
+    // Elimina a partir de index na textura boardTexture (RGBA8, columns x rows, alpha = visível).
+    void eliminate(GLuint boardTexture, int index, float limitSquared);
+
+    // Se a contagem mais antiga já voltou, tira ela da fila e devolve true.
+    bool poll(int& removed);
+
+    bool pending() const { return !this->inFlight.empty() || !this->ready.empty(); }
+
+private:
+    struct PendingCount {
+        int slot = 0;
+        GLsync fence = nullptr;
+    };
+
+    // Só depois do fence sinalizado.
+    int readCount(const PendingCount& pending);
+
+    void discardPending();
+
+    GLuint selectProgram = 0;
+    GLuint eliminateProgram = 0;
+    GLuint colorBuffer = 0;
+    GLuint selectionBuffer = 0;
+    GLuint counterBuffer = 0;
+    GLuint readbackBuffer = 0;
+
+    int columns = 0;
+    int rows = 0;
+    int nextSlot = 0;
+
+    std::deque<PendingCount> inFlight;
+    // Contagens que já voltaram mas ainda não foram entregues por poll().
+    std::deque<int> ready;
+};
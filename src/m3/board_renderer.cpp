@@ -0,0 +1,244 @@
+#include "m3/board_renderer.hpp"
+
+#include <algorithm>
+#include <iostream>
+
+#include "glm/ext/matrix_clip_space.hpp"
+#include "renderer/gl_state.hpp"
+#include "renderer/profiler.hpp"
+#include "renderer/shader.hpp"
+
+namespace {
+    // O quad sai de gl_VertexID, sem vertex buffer. A linha 0 do tabuleiro fica no topo da tela.
+    constexpr auto vertexShaderSource = R"GLSL(
+#version 330 core
+out vec2 boardCoordinates;
+
+void main()
+{
+    vec2 corner = vec2(gl_VertexID & 1, gl_VertexID >> 1);
+    boardCoordinates = vec2(corner.x, 1.0 - corner.y);
+    gl_Position = vec4(corner * 2.0 - 1.0, 0.0, 1.0);
+}
+)GLSL";
+
+    constexpr auto fragmentShaderSource = R"GLSL(
+#version 330 core
+in vec2 boardCoordinates;
+out vec4 FragColor;
+uniform sampler2D board;
+uniform sampler2D preview;
+uniform vec3 clearColor;
+
+void main()
+{
+    vec4 cell = texture(board, boardCoordinates);
+    vec3 color = mix(cell.rgb, vec3(1.0), 0.5 * texture(preview, boardCoordinates).r);
+    FragColor = vec4(mix(clearColor, color, cell.a), 1.0);
+}
+)GLSL";
+
+    unsigned char toByte(const float value) {
+        const float clamped = value < 0.0f ? 0.0f : value > 1.0f ? 1.0f : value;
+        return static_cast<unsigned char>(clamped * 255.0f + 0.5f);
+    }
+}
+
+void BoardRenderer::create(const Board& board, const glm::vec3& clearColor) {
+    this->program = createShaderProgram(vertexShaderSource, fragmentShaderSource);
+    useProgram(this->program);
+    glUniform1i(glGetUniformLocation(this->program, "board"), 0);
+    glUniform1i(glGetUniformLocation(this->program, "preview"), 1);
+    glUniform3f(glGetUniformLocation(this->program, "clearColor"), clearColor.r, clearColor.g, clearColor.b);
+
+    // O core profile não desenha sem um VAO ligado, mesmo sem atributos.
+    glGenVertexArrays(1, &this->VAO);
+
+    allocate(board.columns, board.rows);
+}
+
+void BoardRenderer::destroy() {
+    deleteTexture(this->texture);
+    deleteTexture(this->previewTexture);
+    deleteVertexArray(this->VAO);
+    deleteProgram(this->program);
+
+    this->texture = 0;
+    this->previewTexture = 0;
+    this->VAO = 0;
+    this->program = 0;
+}
+
+void BoardRenderer::allocate(const int columns, const int rows) {
+    this->columns = columns;
+    this->rows = rows;
+
+    GLint maxSize = 0;
+    glGetIntegerv(GL_MAX_TEXTURE_SIZE, &maxSize);
+    if (columns > maxSize || rows > maxSize) {
+        std::cout << "Failed to create board texture: " << columns << "x" << rows
+                  << " is larger than GL_MAX_TEXTURE_SIZE (" << maxSize << ")" << std::endl;
+    }
+
+    for (GLuint* texture : {&this->texture, &this->previewTexture}) {
+        if (*texture == 0) {
+            glGenTextures(1, texture);
+        }
+        bindTexture(GL_TEXTURE_2D, *texture);
+
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    }
+
+    bindTexture(GL_TEXTURE_2D, this->texture);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, columns, rows, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+
+    this->previewMask.assign(static_cast<size_t>(columns) * rows, 0);
+    this->previewCells.clear();
+    this->staging.assign(this->previewMask.size(), 0);
+
+    // Linhas de um byte por texel não são múltiplas de 4 em geral.
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    bindTexture(GL_TEXTURE_2D, this->previewTexture);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_R8, columns, rows, 0, GL_RED, GL_UNSIGNED_BYTE, this->staging.data());
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+
+    this->damagedFirstColumn = 0;
+    this->damagedLastColumn = columns - 1;
+}
+
+void BoardRenderer::update(Board& board) {
+    if (board.columns != this->columns || board.rows != this->rows) {
+        allocate(board.columns, board.rows);
+    }
+
+    if (!board.dirty()) {
+        return;
+    }
+
+    PROFILE_ZONE("board texture upload");
+
+    const int first = board.dirtyFirstColumn;
+    const int width = board.dirtyLastColumn - first + 1;
+
+    // O Board guarda coluna por coluna e a textura é linha por linha: transpõe só a faixa suja.
+    this->staging.resize(static_cast<size_t>(width) * this->rows * 4);
+    for (int y = 0; y < this->rows; y++) {
+        unsigned char* texel = &this->staging[static_cast<size_t>(y) * width * 4];
+
+        for (int x = first; x < first + width; x++) {
+            const int cell = board.index(x, y);
+            texel[0] = toByte(board.red[cell]);
+            texel[1] = toByte(board.green[cell]);
+            texel[2] = toByte(board.blue[cell]);
+            texel[3] = board.visible(cell) ? 255 : 0;
+            texel += 4;
+        }
+    }
+
+    bindTexture(GL_TEXTURE_2D, this->texture);
+    glTexSubImage2D(GL_TEXTURE_2D, 0, first, 0, width, this->rows, GL_RGBA, GL_UNSIGNED_BYTE, this->staging.data());
+
+    damageColumns(first, first + width - 1);
+    board.markClean();
+}
+
+void BoardRenderer::setPreview(const Board& board, const std::vector<int>& cells) {
+    if (board.columns != this->columns || board.rows != this->rows) {
+        allocate(board.columns, board.rows);
+    }
+
+    if (cells == this->previewCells) {
+        return;
+    }
+
+    PROFILE_ZONE("board preview upload");
+
+    int first = this->columns;
+    int last = -1;
+
+    for (const int cell : this->previewCells) {
+        this->previewMask[cell] = 0;
+        first = std::min(first, cell / this->rows);
+        last = std::max(last, cell / this->rows);
+    }
+
+    for (const int cell : cells) {
+        this->previewMask[cell] = 255;
+        first = std::min(first, cell / this->rows);
+        last = std::max(last, cell / this->rows);
+    }
+
+    this->previewCells = cells;
+
+    if (first <= last) {
+        uploadPreviewColumns(first, last);
+        damageColumns(first, last);
+    }
+}
+
+void BoardRenderer::damageColumns(const int first, const int last) {
+    if (!damaged()) {
+        this->damagedFirstColumn = first;
+        this->damagedLastColumn = last;
+        return;
+    }
+
+    this->damagedFirstColumn = std::min(this->damagedFirstColumn, first);
+    this->damagedLastColumn = std::max(this->damagedLastColumn, last);
+}
+
+void BoardRenderer::clearDamage() {
+    this->damagedFirstColumn = 0;
+    this->damagedLastColumn = -1;
+}
+
+void BoardRenderer::uploadPreviewColumns(const int first, const int last) {
+    const int width = last - first + 1;
+
+    this->staging.resize(static_cast<size_t>(width) * this->rows);
+    for (int y = 0; y < this->rows; y++) {
+        unsigned char* texel = &this->staging[static_cast<size_t>(y) * width];
+
+        for (int x = first; x <= last; x++) {
+            *texel++ = this->previewMask[static_cast<size_t>(x) * this->rows + y];
+        }
+    }
+
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    bindTexture(GL_TEXTURE_2D, this->previewTexture);
+    glTexSubImage2D(GL_TEXTURE_2D, 0, first, 0, width, this->rows, GL_RED, GL_UNSIGNED_BYTE, this->staging.data());
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+}
+
+void BoardRenderer::draw() const {
+    useProgram(this->program);
+    bindTexture(GL_TEXTURE_2D, this->texture);
+    bindTexture(GL_TEXTURE_2D, this->previewTexture, 1);
+    bindVertexArray(this->VAO);
+    drawArrays(GL_TRIANGLE_STRIP, 0, 4);
+}
+
+void BoardRenderer::drawSoftware(SoftwareRasterizer& software, const Board& board) const {
+    PROFILE_ZONE("board software draw");
+
+    software.setProjection(glm::ortho(0.0f, (float) board.columns, (float) board.rows, 0.0f, -1.0f, 1.0f));
+
+    for (int x = 0; x < board.columns; x++) {
+        for (int y = 0; y < board.rows; y++) {
+            const int cell = board.index(x, y);
+            if (!board.visible(cell)) {
+                continue;
+            }
+
+            glm::vec3 color = glm::vec3(board.red[cell], board.green[cell], board.blue[cell]);
+            if (this->previewMask[cell] != 0) {
+                color = glm::mix(color, glm::vec3(1.0f), 0.5f);
+            }
+            software.drawRect(glm::vec2(x, y), glm::vec2(x + 1, y + 1), glm::vec4(color, 1.0f));
+        }
+    }
+}
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <glad.h>
+
+#include <vector>
+
+#include "glm/vec3.hpp"
+#include "m3/board.hpp"
+#include "renderer/software_rasterizer.hpp"
+
+// Desenha o tabuleiro inteiro com um único quad de tela cheia. Cada célula é um texel RGBA8 de
+// uma textura columns x rows: rgb é a cor e alpha diz se a célula ainda está visível. O fragment
+// shader amostra com GL_NEAREST, então o custo de desenhar não depende do tamanho do tabuleiro.
+//
+// Depois de uma eliminação só as colunas que o Board marcou como sujas são reenviadas, com
+// glTexSubImage2D. Uma segunda textura R8 do mesmo tamanho marca as células da prévia, que são
+// clareadas no desenho.
+class BoardRenderer {
+public:
+    void create(const Board& board, const glm::vec3& clearColor);
+
+    void destroy();
+
+    // Envia as colunas sujas do tabuleiro e limpa a marcação. Refaz a textura se o tamanho mudou.
+    void update(Board& board);
+
+    // Troca as células destacadas. Só reenvia as colunas entre as células antigas e as novas.
+    void setPreview(const Board& board, const std::vector<int>& cells);
+
+    void draw() const;
+
+    // Mesmo resultado do draw() no SoftwareRasterizer: um retângulo por célula visível. Troca a
+    // projeção dele para coordenadas de célula.
+    void drawSoftware(SoftwareRasterizer& software, const Board& board) const;
+
+    // Textura columns x rows do tabuleiro (RGBA8, alpha = visível), para quem a altera na GPU.
+    GLuint boardTexture() const { return this->texture; }
+
+    // Faixa de colunas [damagedFirstColumn, damagedLastColumn] que mudou na tela desde o último
+    // clearDamage(): reenviadas pelo update() ou com a prévia trocada.
+    int damagedFirstColumn = 0;
+    int damagedLastColumn = -1;
+
+    bool damaged() const { return this->damagedFirstColumn <= this->damagedLastColumn; }
+
+    void clearDamage();
+
+private:
+    void allocate(int columns, int rows);
+
+    void uploadPreviewColumns(int first, int last);
+
+    void damageColumns(int first, int last);
+
+    GLuint program = 0;
+    GLuint VAO = 0;
+    GLuint texture = 0;
+    GLuint previewTexture = 0;
+
+    int columns = 0;
+    int rows = 0;
+
+    std::vector<unsigned char> staging;
+
+    // Uma entrada por célula, na ordem de índices do Board (coluna por coluna).
+    std::vector<unsigned char> previewMask;
+    std::vector<int> previewCells;
+};
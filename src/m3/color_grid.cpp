@@ -0,0 +1,34 @@
+#include "m3/color_grid.hpp"
+
+#include <algorithm>
+
+static_assert(COLOR_GRID_SIZE * COLOR_GRID_SIZE * COLOR_GRID_SIZE <= 65536, "bucketOf guarda caixas em 16 bits");
+
+int ColorGrid::bucketCoordinate(const float value) {
+    return std::clamp(static_cast<int>(value * COLOR_GRID_SIZE), 0, COLOR_GRID_SIZE - 1);
+}
+
+void ColorGrid::build(const float* red, const float* green, const float* blue, const int count) {
+    constexpr int BUCKETS = COLOR_GRID_SIZE * COLOR_GRID_SIZE * COLOR_GRID_SIZE;
+
+    this->bucketOf.resize(count);
+    this->visibleInBucket.assign(BUCKETS, 0);
+
+    for (int i = 0; i < count; i++) {
+        const int bucket = (bucketCoordinate(red[i]) * COLOR_GRID_SIZE + bucketCoordinate(green[i]))
+                           * COLOR_GRID_SIZE + bucketCoordinate(blue[i]);
+        this->bucketOf[i] = static_cast<uint16_t>(bucket);
+        this->visibleInBucket[bucket]++;
+    }
+
+    this->bucketStart.assign(BUCKETS + 1, 0);
+    for (int bucket = 0; bucket < BUCKETS; bucket++) {
+        this->bucketStart[bucket + 1] = this->bucketStart[bucket] + this->visibleInBucket[bucket];
+    }
+
+    std::vector<int> next(this->bucketStart.begin(), this->bucketStart.end() - 1);
+    this->cells.resize(count);
+    for (int i = 0; i < count; i++) {
+        this->cells[next[this->bucketOf[i]]++] = i;
+    }
+}
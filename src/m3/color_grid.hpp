@@ -0,0 +1,85 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "glm/vec3.hpp"
+
+// Quantas divisões por eixo o cubo RGB tem na ColorGrid.
+constexpr int COLOR_GRID_SIZE = 16;
+
+// Índice espacial das cores do tabuleiro: o cubo RGB [0, 1]³ é dividido em COLOR_GRID_SIZE³ caixas
+// e cada célula fica na caixa da sua cor. Uma busca por raio só olha as caixas que encostam na
+// esfera; as que ficam inteiras dentro dela entram sem testar célula por célula.
+//
+// As células de cada caixa ficam contíguas em `cells` (ordenação por contagem), com a caixa b em
+// [bucketStart[b], bucketStart[b + 1]). A grade não sabe quem está visível: ela só guarda quantas
+// células visíveis cada caixa ainda tem, para pular as que esvaziaram.
+class ColorGrid {
+public:
+    std::vector<int> bucketStart;
+    std::vector<int> cells;
+    std::vector<int> visibleInBucket;
+
+    // Reconstrói a grade para count cores, todas visíveis.
+    void build(const float* red, const float* green, const float* blue, int count);
+
+    // Avisa que a célula index deixou de ser visível.
+    void remove(int index) { this->visibleInBucket[this->bucketOf[index]]--; }
+
+    // Chama visit(bucket, inside) para cada caixa com células visíveis que pode ter cores a no
+    // máximo sqrt(radiusSquared) de color. inside diz se a caixa inteira está dentro do raio.
+    template <typename Visit>
+    void query(const glm::vec3& color, float radiusSquared, Visit visit) const;
+
+private:
+    static int bucketCoordinate(float value);
+
+    std::vector<uint16_t> bucketOf;
+};
+
+template <typename Visit>
+void ColorGrid::query(const glm::vec3& color, const float radiusSquared, Visit visit) const {
+    constexpr float BUCKET_SIZE = 1.0f / COLOR_GRID_SIZE;
+
+    // Margem para a caixa "inteira dentro" não aceitar uma cor que o teste exato recusaria por arredondamento.
+    const float insideLimit = radiusSquared * 0.999f;
+
+    for (int r = 0; r < COLOR_GRID_SIZE; r++) {
+        const float r0 = r * BUCKET_SIZE - color.r;
+        const float r1 = r0 + BUCKET_SIZE;
+        const float nearR = r0 > 0.0f ? r0 : r1 < 0.0f ? r1 : 0.0f;
+        const float farR = -r0 > r1 ? -r0 : r1;
+        if (nearR * nearR > radiusSquared) {
+            continue;
+        }
+
+        for (int g = 0; g < COLOR_GRID_SIZE; g++) {
+            const float g0 = g * BUCKET_SIZE - color.g;
+            const float g1 = g0 + BUCKET_SIZE;
+            const float nearG = g0 > 0.0f ? g0 : g1 < 0.0f ? g1 : 0.0f;
+            const float farG = -g0 > g1 ? -g0 : g1;
+            const float nearRG = nearR * nearR + nearG * nearG;
+            if (nearRG > radiusSquared) {
+                continue;
+            }
+
+            for (int b = 0; b < COLOR_GRID_SIZE; b++) {
+                const float b0 = b * BUCKET_SIZE - color.b;
+                const float b1 = b0 + BUCKET_SIZE;
+                const float nearB = b0 > 0.0f ? b0 : b1 < 0.0f ? b1 : 0.0f;
+                if (nearRG + nearB * nearB > radiusSquared) {
+                    continue;
+                }
+
+                const int bucket = (r * COLOR_GRID_SIZE + g) * COLOR_GRID_SIZE + b;
+                if (this->visibleInBucket[bucket] == 0) {
+                    continue;
+                }
+
+                const float farB = -b0 > b1 ? -b0 : b1;
+                visit(bucket, farR * farR + farG * farG + farB * farB <= insideLimit);
+            }
+        }
+    }
+}
@@ -0,0 +1,473 @@
+#include "m3/color_metric.hpp"
+
+#include <cmath>
+
+#include "m3/board.hpp"
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define COLOR_METRIC_USE_SSE2
+#endif
+
+namespace {
+    constexpr float PI = 3.14159265358979f;
+
+    float degrees(const float radians) {
+        return radians * 180.0f / PI;
+    }
+
+    float radians(const float degrees) {
+        return degrees * PI / 180.0f;
+    }
+
+    // Maior valor de S_L no CIEDE2000, com L médio em 0 ou 100: 1 + 0.015 * 2500 / sqrt(2520).
+    constexpr float DELTA_E2000_MAX_SL = 1.7471f;
+
+    float linearize(const float channel) {
+        return channel <= 0.04045f ? channel / 12.92f : std::pow((channel + 0.055f) / 1.055f, 2.4f);
+    }
+
+    float labCurve(const float t) {
+        return t > 0.008856f ? std::cbrt(t) : 7.787f * t + 16.0f / 116.0f;
+    }
+
+    // Pesos do ΔE94 que só dependem da cor de referência, elevados ao quadrado e invertidos.
+    struct DeltaE94Weights {
+        float chroma;
+        float inverseChromaWeight;
+        float inverseHueWeight;
+    };
+
+    DeltaE94Weights deltaE94Weights(const glm::vec3& reference) {
+        const float chroma = std::sqrt(reference.y * reference.y + reference.z * reference.z);
+        const float chromaWeight = 1.0f + 0.045f * chroma;
+        const float hueWeight = 1.0f + 0.015f * chroma;
+
+        return {chroma, 1.0f / (chromaWeight * chromaWeight), 1.0f / (hueWeight * hueWeight)};
+    }
+
+    float deltaE94Squared(const DeltaE94Weights& weights, const glm::vec3& reference, const float lightness,
+                          const float a, const float b, const float chroma) {
+        const float dL = reference.x - lightness;
+        const float da = reference.y - a;
+        const float db = reference.z - b;
+        const float dC = weights.chroma - chroma;
+        const float dH = std::fmax(da * da + db * db - dC * dC, 0.0f);
+
+        return dL * dL + dC * dC * weights.inverseChromaWeight + dH * weights.inverseHueWeight;
+    }
+}
+
+const char* colorMetricName(const ColorMetric metric) {
+    switch (metric) {
+        case ColorMetric::Rgb:
+            return "RGB";
+        case ColorMetric::DeltaE76:
+            return "CIE76";
+        case ColorMetric::DeltaE94:
+            return "CIE94";
+        case ColorMetric::DeltaE2000:
+            return "CIEDE2000";
+    }
+    return "";
+}
+
+float colorMetricTolerance(const ColorMetric metric) {
+    switch (metric) {
+        case ColorMetric::DeltaE76:
+            return DELTA_E76_TOLERANCE;
+        case ColorMetric::DeltaE94:
+            return DELTA_E94_TOLERANCE;
+        case ColorMetric::DeltaE2000:
+            return DELTA_E2000_TOLERANCE;
+        default:
+            return static_cast<float>(TOLERANCE);
+    }
+}
+
+ColorMetric nextColorMetric(const ColorMetric metric) {
+    return static_cast<ColorMetric>((static_cast<int>(metric) + 1) % COLOR_METRIC_COUNT);
+}
+
+glm::vec3 rgbToLab(const glm::vec3& rgb) {
+    const float r = linearize(rgb.r);
+    const float g = linearize(rgb.g);
+    const float b = linearize(rgb.b);
+
+    // sRGB linear para XYZ, já dividido pelo branco D65.
+    const float x = (0.4124564f * r + 0.3575761f * g + 0.1804375f * b) / 0.95047f;
+    const float y = 0.2126729f * r + 0.7151522f * g + 0.0721750f * b;
+    const float z = (0.0193339f * r + 0.1191920f * g + 0.9503041f * b) / 1.08883f;
+
+    const float fx = labCurve(x);
+    const float fy = labCurve(y);
+    const float fz = labCurve(z);
+
+    return {116.0f * fy - 16.0f, 500.0f * (fx - fy), 200.0f * (fy - fz)};
+}
+
+float deltaE76(const glm::vec3& reference, const glm::vec3& sample) {
+    const glm::vec3 d = reference - sample;
+    return std::sqrt(d.x * d.x + d.y * d.y + d.z * d.z);
+}
+
+float deltaE94(const glm::vec3& reference, const glm::vec3& sample) {
+    const float chroma = std::sqrt(sample.y * sample.y + sample.z * sample.z);
+    return std::sqrt(deltaE94Squared(deltaE94Weights(reference), reference, sample.x, sample.y, sample.z, chroma));
+}
+
+namespace {
+    // Segue Sharma, Wu e Dalal, "The CIEDE2000 Color-Difference Formula" (2005), com kL = kC = kH = 1.
+    // Os ângulos de matiz são trocados por vetores (a', b) normalizados sempre que possível: ΔH' sai de
+    // C1'C2' - a1'a2' - b1b2, o matiz médio é a bissetriz dos dois vetores (ou a perpendicular, se eles
+    // são opostos) e os cossenos de T saem das fórmulas de arco duplo e triplo.
+    //
+    // ΔE00² = l² + c² + h² + R_T c h. Só R_T precisa de atan2, exp e sin, e |R_T| <= R_C, então
+    // deltaE2000Terms para antes dele; quem só quer comparar com um limite muitas vezes nem precisa dele.
+    struct DeltaE2000Terms {
+        float l;
+        float c;
+        float h;
+        float rC;
+        float hueX;
+        float hueY;
+    };
+
+    DeltaE2000Terms deltaE2000Terms(const glm::vec3& reference, const float lightness, const float a, const float b,
+                                    const float chroma) {
+        constexpr float POW_25_7 = 6103515625.0f;
+
+        const float c1 = std::sqrt(reference.y * reference.y + reference.z * reference.z);
+        const float meanC = (c1 + chroma) / 2.0f;
+        const float meanC7 = meanC * meanC * meanC * meanC * meanC * meanC * meanC;
+        const float g = 0.5f * (1.0f - std::sqrt(meanC7 / (meanC7 + POW_25_7)));
+
+        const float a1 = (1.0f + g) * reference.y;
+        const float a2 = (1.0f + g) * a;
+        const float b1 = reference.z;
+        const float b2 = b;
+
+        const float chroma1 = std::sqrt(a1 * a1 + b1 * b1);
+        const float chroma2 = std::sqrt(a2 * a2 + b2 * b2);
+
+        const float dL = lightness - reference.x;
+        const float dC = chroma2 - chroma1;
+
+        // ΔH'² = 2 (C1'C2' - a1'a2' - b1b2); o sinal é o de sin(h2 - h1).
+        const float dH2 = std::fmax(2.0f * (chroma1 * chroma2 - a1 * a2 - b1 * b2), 0.0f);
+        const float dH = a1 * b2 - b1 * a2 < 0.0f ? -std::sqrt(dH2) : std::sqrt(dH2);
+
+        const float meanL = (reference.x + lightness) / 2.0f;
+        const float meanChroma = (chroma1 + chroma2) / 2.0f;
+
+        // Matiz médio como vetor unitário. Com uma croma zero ele é o matiz da outra cor.
+        float hueX = (chroma1 > 0.0f ? a1 / chroma1 : 0.0f) + (chroma2 > 0.0f ? a2 / chroma2 : 0.0f);
+        float hueY = (chroma1 > 0.0f ? b1 / chroma1 : 0.0f) + (chroma2 > 0.0f ? b2 / chroma2 : 0.0f);
+        const float hueLength = std::sqrt(hueX * hueX + hueY * hueY);
+        if (hueLength > 1e-6f) {
+            hueX /= hueLength;
+            hueY /= hueLength;
+        } else if (chroma1 > 0.0f && chroma2 > 0.0f) {
+            // Matizes opostos não têm bissetriz. Com |h1' - h2'| = 180° a fórmula dá (h1' + h2') / 2, 90°
+            // depois do menor dos dois: o que tem b > 0 (ou b = 0 e a' > 0).
+            const float sign = b1 > 0.0f || (b1 == 0.0f && a1 > 0.0f) ? 1.0f : -1.0f;
+            hueX = -sign * b1 / chroma1;
+            hueY = sign * a1 / chroma1;
+        } else {
+            // As duas cromas zero: fica o matiz zero.
+            hueX = 1.0f;
+            hueY = 0.0f;
+        }
+
+        const float cos1 = hueX;
+        const float sin1 = hueY;
+        const float cos2 = cos1 * cos1 - sin1 * sin1;
+        const float sin2 = 2.0f * sin1 * cos1;
+        const float cos3 = cos2 * cos1 - sin2 * sin1;
+        const float sin3 = sin2 * cos1 + cos2 * sin1;
+        const float cos4 = cos2 * cos2 - sin2 * sin2;
+        const float sin4 = 2.0f * sin2 * cos2;
+
+        // cos(h - 30°), cos(2h), cos(3h + 6°) e cos(4h - 63°) pelas fórmulas de soma de arcos.
+        const float t = 1.0f
+                        - 0.17f * (cos1 * 0.8660254f + sin1 * 0.5f)
+                        + 0.24f * cos2
+                        + 0.32f * (cos3 * 0.9945219f - sin3 * 0.1045285f)
+                        - 0.20f * (cos4 * 0.4539905f + sin4 * 0.8910065f);
+
+        const float meanL50 = (meanL - 50.0f) * (meanL - 50.0f);
+        const float sL = 1.0f + 0.015f * meanL50 / std::sqrt(20.0f + meanL50);
+        const float sC = 1.0f + 0.045f * meanChroma;
+        const float sH = 1.0f + 0.015f * meanChroma * t;
+
+        const float meanChroma7 = meanChroma * meanChroma * meanChroma * meanChroma * meanChroma * meanChroma * meanChroma;
+        const float rC = 2.0f * std::sqrt(meanChroma7 / (meanChroma7 + POW_25_7));
+
+        return {dL / sL, dC / sC, dH / sH, rC, hueX, hueY};
+    }
+
+    float deltaE2000Rotation(const DeltaE2000Terms& terms) {
+        float meanH = degrees(std::atan2(terms.hueY, terms.hueX));
+        if (meanH < 0.0f) {
+            meanH += 360.0f;
+        }
+        const float hueOffset = (meanH - 275.0f) / 25.0f;
+        const float dTheta = 30.0f * std::exp(-hueOffset * hueOffset);
+
+        return -terms.rC * std::sin(radians(2.0f * dTheta));
+    }
+
+    bool deltaE2000Within(const glm::vec3& reference, const float lightness, const float a, const float b,
+                          const float chroma, const float limitSquared) {
+        const DeltaE2000Terms terms = deltaE2000Terms(reference, lightness, a, b, chroma);
+        const float base = terms.l * terms.l + terms.c * terms.c + terms.h * terms.h;
+        const float rotationBound = terms.rC * std::fabs(terms.c * terms.h);
+
+        if (base - rotationBound > limitSquared) {
+            return false;
+        }
+        if (base + rotationBound <= limitSquared) {
+            return true;
+        }
+        return base + deltaE2000Rotation(terms) * terms.c * terms.h <= limitSquared;
+    }
+}
+
+float deltaE2000(const glm::vec3& reference, const glm::vec3& sample) {
+    const float chroma = std::sqrt(sample.y * sample.y + sample.z * sample.z);
+    const DeltaE2000Terms terms = deltaE2000Terms(reference, sample.x, sample.y, sample.z, chroma);
+    const float squared = terms.l * terms.l + terms.c * terms.c + terms.h * terms.h
+                          + deltaE2000Rotation(terms) * terms.c * terms.h;
+
+    return std::sqrt(std::fmax(squared, 0.0f));
+}
+
+bool similarLab(const ColorMetric metric, const glm::vec3& reference, const glm::vec3& sample, const float limit) {
+
+    if (metric == ColorMetric::DeltaE76) {
+        const float dL = reference.x - sample.x;
+        const float da = reference.y - sample.y;
+        const float db = reference.z - sample.z;
+        return dL * dL + (da * da + db * db) <= limit * limit;
+    }
+
+    const float chroma = std::sqrt(sample.y * sample.y + sample.z * sample.z);
+    if (metric == ColorMetric::DeltaE94) {
+        return deltaE94Squared(deltaE94Weights(reference), reference, sample.x, sample.y, sample.z, chroma)
+               <= limit * limit;
+    }
+
+    return deltaE2000Within(reference, sample.x, sample.y, sample.z, chroma, limit * limit);
+}
+
+uint64_t similarLabMaskScalar(const ColorMetric metric, const LabBlock& block, const glm::vec3& reference,
+                              const float limit) {
+    const DeltaE94Weights weights = deltaE94Weights(reference);
+
+    uint64_t mask = 0;
+    for (int i = 0; i < BOARD_BLOCK; i++) {
+        bool similar;
+        if (metric == ColorMetric::DeltaE76) {
+            const float dL = reference.x - block.lightness[i];
+            const float da = reference.y - block.a[i];
+            const float db = reference.z - block.b[i];
+            similar = dL * dL + (da * da + db * db) <= limit * limit;
+        } else if (metric == ColorMetric::DeltaE94) {
+            similar = deltaE94Squared(weights, reference, block.lightness[i], block.a[i], block.b[i], block.chroma[i])
+                      <= limit * limit;
+        } else {
+            // S_L nunca passa de DELTA_E2000_MAX_SL e o termo de rotação não deixa a soma cair abaixo
+            // de (ΔL/S_L)², então uma diferença de luminosidade grande já basta para recusar.
+            const float dL = reference.x - block.lightness[i];
+            similar = dL * dL <= limit * limit * DELTA_E2000_MAX_SL * DELTA_E2000_MAX_SL
+                      && deltaE2000Within(reference, block.lightness[i], block.a[i], block.b[i], block.chroma[i],
+                                          limit * limit);
+        }
+
+        if (similar) {
+            mask |= uint64_t(1) << i;
+        }
+    }
+    return mask;
+}
+
+#ifdef COLOR_METRIC_USE_SSE2
+
+namespace {
+    __m128 pow7(const __m128 x) {
+        const __m128 x2 = _mm_mul_ps(x, x);
+        const __m128 x3 = _mm_mul_ps(x2, x);
+        return _mm_mul_ps(_mm_mul_ps(x3, x3), x);
+    }
+
+    __m128 select(const __m128 condition, const __m128 whenTrue, const __m128 whenFalse) {
+        return _mm_or_ps(_mm_and_ps(condition, whenTrue), _mm_andnot_ps(condition, whenFalse));
+    }
+
+    // deltaE2000Terms e o teste de deltaE2000Within de quatro em quatro células. As células em que
+    // o termo de rotação decide o resultado voltam para o caminho escalar.
+    uint64_t similarDeltaE2000Mask(const LabBlock& block, const glm::vec3& reference, const float limit) {
+        const __m128 one = _mm_set1_ps(1.0f);
+        const __m128 two = _mm_set1_ps(2.0f);
+        const __m128 half = _mm_set1_ps(0.5f);
+        const __m128 zero = _mm_setzero_ps();
+        const __m128 pow25_7 = _mm_set1_ps(6103515625.0f);
+        const __m128 limitSquared = _mm_set1_ps(limit * limit);
+        const __m128 lightnessLimit = _mm_set1_ps(limit * limit * DELTA_E2000_MAX_SL * DELTA_E2000_MAX_SL);
+
+        const __m128 referenceL = _mm_set1_ps(reference.x);
+        const __m128 referenceA = _mm_set1_ps(reference.y);
+        const __m128 referenceB = _mm_set1_ps(reference.z);
+        const __m128 c1 = _mm_set1_ps(std::sqrt(reference.y * reference.y + reference.z * reference.z));
+
+        uint64_t mask = 0;
+        for (int i = 0; i < BOARD_BLOCK; i += 4) {
+            const __m128 lightness = _mm_loadu_ps(block.lightness + i);
+            const __m128 dL = _mm_sub_ps(lightness, referenceL);
+
+            const int candidates = _mm_movemask_ps(_mm_cmple_ps(_mm_mul_ps(dL, dL), lightnessLimit));
+            if (candidates == 0) {
+                continue;
+            }
+
+            const __m128 meanC7 = pow7(_mm_div_ps(_mm_add_ps(c1, _mm_loadu_ps(block.chroma + i)), two));
+            const __m128 g = _mm_mul_ps(half, _mm_sub_ps(one, _mm_sqrt_ps(_mm_div_ps(meanC7, _mm_add_ps(meanC7, pow25_7)))));
+
+            const __m128 a1 = _mm_mul_ps(_mm_add_ps(one, g), referenceA);
+            const __m128 a2 = _mm_mul_ps(_mm_add_ps(one, g), _mm_loadu_ps(block.a + i));
+            const __m128 b1 = referenceB;
+            const __m128 b2 = _mm_loadu_ps(block.b + i);
+
+            const __m128 chroma1 = _mm_sqrt_ps(_mm_add_ps(_mm_mul_ps(a1, a1), _mm_mul_ps(b1, b1)));
+            const __m128 chroma2 = _mm_sqrt_ps(_mm_add_ps(_mm_mul_ps(a2, a2), _mm_mul_ps(b2, b2)));
+
+            const __m128 dC = _mm_sub_ps(chroma2, chroma1);
+            const __m128 products = _mm_sub_ps(_mm_sub_ps(_mm_mul_ps(chroma1, chroma2), _mm_mul_ps(a1, a2)),
+                                               _mm_mul_ps(b1, b2));
+            const __m128 dH = _mm_sqrt_ps(_mm_max_ps(_mm_mul_ps(two, products), zero));
+
+            const __m128 meanL = _mm_div_ps(_mm_add_ps(referenceL, lightness), two);
+            const __m128 meanChroma = _mm_div_ps(_mm_add_ps(chroma1, chroma2), two);
+
+            const __m128 hasChroma1 = _mm_cmpgt_ps(chroma1, zero);
+            const __m128 hasChroma2 = _mm_cmpgt_ps(chroma2, zero);
+            __m128 hueX = _mm_add_ps(_mm_and_ps(hasChroma1, _mm_div_ps(a1, chroma1)),
+                                     _mm_and_ps(hasChroma2, _mm_div_ps(a2, chroma2)));
+            __m128 hueY = _mm_add_ps(_mm_and_ps(hasChroma1, _mm_div_ps(b1, chroma1)),
+                                     _mm_and_ps(hasChroma2, _mm_div_ps(b2, chroma2)));
+            const __m128 hueLength = _mm_sqrt_ps(_mm_add_ps(_mm_mul_ps(hueX, hueX), _mm_mul_ps(hueY, hueY)));
+            const __m128 hasHue = _mm_cmpgt_ps(hueLength, _mm_set1_ps(1e-6f));
+
+            // Matizes opostos: 90° depois do menor, como em deltaE2000Terms. b1 é o da referência,
+            // então o lado é o mesmo nas quatro células.
+            const __m128 hasBoth = _mm_and_ps(hasChroma1, hasChroma2);
+            const __m128 side = _mm_set1_ps(reference.z > 0.0f || (reference.z == 0.0f && reference.y > 0.0f)
+                                                ? 1.0f : -1.0f);
+            const __m128 oppositeX = _mm_sub_ps(zero, _mm_div_ps(_mm_mul_ps(side, b1), chroma1));
+            const __m128 oppositeY = _mm_div_ps(_mm_mul_ps(side, a1), chroma1);
+
+            hueX = select(hasHue, _mm_div_ps(hueX, hueLength), select(hasBoth, oppositeX, one));
+            hueY = select(hasHue, _mm_div_ps(hueY, hueLength), select(hasBoth, oppositeY, zero));
+
+            const __m128 cos2 = _mm_sub_ps(_mm_mul_ps(hueX, hueX), _mm_mul_ps(hueY, hueY));
+            const __m128 sin2 = _mm_mul_ps(_mm_mul_ps(two, hueY), hueX);
+            const __m128 cos3 = _mm_sub_ps(_mm_mul_ps(cos2, hueX), _mm_mul_ps(sin2, hueY));
+            const __m128 sin3 = _mm_add_ps(_mm_mul_ps(sin2, hueX), _mm_mul_ps(cos2, hueY));
+            const __m128 cos4 = _mm_sub_ps(_mm_mul_ps(cos2, cos2), _mm_mul_ps(sin2, sin2));
+            const __m128 sin4 = _mm_mul_ps(_mm_mul_ps(two, sin2), cos2);
+
+            __m128 t = _mm_sub_ps(one, _mm_mul_ps(_mm_set1_ps(0.17f), _mm_add_ps(_mm_mul_ps(hueX, _mm_set1_ps(0.8660254f)),
+                                                                                 _mm_mul_ps(hueY, half))));
+            t = _mm_add_ps(t, _mm_mul_ps(_mm_set1_ps(0.24f), cos2));
+            t = _mm_add_ps(t, _mm_mul_ps(_mm_set1_ps(0.32f), _mm_sub_ps(_mm_mul_ps(cos3, _mm_set1_ps(0.9945219f)),
+                                                                        _mm_mul_ps(sin3, _mm_set1_ps(0.1045285f)))));
+            t = _mm_sub_ps(t, _mm_mul_ps(_mm_set1_ps(0.20f), _mm_add_ps(_mm_mul_ps(cos4, _mm_set1_ps(0.4539905f)),
+                                                                        _mm_mul_ps(sin4, _mm_set1_ps(0.8910065f)))));
+
+            const __m128 meanL50 = _mm_mul_ps(_mm_sub_ps(meanL, _mm_set1_ps(50.0f)), _mm_sub_ps(meanL, _mm_set1_ps(50.0f)));
+            const __m128 sL = _mm_add_ps(one, _mm_div_ps(_mm_mul_ps(_mm_set1_ps(0.015f), meanL50),
+                                                         _mm_sqrt_ps(_mm_add_ps(_mm_set1_ps(20.0f), meanL50))));
+            const __m128 sC = _mm_add_ps(one, _mm_mul_ps(_mm_set1_ps(0.045f), meanChroma));
+            const __m128 sH = _mm_add_ps(one, _mm_mul_ps(_mm_mul_ps(_mm_set1_ps(0.015f), meanChroma), t));
+
+            const __m128 meanChroma7 = pow7(meanChroma);
+            const __m128 rC = _mm_mul_ps(two, _mm_sqrt_ps(_mm_div_ps(meanChroma7, _mm_add_ps(meanChroma7, pow25_7))));
+
+            const __m128 l = _mm_div_ps(dL, sL);
+            const __m128 c = _mm_div_ps(dC, sC);
+            const __m128 h = _mm_div_ps(dH, sH);
+
+            const __m128 base = _mm_add_ps(_mm_add_ps(_mm_mul_ps(l, l), _mm_mul_ps(c, c)), _mm_mul_ps(h, h));
+            const __m128 rotation = _mm_mul_ps(rC, _mm_mul_ps(c, h));
+            const __m128 rotationBound = _mm_max_ps(rotation, _mm_sub_ps(zero, rotation));
+
+            const int accepted = _mm_movemask_ps(_mm_cmple_ps(_mm_add_ps(base, rotationBound), limitSquared)) & candidates;
+            const int undecided = _mm_movemask_ps(_mm_cmple_ps(_mm_sub_ps(base, rotationBound), limitSquared))
+                                  & candidates & ~accepted;
+
+            mask |= static_cast<uint64_t>(accepted) << i;
+
+            for (int lane = 0; lane < 4; lane++) {
+                const int cell = i + lane;
+                if ((undecided & (1 << lane))
+                    && deltaE2000Within(reference, block.lightness[cell], block.a[cell], block.b[cell], block.chroma[cell],
+                                        limit * limit)) {
+                    mask |= uint64_t(1) << cell;
+                }
+            }
+        }
+        return mask;
+    }
+}
+
+uint64_t similarLabMask(const ColorMetric metric, const LabBlock& block, const glm::vec3& reference,
+                        const float limit) {
+    if (metric == ColorMetric::DeltaE2000) {
+        return similarDeltaE2000Mask(block, reference, limit);
+    }
+
+    const DeltaE94Weights weights = deltaE94Weights(reference);
+
+    const __m128 referenceL = _mm_set1_ps(reference.x);
+    const __m128 referenceA = _mm_set1_ps(reference.y);
+    const __m128 referenceB = _mm_set1_ps(reference.z);
+    const __m128 referenceC = _mm_set1_ps(weights.chroma);
+    const __m128 chromaWeight = _mm_set1_ps(weights.inverseChromaWeight);
+    const __m128 hueWeight = _mm_set1_ps(weights.inverseHueWeight);
+    const __m128 limitSquared = _mm_set1_ps(limit * limit);
+    const __m128 zero = _mm_setzero_ps();
+
+    uint64_t mask = 0;
+    for (int i = 0; i < BOARD_BLOCK; i += 4) {
+        const __m128 dL = _mm_sub_ps(referenceL, _mm_loadu_ps(block.lightness + i));
+        const __m128 da = _mm_sub_ps(referenceA, _mm_loadu_ps(block.a + i));
+        const __m128 db = _mm_sub_ps(referenceB, _mm_loadu_ps(block.b + i));
+
+        const __m128 dL2 = _mm_mul_ps(dL, dL);
+        const __m128 dab2 = _mm_add_ps(_mm_mul_ps(da, da), _mm_mul_ps(db, db));
+
+        __m128 distance;
+        if (metric == ColorMetric::DeltaE76) {
+            distance = _mm_add_ps(dL2, dab2);
+        } else {
+            const __m128 dC = _mm_sub_ps(referenceC, _mm_loadu_ps(block.chroma + i));
+            const __m128 dC2 = _mm_mul_ps(dC, dC);
+            const __m128 dH = _mm_max_ps(_mm_sub_ps(dab2, dC2), zero);
+
+            distance = _mm_add_ps(_mm_add_ps(dL2, _mm_mul_ps(dC2, chromaWeight)), _mm_mul_ps(dH, hueWeight));
+        }
+
+        const int lanes = _mm_movemask_ps(_mm_cmple_ps(distance, limitSquared));
+        mask |= static_cast<uint64_t>(lanes) << i;
+    }
+    return mask;
+}
+
+#else
+
+uint64_t similarLabMask(const ColorMetric metric, const LabBlock& block, const glm::vec3& reference,
+                        const float limit) {
+    return similarLabMaskScalar(metric, block, reference, limit);
+}
+
+#endif
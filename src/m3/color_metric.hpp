@@ -0,0 +1,62 @@
+#pragma once
+
+#include <cstdint>
+
+#include "glm/vec3.hpp"
+
+// Como o jogo das cores decide se duas cores são parecidas. Rgb é a distância euclidiana em RGB
+// (a regra original, com TOLERANCE); as outras são diferenças de cor da CIE medidas em CIELAB, mais
+// próximas do que o jogador enxerga.
+enum class ColorMetric {
+    Rgb,
+    DeltaE76,
+    DeltaE94,
+    DeltaE2000,
+};
+
+constexpr int COLOR_METRIC_COUNT = 4;
+
+// Limites de ΔE para cada métrica, escolhidos para que um clique em um tabuleiro sorteado remova
+// mais ou menos a mesma fração de células que a regra em RGB.
+constexpr float DELTA_E76_TOLERANCE = 36.0f;
+constexpr float DELTA_E94_TOLERANCE = 19.0f;
+constexpr float DELTA_E2000_TOLERANCE = 19.0f;
+
+const char* colorMetricName(ColorMetric metric);
+
+// Limite padrão da métrica: a ΔE acima, ou TOLERANCE (em fração de MAX_DISTANCE) para Rgb.
+float colorMetricTolerance(ColorMetric metric);
+
+ColorMetric nextColorMetric(ColorMetric metric);
+
+// sRGB em [0, 1] para CIELAB com branco D65 (L em [0, 100]).
+glm::vec3 rgbToLab(const glm::vec3& rgb);
+
+float deltaE76(const glm::vec3& reference, const glm::vec3& sample);
+
+// Versão de artes gráficas (kL = 1, K1 = 0.045, K2 = 0.015). Não é simétrica: os pesos vêm da
+// croma de reference.
+float deltaE94(const glm::vec3& reference, const glm::vec3& sample);
+
+float deltaE2000(const glm::vec3& reference, const glm::vec3& sample);
+
+// Se sample está a no máximo limit (uma ΔE) de reference, as duas em CIELAB. É o teste de
+// similarLabMask para um par de cores só.
+bool similarLab(ColorMetric metric, const glm::vec3& reference, const glm::vec3& sample, float limit);
+
+// Cores de um bloco de BOARD_BLOCK células em CIELAB, uma componente por vetor. chroma é
+// sqrt(a² + b²), guardada junto porque o ΔE94 precisaria dela para toda célula a cada clique.
+struct LabBlock {
+    const float* lightness;
+    const float* a;
+    const float* b;
+    const float* chroma;
+};
+
+// Bit i ligado se a célula i do bloco está a no máximo limit (uma ΔE da métrica) de reference (em
+// CIELAB), com SSE2 quando disponível. No ΔE2000 só o termo de rotação (atan2, exp e sin) é
+// escalar, e só é calculado nas células em que ele pode mudar a resposta. Não aceita ColorMetric::Rgb.
+uint64_t similarLabMask(ColorMetric metric, const LabBlock& block, const glm::vec3& reference, float limit);
+
+// Mesma coisa sem SIMD.
+uint64_t similarLabMaskScalar(ColorMetric metric, const LabBlock& block, const glm::vec3& reference, float limit);
@@ -0,0 +1,29 @@
+#include "m3/game.hpp"
+
+void Game::restart() {
+    this->board.generate();
+    this->score = 0;
+    this->plays = 0;
+}
+
+void Game::restart(std::mt19937& random) {
+    this->board.generate(random);
+    this->score = 0;
+    this->plays = 0;
+}
+
+// A própria célula clicada entra na contagem (distância zero); células que já tinham sumido não contam.
+int Game::click(const int index) {
+    if (!this->board.visible(index)) {
+        return 0;
+    }
+
+    const int chain = this->board.eliminate(index);
+    record(chain);
+    return chain;
+}
+
+void Game::record(const int chain) {
+    this->score += chain * this->rules.chainMultiplier - this->rules.playCost;
+    this->plays++;
+}
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <random>
+
+#include "m3/board.hpp"
+
+constexpr int CHAIN_MULTIPLIER = 2;
+constexpr int PLAY_COST = 5;
+
+// Pontuação de uma partida: cada clique custa playCost e cada célula eliminada vale chainMultiplier.
+struct GameRules {
+    int chainMultiplier = CHAIN_MULTIPLIER;
+    int playCost = PLAY_COST;
+};
+
+// Uma partida do jogo das cores, sem nada de janela nem de estado global. O m3 joga uma com o mouse;
+// o m3_sim joga milhões, uma por thread de cada vez.
+class Game {
+public:
+    Board board;
+    GameRules rules;
+    int score = 0;
+    int plays = 0;
+
+    // Sorteia um tabuleiro novo (com rand() ou com o gerador dado) e zera a pontuação.
+    void restart();
+    void restart(std::mt19937& random);
+
+    // Clica na célula index e devolve quantas células sumiram. Clicar em uma célula que já sumiu não
+    // conta como jogada nem custa pontos.
+    int click(int index);
+
+    // Conta uma jogada que eliminou chain células por fora do Board (na GPU, por exemplo).
+    void record(int chain);
+
+    bool finished() const { return this->board.cleared(); }
+};
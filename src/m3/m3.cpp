@@ -1,9 +1,12 @@
 #define GLM_ENABLE_EXPERIMENTAL
 
 #include <algorithm>
+#include <cmath>
+#include <cstring>
 #include <glad.h>
 #include <iomanip>
 #include <iostream>
+#include <memory>
 #include <vector>
 
 #include "GLFW/glfw3.h"
@@ -14,338 +17,304 @@
 #include "glm/gtc/type_ptr.hpp"
 #include "glm/gtx/transform.hpp"
 
+#include "m3/board.hpp"
+#include "m3/board_compute.hpp"
+#include "m3/board_renderer.hpp"
+#include "m3/game.hpp"
+#include "renderer/profiler.hpp"
+#include "renderer/render_context.hpp"
+#include "renderer/software_rasterizer.hpp"
+
 constexpr int WIDTH = 800;
 constexpr int HEIGHT = 800;
-constexpr int COLUMNS = 10;
-constexpr int ROWS = 10;
-constexpr int QUAD_WIDTH = WIDTH / COLUMNS;
-constexpr int QUAD_HEIGHT = HEIGHT / ROWS;
-
-constexpr double MAX_DISTANCE = sqrt(3.0);
-constexpr double TOLERANCE = 0.2;
-
-constexpr int CHAIN_MULTIPLIER = 2;
-constexpr int PLAY_COST = 5;
-
-int score = 0;
-
-struct Quad
-{
-    glm::vec2 position;
-    glm::vec3 color;
-    bool visible = true;
-};
-
-float randomFloat() {
-    return static_cast <float> (rand()) / static_cast <float> (RAND_MAX);;
-}
-
-glm::vec3 randomColor()
-{
-    return {randomFloat(), randomFloat(), randomFloat()};
-};
+constexpr int DEFAULT_COLUMNS = 10;
+constexpr int DEFAULT_ROWS = 10;
 
 constexpr glm::vec3 clearColor = glm::vec3(0.0f, 0.0f, 0.0f);
 
 
-constexpr auto vertexShaderSource =
-R"GLSL(
-#version 330 core
-layout (location = 0) in vec3 aPos;
-uniform mat4 projection;
-uniform mat4 model;
-
-void main()
-{
-    gl_Position = projection * model * vec4(aPos.x, aPos.y, aPos.z, 1.0);
-}
-)GLSL";
-
-constexpr auto fragmentShaderSource = R"GLSL(
-#version 330 core
-uniform vec4 inputColor;
-out vec4 FragColor;
-
-void main()
-{
-    FragColor = inputColor;
-}
-)GLSL";
-
 void framebufferSizeCallback(GLFWwindow* window, const int width, const int height)
 {
     glViewport(0, 0, width, height);
 }
 
-GLuint compileShader(const char* shaderSource, int shaderType) {
-    const GLuint shaderId = glCreateShader(shaderType);
-    glShaderSource(shaderId, 1, &shaderSource, nullptr);
-    glCompileShader(shaderId);
-
-    int success;
-    glGetShaderiv(shaderId, GL_COMPILE_STATUS, &success);
-
-    if (!success) {
-        char infoLog[512];
-        glGetShaderInfoLog(shaderId, sizeof(infoLog), nullptr, infoLog);
-        std::cout << "ERROR::SHADER::COMPILATION_FAILED\n" << infoLog << std::endl;
-    }
+Game game;
+Board& board = game.board;
+BoardRenderer boardRenderer;
 
-    return shaderId;
-}
+// Com --gpu-eliminate os cliques são eliminados por um compute shader na textura do tabuleiro. O
+// Board da CPU fica só com as cores: quantas células restam vem das contagens que voltam da GPU.
+bool gpuEliminate = false;
+BoardCompute boardCompute;
+int gpuRemaining = 0;
 
-GLuint createShaderProgram() {
-    const GLuint vertexShader = compileShader(vertexShaderSource, GL_VERTEX_SHADER);
-    const GLuint fragmentShader = compileShader(fragmentShaderSource, GL_FRAGMENT_SHADER);
-
-    const GLuint shaderProgram = glCreateProgram();
-    glAttachShader(shaderProgram, vertexShader);
-    glAttachShader(shaderProgram, fragmentShader);
-    glLinkProgram(shaderProgram);
-
-    int success;
-    glGetProgramiv(shaderProgram, GL_LINK_STATUS, &success);
-    if (!success) {
-        char infoLog[512];
-        glGetProgramInfoLog(shaderProgram, sizeof(infoLog), nullptr, infoLog);
-        std::cout << "ERROR::SHADER::PROGRAM::LINKING_FAILED\n" << infoLog << std::endl;
-    }
+// Com --software o tabuleiro é rasterizado na CPU, um retângulo por célula.
+std::unique_ptr<SoftwareRasterizer> software;
 
-    glDeleteShader(vertexShader);
-    glDeleteShader(fragmentShader);
+// Índice da célula clicada, ou -1 enquanto não há clique para processar.
+int selectedCell = -1;
 
-    return shaderProgram;
-}
+// Células destacadas enquanto o mouse está sobre uma célula visível.
+std::vector<int> previewCells;
 
-GLuint createVBOAndBind(const GLuint VAO, const float* vertices, const int verticesLength) {
-    GLuint VBO;
-    glGenBuffers(1, &VBO);
-    glBindVertexArray(VAO);
+// De onde veio a prévia atual; enquanto nada disso muda ela continua valendo.
+int previewCell = -1;
+int previewRemaining = -1;
+ColorMetric previewMetric = ColorMetric::Rgb;
+EliminationMode previewMode = EliminationMode::Global;
 
-    glBindBuffer(GL_ARRAY_BUFFER, VBO);
-    glBufferData(GL_ARRAY_BUFFER, verticesLength * sizeof(float), vertices, GL_STATIC_DRAW);
+// Célula embaixo do cursor, ou -1 se ele estiver fora do tabuleiro.
+int cellUnderCursor(GLFWwindow* window) {
+    double xpos, ypos;
+    glfwGetCursorPos(window, &xpos, &ypos);
 
-    return VBO;
-}
+    int windowWidth, windowHeight;
+    glfwGetWindowSize(window, &windowWidth, &windowHeight);
 
-GLuint createQuad(
-    const float x1,
-    const float y1,
-    const float x2,
-    const float y2,
-    const float x3,
-    const float y3,
-    const float x4,
-    const float y4) {
-    GLuint VAO;
-    glGenVertexArrays(1, &VAO);
-
-    float vertices[] = {
-        x1, y1, 0.0f,
-        x2, y2, 0.0f,
-        x3, y3, 0.0f,
-        x4, y4, 0.0f,
-    };
-
-    createVBOAndBind(VAO, vertices, sizeof(vertices) / sizeof(float));
-
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
-    glEnableVertexAttribArray(0);
-
-    glBindBuffer(GL_ARRAY_BUFFER, 0);
-    glBindVertexArray(0);
-
-    return VAO;
-}
+    int x = xpos * WIDTH / windowWidth / board.quadWidth;
+    int y = ypos * HEIGHT / windowHeight / board.quadHeight;
 
-Quad quads[COLUMNS][ROWS];
-Quad* selectedQuad;
-
-void generateBoard() {
-    for (int x = 0; x < COLUMNS; x++) {
-        for (int y = 0; y < ROWS; y++) {
-            Quad quad = {};
-            quad.position = glm::vec2(
-                (QUAD_WIDTH / 2) + x * QUAD_WIDTH,
-                (QUAD_HEIGHT / 2) + y * QUAD_HEIGHT);
-            quad.color = randomColor();
-            quads[x][y] = quad;
-        }
+    if (xpos < 0 || ypos < 0 || x >= board.columns || y >= board.rows) {
+        return -1;
     }
+    return board.index(x, y);
 }
 
-void checkForQuadEliminationAndAddScore() {
-    if (!selectedQuad->visible) {
-        selectedQuad = nullptr;
+// Prévia do que um clique eliminaria. Só é recalculada quando o cursor muda de célula, o tabuleiro
+// perde células ou a métrica ou o modo mudam.
+void updatePreview(GLFWwindow* window) {
+    if (window == nullptr) {
         return;
     }
 
-    selectedQuad->visible = false;
-
-    score -= PLAY_COST;
-    int chain = 0;
-
-    for (int x = 0; x < COLUMNS; x++) {
-        for (int y = 0; y < ROWS; y++) {
-            Quad* currentQuad = &quads[x][y];
-
-            const double distance = sqrt(
-                pow( selectedQuad->color.r - currentQuad->color.r,2)
-                + pow( selectedQuad->color.g - currentQuad->color.g,2)
-                + pow( selectedQuad->color.b - currentQuad->color.b,2));
-
-            double relativeDistance = distance / MAX_DISTANCE;
+    int hovered = cellUnderCursor(window);
+    if (hovered >= 0 && !board.visible(hovered)) {
+        hovered = -1;
+    }
 
-            if (relativeDistance <= TOLERANCE) {
-                currentQuad->visible = false;
-                chain++;
-            }
-        }
+    if (hovered == previewCell && board.visibleCount() == previewRemaining && board.metric == previewMetric
+        && board.mode == previewMode) {
+        return;
     }
-    selectedQuad = nullptr;
 
-    score += chain * CHAIN_MULTIPLIER;
-}
+    previewCell = hovered;
+    previewRemaining = board.visibleCount();
+    previewMetric = board.metric;
+    previewMode = board.mode;
 
-bool gameHasEnded() {
-    for (int x = 0; x < COLUMNS; x++) {
-        for (int y = 0; y < ROWS; y++) {
-            if (quads[x][y].visible) {
-                return false;
-            }
-        }
+    previewCells.clear();
+    if (hovered >= 0) {
+        board.preview(hovered, previewCells);
     }
-    return true;
 }
 
 void printScore() {
-    std::cout << "Parabéns! Você obteve " << score << " pontos" << std::endl;
+    std::cout << "Parabéns! Você obteve " << game.score << " pontos" << std::endl;
     std::cout << "Recomeçando" << std::endl;
 }
 
 void restartGame() {
-    generateBoard();
-    score = 0;
+    game.restart();
+    if (gpuEliminate) {
+        boardCompute.upload(board);
+        gpuRemaining = board.visibleCount();
+    }
+}
+
+// Pontua as eliminações da GPU cujas contagens já voltaram. Uma contagem 0 é um clique em uma
+// célula que já tinha sumido, que não conta como jogada.
+void collectGpuEliminations() {
+    int removed = 0;
+    while (boardCompute.poll(removed)) {
+        if (removed == 0) {
+            continue;
+        }
+
+        game.record(removed);
+        gpuRemaining -= removed;
+        if (gpuRemaining == 0) {
+            printScore();
+            restartGame();
+        }
+    }
 }
 
 void processInput(GLFWwindow* window) {
-    if (glfwGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS) {
+    if (window != nullptr && glfwGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS) {
         glfwSetWindowShouldClose(window, GLFW_TRUE);
     }
 
-    if (selectedQuad != nullptr) {
-        checkForQuadEliminationAndAddScore();
-        if (gameHasEnded()) {
+    if (selectedCell >= 0 && gpuEliminate) {
+        boardCompute.eliminate(boardRenderer.boardTexture(), selectedCell, board.similarDistanceSquared());
+        selectedCell = -1;
+    }
+
+    if (selectedCell >= 0) {
+        game.click(selectedCell);
+        selectedCell = -1;
+        if (game.finished()) {
             printScore();
             restartGame();
-        };
+        }
     }
 }
 
-int main() {
-    glfwInit();
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
-    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+// Com --on-demand redesenha só a faixa da tela das colunas que o BoardRenderer mudou.
+void damageBoardColumns(RenderContext& context) {
+    if (!boardRenderer.damaged()) {
+        return;
+    }
 
-    GLFWwindow* window = glfwCreateWindow(WIDTH, HEIGHT, "Jogo das Cores - Otavio", nullptr, nullptr);
+    const long long first = boardRenderer.damagedFirstColumn;
+    const long long last = boardRenderer.damagedLastColumn;
+    const int left = static_cast<int>(first * context.width / board.columns);
+    const int right = static_cast<int>(((last + 1) * context.width + board.columns - 1) / board.columns);
+    context.damage(left, 0, right - left, context.height);
 
-    if (window == nullptr) {
-        std::cout << "Failed to create GLFW window" << std::endl;
-        glfwTerminate();
+    boardRenderer.clearDamage();
+}
+
+int main(int argc, char** argv) {
+    ContextOptions options;
+    if (!parseContextOptions(argc, argv, options)) {
         return -1;
     }
 
-    glfwMakeContextCurrent(window);
+    for (int i = 1; i < argc; i++) {
+        if (std::strcmp(argv[i], "--gpu-eliminate") == 0 && options.software) {
+            std::cout << "--gpu-eliminate é ignorado com --software" << std::endl;
+        } else if (std::strcmp(argv[i], "--gpu-eliminate") == 0) {
+            gpuEliminate = true;
+            options.glMajor = 4;
+            options.glMinor = 3;
+        }
+    }
 
-    if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress)) {
-        std::cout << "Failed to initialize GLAD" << std::endl;
+    RenderContext context;
+    if (!context.create(WIDTH, HEIGHT, "Jogo das Cores - Otavio", options)) {
         return -1;
     }
 
-    glViewport(0, 0, WIDTH, HEIGHT);
-    glfwSetFramebufferSizeCallback(window, framebufferSizeCallback);
+    GLFWwindow* window = context.window;
+    srand(options.seed);
+
+    glViewport(0, 0, context.width, context.height);
+
+    if (window != nullptr) {
+        glfwSetFramebufferSizeCallback(window, framebufferSizeCallback);
+
+        // M troca a métrica de semelhança entre RGB, CIE76, CIE94 e CIEDE2000; F alterna entre
+        // eliminar no tabuleiro todo e só na região conectada à célula clicada.
+        glfwSetKeyCallback(window, [](GLFWwindow* window, int key, int scancode, int action, int mods) {
+            if ((key == GLFW_KEY_M || key == GLFW_KEY_F) && action == GLFW_PRESS && gpuEliminate) {
+                std::cout << "A eliminação na GPU só compara em RGB no tabuleiro todo" << std::endl;
+            } else if (key == GLFW_KEY_M && action == GLFW_PRESS) {
+                board.metric = nextColorMetric(board.metric);
+                std::cout << "Métrica de cor: " << colorMetricName(board.metric) << std::endl;
+            } else if (key == GLFW_KEY_F && action == GLFW_PRESS) {
+                const bool connected = board.mode == EliminationMode::Global;
+                board.mode = connected ? EliminationMode::Connected : EliminationMode::Global;
+                std::cout << "Modo: " << (connected ? "região conectada" : "tabuleiro todo") << std::endl;
+            }
+        });
 
-    glfwSetMouseButtonCallback(window,
-    [] (GLFWwindow* window, int button, int action, int mods)
-        {
-            if (button == GLFW_MOUSE_BUTTON_LEFT && action == GLFW_PRESS)
+        glfwSetMouseButtonCallback(window,
+        [] (GLFWwindow* window, int button, int action, int mods)
             {
-                double xpos, ypos;
-                glfwGetCursorPos(window, &xpos, &ypos);
-
-                int x = xpos / QUAD_WIDTH;
-                int y = ypos / QUAD_HEIGHT;
-
-                selectedQuad = &quads[x][y];
+                if (button == GLFW_MOUSE_BUTTON_LEFT && action == GLFW_PRESS)
+                {
+                    const int cell = cellUnderCursor(window);
+                    if (cell >= 0) {
+                        selectedCell = cell;
+                    }
+                }
             }
-        }
-    );
-
-    const GLuint shaderProgram = createShaderProgram();
-    GLuint baseQuadVAO = createQuad(
-        -0.5f, 0.5f,
-        -0.5f, -0.5f,
-        0.5, 0.5f,
-        0.5f, -0.5f
-    );
-
-    generateBoard();
-
-    glUseProgram(shaderProgram);
-
-    GLint colorLoc = glGetUniformLocation(shaderProgram, "inputColor");
-    glm::mat4 projection = glm::ortho(0.0, (double) WIDTH, (double) HEIGHT, 0.0, -1.0, 1.0);
-    glUniformMatrix4fv(
-        glGetUniformLocation(shaderProgram, "projection"),
-        1,
-        GL_FALSE,
-        value_ptr(projection)
-    );
-
-    while(!glfwWindowShouldClose(window))
-    {
-        glfwPollEvents();
-        processInput(window);
-
-        glClearColor(clearColor.r, clearColor.g, clearColor.b, 1.0f);
-        glClear(GL_COLOR_BUFFER_BIT);
-
-        glLineWidth(10);
-        glPointSize(20);
-
-        glBindVertexArray(baseQuadVAO);
-        for (int x = 0; x < COLUMNS; x++) {
-            for (int y = 0; y < ROWS; y++) {
-                Quad quad = quads[x][y];
+        );
+    }
 
-                glm::mat4 model = glm::mat4(1);
+    // --scale N monta o menor tabuleiro quadrado com pelo menos N retângulos.
+    if (options.scale > 0) {
+        const int side = static_cast<int>(std::ceil(std::sqrt(static_cast<double>(options.scale))));
+        board.resize(side, side, WIDTH, HEIGHT);
+    } else {
+        board.resize(DEFAULT_COLUMNS, DEFAULT_ROWS, WIDTH, HEIGHT);
+    }
+    boardRenderer.create(board, clearColor);
+    if (options.software) {
+        software = std::make_unique<SoftwareRasterizer>();
+        software->create(context.width, context.height);
+    }
+    if (gpuEliminate && !boardCompute.create()) {
+        gpuEliminate = false;
+    }
+    restartGame();
 
-                model = glm::translate(model, glm::vec3(quad.position,  0.0));
-                model = glm::scale(model, glm::vec3(QUAD_WIDTH, QUAD_HEIGHT, 1.0));
+    while(!context.shouldClose())
+    {
+        PROFILE_ZONE("frame");
 
-                glUniformMatrix4fv(
-                    glGetUniformLocation(shaderProgram, "model"),
-                    1,
-                    GL_FALSE,
-                    value_ptr(model)
-                );
+        {
+            PROFILE_ZONE("input");
+            context.pollEvents();
+            if (gpuEliminate && selectedCell >= 0) {
+                // O compute shader pode apagar células em qualquer coluna.
+                context.damageAll();
+            }
+            processInput(window);
+            if (gpuEliminate) {
+                collectGpuEliminations();
+                // As contagens ainda na GPU chegam sem gerar eventos.
+                if (boardCompute.pending()) {
+                    context.requestFrame();
+                }
+            }
+        }
 
-                auto color = quad.visible ? quad.color : clearColor;
+        {
+            PROFILE_ZONE("update");
+            boardRenderer.update(board);
 
-                glUniform4f(colorLoc, color.r, color.g, color.b, 1.0f);
-                glDrawArrays(GL_TRIANGLE_STRIP, 0, 6);
+            // Com a eliminação na GPU a CPU não sabe o que ainda está visível para mostrar a prévia.
+            if (!gpuEliminate) {
+                updatePreview(window);
+                boardRenderer.setPreview(board, previewCells);
+            }
+            damageBoardColumns(context);
+        }
 
+        {
+            PROFILE_GPU_ZONE("draw");
+            // A CPU monta o frame uma vez só e copia cada retângulo; a GPU redesenha por retângulo.
+            if (software) {
+                context.drawDamagedFrame([&context](const std::vector<DamageRect>& damage) {
+                    software->clear(glm::vec4(clearColor, 1.0f));
+                    boardRenderer.drawSoftware(*software, board);
+                    software->present(context.framebuffer(), damage);
+                });
+            } else {
+                context.drawDamaged([] {
+                    glClearColor(clearColor.r, clearColor.g, clearColor.b, 1.0f);
+                    glClear(GL_COLOR_BUFFER_BIT);
+
+                    boardRenderer.draw();
+                });
             }
         }
 
-        glBindVertexArray(0);
-        glfwSwapBuffers(window);
+        context.swapBuffers();
     }
 
-    glDeleteVertexArrays(1, &baseQuadVAO);
-    glDeleteProgram(shaderProgram);
+    if (gpuEliminate) {
+        boardCompute.destroy();
+    }
+    if (software) {
+        software->destroy();
+        software.reset();
+    }
+    boardRenderer.destroy();
 
-    glfwTerminate();
-    return 0;
+    context.writeBenchmarkReport("m3", board.cells());
+    const bool goldenPassed = context.checkGoldenImages("m3");
+    context.destroy();
+    return goldenPassed ? 0 : 1;
 }
\ No newline at end of file
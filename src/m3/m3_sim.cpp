@@ -0,0 +1,540 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "m3/game.hpp"
+#include "m3/solver.hpp"
+
+// Joga partidas do m3 sem janela, em todos os núcleos, e imprime a distribuição das pontuações em
+// JSON. Serve para calibrar TOLERANCE, CHAIN_MULTIPLIER e PLAY_COST com estatística em vez de
+// jogando na mão.
+//
+//     ./m3_sim [--games N] [--columns N] [--rows N] [--policy random|first|greedy] [--script arquivo]
+//              [--threads N] [--seed N] [--tolerance X] [--multiplier N] [--cost N]
+//              [--metric rgb|cie76|cie94|ciede2000] [--mode global|connected] [--output arquivo]
+//              [--solve] [--solve-seconds X] [--beam N]
+//
+// --solve também resolve cada tabuleiro com o solver e compara a política com a melhor pontuação
+// possível. Com menos partidas que threads as que sobram vão para o solver de cada partida; com
+// mais, cada thread resolve os seus tabuleiros sozinha.
+
+constexpr long long DEFAULT_GAMES = 100000;
+constexpr int DEFAULT_COLUMNS = 10;
+constexpr int DEFAULT_ROWS = 10;
+
+// Quantas partidas, no máximo, uma thread pega do contador de cada vez. Com poucas partidas o lote
+// diminui para todas as threads terem o que jogar.
+constexpr long long GAME_BATCH = 64;
+
+constexpr int HISTOGRAM_BUCKETS = 20;
+
+// Como escolher o próximo clique entre as células visíveis.
+enum class Policy {
+    // Uma célula visível qualquer, sorteada com o gerador da partida.
+    Random,
+    // A primeira célula visível em ordem de índice.
+    First,
+    // A célula que elimina mais células agora.
+    Greedy,
+};
+
+struct SimulationOptions {
+    long long games = DEFAULT_GAMES;
+    int columns = DEFAULT_COLUMNS;
+    int rows = DEFAULT_ROWS;
+    Policy policy = Policy::Random;
+    // Células (coluna e linha) clicadas em ordem no começo de toda partida; depois vale a política.
+    std::vector<int> script;
+    std::string scriptPath;
+    unsigned threads = 0;
+    unsigned long long seed = 1;
+    double tolerance = TOLERANCE;
+    GameRules rules;
+    ColorMetric metric = ColorMetric::Rgb;
+    EliminationMode mode = EliminationMode::Global;
+    std::string output;
+    bool solve = false;
+    SolverOptions solver;
+};
+
+namespace {
+    bool readValue(const int argc, char** argv, int& i, std::string& value) {
+        if (i + 1 >= argc) {
+            std::cout << "Missing value for " << argv[i] << std::endl;
+            return false;
+        }
+        value = argv[++i];
+        return true;
+    }
+
+    bool readInteger(const int argc, char** argv, int& i, const long long minimum, long long& value) {
+        std::string text;
+        if (!readValue(argc, argv, i, text)) {
+            return false;
+        }
+
+        char* end = nullptr;
+        value = std::strtoll(text.c_str(), &end, 10);
+        if (text.empty() || *end != '\0' || value < minimum) {
+            std::cout << "Invalid value for " << argv[i - 1] << ": " << text << std::endl;
+            return false;
+        }
+        return true;
+    }
+
+    // Real positivo, ou não negativo com allowZero.
+    bool readReal(const int argc, char** argv, int& i, const bool allowZero, double& value) {
+        std::string text;
+        if (!readValue(argc, argv, i, text)) {
+            return false;
+        }
+
+        char* end = nullptr;
+        value = std::strtod(text.c_str(), &end);
+        if (text.empty() || *end != '\0' || !(value > 0.0 || (allowZero && value == 0.0))) {
+            std::cout << "Invalid value for " << argv[i - 1] << ": " << text << std::endl;
+            return false;
+        }
+        return true;
+    }
+
+    // O arquivo de script é uma lista de pares "coluna linha", separados por espaço ou quebra de linha.
+    bool loadScript(const std::string& filePath, const int columns, const int rows, std::vector<int>& script) {
+        std::ifstream file(filePath);
+        if (!file) {
+            std::cout << "Failed to open script " << filePath << std::endl;
+            return false;
+        }
+
+        int x, y;
+        while (file >> x >> y) {
+            if (x < 0 || y < 0 || x >= columns || y >= rows) {
+                std::cout << "Script cell outside the board: " << x << " " << y << std::endl;
+                return false;
+            }
+            script.push_back(x * rows + y);
+        }
+
+        if (!file.eof()) {
+            std::cout << "Failed to read script " << filePath << std::endl;
+            return false;
+        }
+        return true;
+    }
+
+    // Percentil pelo método do posto mais próximo, sobre valores já ordenados.
+    int percentile(const std::vector<int>& sorted, const double fraction) {
+        if (sorted.empty()) {
+            return 0;
+        }
+        const size_t rank = static_cast<size_t>(std::ceil(fraction * static_cast<double>(sorted.size())));
+        return sorted[std::min(sorted.size(), std::max<size_t>(rank, 1)) - 1];
+    }
+
+    // splitmix64: espalha sementes vizinhas, para a partida i ter sempre o mesmo tabuleiro qualquer
+    // que seja o número de threads.
+    uint32_t gameSeed(const unsigned long long seed, const long long game) {
+        uint64_t z = seed + static_cast<uint64_t>(game) * 0x9E3779B97F4A7C15ull;
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+        return static_cast<uint32_t>((z ^ (z >> 31)) >> 32);
+    }
+}
+
+bool parseSimulationOptions(const int argc, char** argv, SimulationOptions& options) {
+    long long value = 0;
+
+    for (int i = 1; i < argc; i++) {
+        const std::string argument = argv[i];
+
+        if (argument == "--games") {
+            if (!readInteger(argc, argv, i, 1, options.games)) {
+                return false;
+            }
+        } else if (argument == "--columns" || argument == "--rows" || argument == "--threads") {
+            if (!readInteger(argc, argv, i, argument == "--threads" ? 0 : 1, value)) {
+                return false;
+            }
+
+            if (argument == "--columns") {
+                options.columns = static_cast<int>(value);
+            } else if (argument == "--rows") {
+                options.rows = static_cast<int>(value);
+            } else {
+                options.threads = static_cast<unsigned>(value);
+            }
+        } else if (argument == "--seed") {
+            if (!readInteger(argc, argv, i, 0, value)) {
+                return false;
+            }
+            options.seed = static_cast<unsigned long long>(value);
+        } else if (argument == "--multiplier" || argument == "--cost") {
+            if (!readInteger(argc, argv, i, 0, value)) {
+                return false;
+            }
+
+            if (argument == "--multiplier") {
+                options.rules.chainMultiplier = static_cast<int>(value);
+            } else {
+                options.rules.playCost = static_cast<int>(value);
+            }
+        } else if (argument == "--tolerance") {
+            if (!readReal(argc, argv, i, false, options.tolerance)) {
+                return false;
+            }
+        } else if (argument == "--solve") {
+            options.solve = true;
+        } else if (argument == "--solve-seconds") {
+            // 0 pula a busca exata e fica só com a busca em feixe.
+            if (!readReal(argc, argv, i, true, options.solver.seconds)) {
+                return false;
+            }
+        } else if (argument == "--beam") {
+            if (!readInteger(argc, argv, i, 1, value)) {
+                return false;
+            }
+            options.solver.beamWidth = static_cast<int>(value);
+        } else if (argument == "--script") {
+            if (!readValue(argc, argv, i, options.scriptPath)) {
+                return false;
+            }
+        } else if (argument == "--output") {
+            if (!readValue(argc, argv, i, options.output)) {
+                return false;
+            }
+        } else if (argument == "--policy" || argument == "--metric" || argument == "--mode") {
+            std::string name;
+            if (!readValue(argc, argv, i, name)) {
+                return false;
+            }
+
+            bool known = true;
+            if (argument == "--policy") {
+                known = name == "random" || name == "first" || name == "greedy";
+                options.policy = name == "first" ? Policy::First : name == "greedy" ? Policy::Greedy : Policy::Random;
+            } else if (argument == "--mode") {
+                known = name == "global" || name == "connected";
+                options.mode = name == "connected" ? EliminationMode::Connected : EliminationMode::Global;
+            } else {
+                known = false;
+                for (int metric = 0; metric < COLOR_METRIC_COUNT; metric++) {
+                    std::string metricName = colorMetricName(static_cast<ColorMetric>(metric));
+                    std::transform(metricName.begin(), metricName.end(), metricName.begin(), ::tolower);
+                    if (name == metricName) {
+                        options.metric = static_cast<ColorMetric>(metric);
+                        known = true;
+                    }
+                }
+            }
+
+            if (!known) {
+                std::cout << "Invalid value for " << argument << ": " << name << std::endl;
+                return false;
+            }
+        } else {
+            std::cout << "Unknown option " << argument << std::endl;
+            return false;
+        }
+    }
+
+    // O solver recusaria todos os tabuleiros; melhor falhar antes de jogar as partidas.
+    if (options.solve && static_cast<long long>(options.columns) * options.rows > MAX_SOLVER_CELLS) {
+        std::cout << "--solve supports boards of up to " << MAX_SOLVER_CELLS << " cells" << std::endl;
+        return false;
+    }
+
+    if (!options.scriptPath.empty()) {
+        return loadScript(options.scriptPath, options.columns, options.rows, options.script);
+    }
+    return true;
+}
+
+// Próximo clique da política; só é chamada com células visíveis no tabuleiro.
+int chooseCell(const Policy policy, Board& board, std::mt19937& random, std::vector<int>& cells) {
+    if (policy == Policy::First) {
+        return board.nthVisible(0);
+    }
+
+    if (policy == Policy::Random) {
+        std::uniform_int_distribution<int> pick(0, board.visibleCount() - 1);
+        return board.nthVisible(pick(random));
+    }
+
+    // As células que uma jogada eliminaria juntas dão o mesmo resultado; basta testar uma de cada
+    // grupo, então as já vistas em uma prévia são puladas.
+    std::vector<bool> covered(board.cells(), false);
+    int best = -1;
+    size_t bestChain = 0;
+
+    for (int i = 0; i < board.cells(); i++) {
+        if (!board.visible(i) || covered[i]) {
+            continue;
+        }
+
+        board.preview(i, cells);
+        if (cells.size() > bestChain) {
+            best = i;
+            bestChain = cells.size();
+        }
+
+        // No modo global a relação de semelhança não é transitiva, então só a região conectada
+        // garante que toda célula da prévia elimina exatamente o mesmo grupo.
+        if (board.mode == EliminationMode::Connected) {
+            for (const int cell : cells) {
+                covered[cell] = true;
+            }
+        }
+    }
+    return best;
+}
+
+// Resultados por partida; os do solver só são preenchidos com --solve.
+struct GameResults {
+    std::vector<int> scores;
+    std::vector<int> plays;
+    std::vector<int> bestScores;
+    std::vector<unsigned char> proven;
+    std::vector<double> solveSeconds;
+};
+
+void playGames(const SimulationOptions& options, const long long batch, const unsigned solverThreads,
+               std::atomic<long long>& nextGame, GameResults& results) {
+    Game game;
+    game.rules = options.rules;
+    game.board.resize(options.columns, options.rows, 800.0f, 800.0f);
+    game.board.metric = options.metric;
+    game.board.mode = options.mode;
+    game.board.tolerance = options.tolerance;
+    game.board.labelThreads = 1;
+
+    SolverOptions solverOptions = options.solver;
+    solverOptions.threads = solverThreads;
+
+    std::vector<int> cells;
+    Solution solution;
+
+    while (true) {
+        const long long first = nextGame.fetch_add(batch);
+        if (first >= options.games) {
+            return;
+        }
+        const long long last = std::min(options.games, first + batch);
+
+        for (long long i = first; i < last; i++) {
+            std::mt19937 random(gameSeed(options.seed, i));
+            game.restart(random);
+
+            // O solver só lê o tabuleiro, então a partida continua do mesmo estado inicial.
+            if (options.solve && solveBoard(game.board, solverOptions, solution)) {
+                results.bestScores[i] = game.board.visibleCount() * game.rules.chainMultiplier
+                                        - solution.plays() * game.rules.playCost;
+                results.proven[i] = solution.optimal;
+                results.solveSeconds[i] = solution.seconds;
+            }
+
+            for (const int cell : options.script) {
+                if (game.finished()) {
+                    break;
+                }
+                game.click(cell);
+            }
+
+            while (!game.finished()) {
+                game.click(chooseCell(options.policy, game.board, random, cells));
+            }
+
+            results.scores[i] = game.score;
+            results.plays[i] = game.plays;
+        }
+    }
+}
+
+const char* policyName(const Policy policy) {
+    switch (policy) {
+        case Policy::Random:
+            return "random";
+        case Policy::First:
+            return "first";
+        case Policy::Greedy:
+            return "greedy";
+    }
+    return "";
+}
+
+double mean(const std::vector<int>& values) {
+    double total = 0.0;
+    for (const int value : values) {
+        total += value;
+    }
+    return total / static_cast<double>(values.size());
+}
+
+// Estatísticas de uma distribuição já ordenada, como um objeto JSON com a indentação dada.
+void writeDistribution(std::ostringstream& json, const std::vector<int>& sorted, const std::string& indent) {
+    const double average = mean(sorted);
+
+    double squares = 0.0;
+    for (const int value : sorted) {
+        squares += (value - average) * (value - average);
+    }
+
+    json << "{\n"
+         << indent << "  \"min\": " << sorted.front() << ",\n"
+         << indent << "  \"mean\": " << average << ",\n"
+         << indent << "  \"stddev\": " << std::sqrt(squares / static_cast<double>(sorted.size())) << ",\n"
+         << indent << "  \"p5\": " << percentile(sorted, 0.05) << ",\n"
+         << indent << "  \"p25\": " << percentile(sorted, 0.25) << ",\n"
+         << indent << "  \"median\": " << percentile(sorted, 0.5) << ",\n"
+         << indent << "  \"p75\": " << percentile(sorted, 0.75) << ",\n"
+         << indent << "  \"p95\": " << percentile(sorted, 0.95) << ",\n"
+         << indent << "  \"max\": " << sorted.back() << "\n"
+         << indent << "}";
+}
+
+bool writeReport(const SimulationOptions& options, const unsigned threads, const double seconds,
+                 GameResults results) {
+    std::vector<int>& scores = results.scores;
+    std::vector<int>& plays = results.plays;
+    const double games = static_cast<double>(scores.size());
+
+    // Quanto a política ficou abaixo da melhor pontuação, partida a partida.
+    std::vector<int> gaps;
+    if (options.solve) {
+        for (size_t i = 0; i < scores.size(); i++) {
+            gaps.push_back(results.bestScores[i] - scores[i]);
+        }
+        std::sort(gaps.begin(), gaps.end());
+        std::sort(results.bestScores.begin(), results.bestScores.end());
+    }
+
+    std::sort(scores.begin(), scores.end());
+    std::sort(plays.begin(), plays.end());
+
+    // Faixas de mesma largura entre a menor e a maior pontuação.
+    const int low = scores.front();
+    const int width = std::max(1, (scores.back() - low) / HISTOGRAM_BUCKETS + 1);
+    std::vector<long long> histogram(HISTOGRAM_BUCKETS, 0);
+    for (const int score : scores) {
+        histogram[(score - low) / width]++;
+    }
+    const int buckets = (scores.back() - low) / width + 1;
+
+    std::ostringstream json;
+    json << "{\n"
+         << "  \"games\": " << scores.size() << ",\n"
+         << "  \"columns\": " << options.columns << ",\n"
+         << "  \"rows\": " << options.rows << ",\n"
+         << "  \"policy\": \"" << policyName(options.policy) << "\",\n"
+         << "  \"script_clicks\": " << options.script.size() << ",\n"
+         << "  \"metric\": \"" << colorMetricName(options.metric) << "\",\n"
+         << "  \"mode\": \"" << (options.mode == EliminationMode::Connected ? "connected" : "global") << "\",\n"
+         << "  \"tolerance\": " << options.tolerance << ",\n"
+         << "  \"chain_multiplier\": " << options.rules.chainMultiplier << ",\n"
+         << "  \"play_cost\": " << options.rules.playCost << ",\n"
+         << "  \"seed\": " << options.seed << ",\n"
+         << "  \"threads\": " << threads << ",\n"
+         << "  \"score\": ";
+    writeDistribution(json, scores, "  ");
+    json << ",\n"
+         << "  \"score_histogram\": [\n";
+    for (int bucket = 0; bucket < buckets; bucket++) {
+        json << "    {\"from\": " << low + bucket * width << ", \"to\": " << low + (bucket + 1) * width - 1
+             << ", \"games\": " << histogram[bucket] << "}" << (bucket + 1 < buckets ? "," : "") << "\n";
+    }
+    json << "  ],\n"
+         << "  \"plays\": {\n"
+         << "    \"min\": " << plays.front() << ",\n"
+         << "    \"mean\": " << mean(plays) << ",\n"
+         << "    \"median\": " << percentile(plays, 0.5) << ",\n"
+         << "    \"max\": " << plays.back() << "\n"
+         << "  },\n";
+
+    if (options.solve) {
+        long long proven = 0;
+        double solveSeconds = 0.0;
+        for (size_t i = 0; i < scores.size(); i++) {
+            proven += results.proven[i];
+            solveSeconds += results.solveSeconds[i];
+        }
+
+        json << "  \"best_score\": ";
+        writeDistribution(json, results.bestScores, "  ");
+        json << ",\n"
+             << "  \"gap_to_best\": ";
+        writeDistribution(json, gaps, "  ");
+        json << ",\n"
+             << "  \"proven_optimal\": " << proven << ",\n"
+             << "  \"solve_ms_mean\": " << solveSeconds * 1000.0 / games << ",\n";
+    }
+
+    json << "  \"seconds\": " << seconds << ",\n"
+         << "  \"games_per_second\": " << (seconds > 0 ? games / seconds : 0.0) << "\n"
+         << "}\n";
+
+    if (options.output.empty()) {
+        std::cout << json.str();
+        return true;
+    }
+
+    std::ofstream file(options.output);
+    if (!file) {
+        std::cout << "Failed to write simulation report to " << options.output << std::endl;
+        return false;
+    }
+    file << json.str();
+
+    return static_cast<bool>(file);
+}
+
+int main(int argc, char** argv) {
+    SimulationOptions options;
+    if (!parseSimulationOptions(argc, argv, options)) {
+        return -1;
+    }
+
+    unsigned cores = options.threads;
+    if (cores == 0) {
+        cores = std::max(1u, std::thread::hardware_concurrency());
+    }
+    const unsigned threads = static_cast<unsigned>(std::min<long long>(cores, options.games));
+    // Uns quatro lotes por thread, para as que terminam antes ainda pegarem partidas das outras.
+    const long long batch = std::clamp<long long>(options.games / (threads * 4ll), 1, GAME_BATCH);
+
+    GameResults results;
+    results.scores.resize(options.games);
+    results.plays.resize(options.games);
+    if (options.solve) {
+        results.bestScores.resize(options.games);
+        results.proven.resize(options.games);
+        results.solveSeconds.resize(options.games);
+    }
+    std::atomic<long long> nextGame(0);
+
+    const unsigned solverThreads = std::max(1u, cores / threads);
+
+    const auto start = std::chrono::steady_clock::now();
+
+    std::vector<std::thread> workers;
+    workers.reserve(threads);
+    for (unsigned i = 0; i < threads; i++) {
+        workers.emplace_back(playGames, std::cref(options), batch, solverThreads, std::ref(nextGame),
+                             std::ref(results));
+    }
+    for (std::thread& worker : workers) {
+        worker.join();
+    }
+
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    return writeReport(options, threads, seconds, std::move(results)) ? 0 : -1;
+}
@@ -0,0 +1,546 @@
+#include "m3/solver.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <bitset>
+#include <chrono>
+#include <iostream>
+#include <mutex>
+#include <unordered_map>
+#include <unordered_set>
+
+#include "m3/work_stealing_pool.hpp"
+
+namespace {
+    // Um bit por célula do tabuleiro, na mesma ordem de Board::visibleBits.
+    using CellSet = std::vector<uint64_t>;
+
+    constexpr int MEMO_SHARDS = 64;
+    constexpr size_t MAX_MEMO_ENTRIES = 1 << 22;
+
+    // Só os estados até essa profundidade e com pelo menos tantas células viram tarefas do pool; abaixo
+    // disso dividir custa mais do que buscar.
+    constexpr int PARALLEL_DEPTH = 3;
+    constexpr int PARALLEL_MIN_CELLS = 24;
+
+    using Clock = std::chrono::steady_clock;
+
+    int lowestBit(const uint64_t word) {
+        return static_cast<int>(std::bitset<64>((word & (~word + 1)) - 1).count());
+    }
+
+    template <typename Visit>
+    void forEachCell(const CellSet& set, Visit visit) {
+        for (size_t word = 0; word < set.size(); word++) {
+            for (uint64_t rest = set[word]; rest != 0; rest &= rest - 1) {
+                visit(static_cast<int>(word * 64) + lowestBit(rest));
+            }
+        }
+    }
+
+    int countCells(const CellSet& set) {
+        int count = 0;
+        for (const uint64_t word : set) {
+            count += static_cast<int>(std::bitset<64>(word).count());
+        }
+        return count;
+    }
+
+    // Quantas células de set também estão em row.
+    int countCommon(const CellSet& set, const uint64_t* row) {
+        int count = 0;
+        for (size_t word = 0; word < set.size(); word++) {
+            count += static_cast<int>(std::bitset<64>(set[word] & row[word]).count());
+        }
+        return count;
+    }
+
+    bool isEmpty(const CellSet& set) {
+        return std::all_of(set.begin(), set.end(), [](const uint64_t word) { return word == 0; });
+    }
+
+    struct CellSetHash {
+        size_t operator()(const CellSet& set) const {
+            uint64_t hash = 0xCBF29CE484222325ull;
+            for (const uint64_t word : set) {
+                hash = (hash ^ word) * 0x100000001B3ull;
+                hash ^= hash >> 29;
+            }
+            return static_cast<size_t>(hash);
+        }
+    };
+
+    // Resultado guardado para um conjunto de células: o número exato de cliques, ou só um limite
+    // inferior quando a busca desistiu dele por não bater o melhor já conhecido.
+    struct MemoEntry {
+        int value = 0;
+        bool exact = false;
+    };
+
+    // Um clique e as células (ainda visíveis) que ele elimina.
+    struct Move {
+        int cell = 0;
+        int removed = 0;
+        CellSet remaining;
+    };
+
+    class Search {
+    public:
+        Search(const int words, const bool symmetric, std::vector<uint64_t> eliminates,
+               std::vector<uint64_t> eliminatedBy, WorkStealingPool& pool)
+            : words(words), symmetric(symmetric), eliminates(std::move(eliminates)),
+              eliminatedBy(std::move(eliminatedBy)), pool(pool) {}
+
+        // Não dá para provar nada além disso depois de deadline.
+        Clock::time_point deadline = Clock::time_point::max();
+        std::atomic<bool> timedOut{false};
+        std::atomic<long long> states{0};
+
+        // Menor número de cliques que limpa cells, se for menor que limit; senão um valor >= limit.
+        int solve(const CellSet& cells, int limit, int depth);
+
+        // Limite inferior guloso: células cujos conjuntos de cliques possíveis não se cruzam
+        // precisam cada uma de um clique diferente.
+        int lowerBound(const CellSet& cells) const;
+
+        // Grupos de células ligadas por "elimina" em qualquer direção; clicar em um grupo nunca
+        // muda outro.
+        std::vector<CellSet> components(const CellSet& cells) const;
+
+        // Os cliques que valem a pena em cells: os que eliminam a célula mais difícil de eliminar
+        // (todos, se a relação não for simétrica), sem repetir os que eliminam as mesmas células.
+        std::vector<Move> moves(const CellSet& cells) const;
+
+        // Cliques de uma solução de cells com value cliques, refazendo o caminho pela memória.
+        bool reconstruct(CellSet cells, int value, std::vector<int>& clicks);
+
+        // Melhores sequências gulosas, mantendo width estados por nível.
+        std::vector<int> beam(const CellSet& cells, int width);
+
+    private:
+        const uint64_t* eliminatesRow(const int cell) const { return &this->eliminates[static_cast<size_t>(cell) * words]; }
+
+        const uint64_t* eliminatedByRow(const int cell) const {
+            return &this->eliminatedBy[static_cast<size_t>(cell) * words];
+        }
+
+        bool lookup(const CellSet& cells, MemoEntry& entry);
+
+        void store(const CellSet& cells, int value, bool exact);
+
+        int words;
+        bool symmetric;
+        std::vector<uint64_t> eliminates;
+        std::vector<uint64_t> eliminatedBy;
+        WorkStealingPool& pool;
+
+        struct MemoShard {
+            std::mutex mutex;
+            std::unordered_map<CellSet, MemoEntry, CellSetHash> entries;
+        };
+        MemoShard memo[MEMO_SHARDS];
+    };
+
+    bool Search::lookup(const CellSet& cells, MemoEntry& entry) {
+        MemoShard& shard = this->memo[CellSetHash()(cells) % MEMO_SHARDS];
+        std::lock_guard<std::mutex> lock(shard.mutex);
+
+        const auto found = shard.entries.find(cells);
+        if (found == shard.entries.end()) {
+            return false;
+        }
+        entry = found->second;
+        return true;
+    }
+
+    void Search::store(const CellSet& cells, const int value, const bool exact) {
+        MemoShard& shard = this->memo[CellSetHash()(cells) % MEMO_SHARDS];
+        std::lock_guard<std::mutex> lock(shard.mutex);
+
+        const auto found = shard.entries.find(cells);
+        if (found == shard.entries.end()) {
+            if (shard.entries.size() < MAX_MEMO_ENTRIES / MEMO_SHARDS) {
+                shard.entries.emplace(cells, MemoEntry{value, exact});
+            }
+            return;
+        }
+
+        MemoEntry& entry = found->second;
+        if (!entry.exact && (exact || value > entry.value)) {
+            entry = MemoEntry{value, exact};
+        }
+    }
+
+    int Search::lowerBound(const CellSet& cells) const {
+        std::vector<int> candidates;
+        std::vector<int> ways;
+        forEachCell(cells, [&](const int cell) {
+            candidates.push_back(cell);
+            ways.push_back(countCommon(cells, eliminatedByRow(cell)));
+        });
+
+        // As células com menos formas de serem eliminadas primeiro bloqueiam menos das outras.
+        std::vector<int> order(candidates.size());
+        for (size_t i = 0; i < order.size(); i++) {
+            order[i] = static_cast<int>(i);
+        }
+        std::sort(order.begin(), order.end(), [&ways](const int a, const int b) {
+            return ways[a] != ways[b] ? ways[a] < ways[b] : a < b;
+        });
+
+        CellSet blocked(this->words, 0);
+        int bound = 0;
+        for (const int i : order) {
+            const int cell = candidates[i];
+            if ((blocked[cell / 64] >> (cell % 64)) & 1u) {
+                continue;
+            }
+            bound++;
+
+            // Quem divide um clique possível com essa célula não conta outra vez.
+            const uint64_t* clickers = eliminatedByRow(cell);
+            for (int word = 0; word < this->words; word++) {
+                for (uint64_t rest = clickers[word] & cells[word]; rest != 0; rest &= rest - 1) {
+                    const uint64_t* row = eliminatesRow(word * 64 + lowestBit(rest));
+                    for (int other = 0; other < this->words; other++) {
+                        blocked[other] |= row[other];
+                    }
+                }
+            }
+        }
+        return bound;
+    }
+
+    std::vector<CellSet> Search::components(const CellSet& cells) const {
+        std::vector<CellSet> result;
+        CellSet left = cells;
+
+        for (size_t start = 0; start < left.size(); start++) {
+            while (left[start] != 0) {
+                CellSet component(this->words, 0);
+                CellSet frontier(this->words, 0);
+                const int first = static_cast<int>(start * 64) + lowestBit(left[start]);
+                frontier[first / 64] = uint64_t(1) << (first % 64);
+
+                while (!isEmpty(frontier)) {
+                    CellSet next(this->words, 0);
+                    forEachCell(frontier, [&](const int cell) {
+                        const uint64_t* out = eliminatesRow(cell);
+                        const uint64_t* in = eliminatedByRow(cell);
+                        for (int word = 0; word < this->words; word++) {
+                            next[word] |= out[word] | in[word];
+                        }
+                    });
+
+                    for (int word = 0; word < this->words; word++) {
+                        component[word] |= frontier[word];
+                        frontier[word] = next[word] & left[word] & ~component[word];
+                    }
+                }
+
+                for (int word = 0; word < this->words; word++) {
+                    left[word] &= ~component[word];
+                }
+                result.push_back(std::move(component));
+            }
+        }
+        return result;
+    }
+
+    std::vector<Move> Search::moves(const CellSet& cells) const {
+        CellSet clickers = cells;
+
+        if (this->symmetric) {
+            int hardest = -1;
+            int fewest = 0;
+            forEachCell(cells, [&](const int cell) {
+                const int ways = countCommon(cells, eliminatedByRow(cell));
+                if (hardest < 0 || ways < fewest) {
+                    hardest = cell;
+                    fewest = ways;
+                }
+            });
+
+            const uint64_t* row = eliminatedByRow(hardest);
+            for (int word = 0; word < this->words; word++) {
+                clickers[word] = cells[word] & row[word];
+            }
+        }
+
+        std::vector<Move> result;
+        std::unordered_set<CellSet, CellSetHash> seen;
+        forEachCell(clickers, [&](const int cell) {
+            Move move;
+            move.cell = cell;
+            move.remaining = cells;
+
+            const uint64_t* row = eliminatesRow(cell);
+            for (int word = 0; word < this->words; word++) {
+                move.removed += static_cast<int>(std::bitset<64>(cells[word] & row[word]).count());
+                move.remaining[word] &= ~row[word];
+            }
+
+            if (seen.insert(move.remaining).second) {
+                result.push_back(std::move(move));
+            }
+        });
+
+        // Os cliques que eliminam mais primeiro acham soluções boas mais cedo e podam o resto.
+        std::stable_sort(result.begin(), result.end(), [](const Move& a, const Move& b) {
+            return a.removed > b.removed;
+        });
+        return result;
+    }
+
+    int Search::solve(const CellSet& cells, const int limit, const int depth) {
+        if (this->timedOut || Clock::now() >= this->deadline) {
+            this->timedOut = true;
+            return limit;
+        }
+        this->states++;
+
+        if (isEmpty(cells)) {
+            return 0;
+        }
+
+        MemoEntry entry;
+        int bound = 0;
+        if (lookup(cells, entry)) {
+            if (entry.exact || entry.value >= limit) {
+                return entry.value;
+            }
+            bound = entry.value;
+        }
+
+        bound = std::max(bound, lowerBound(cells));
+        if (bound >= limit) {
+            store(cells, bound, false);
+            return bound;
+        }
+
+        // Componentes independentes somam; cada um só precisa caber no que sobra do limite depois
+        // dos limites inferiores dos outros.
+        std::vector<CellSet> parts = components(cells);
+        if (parts.size() > 1) {
+            std::vector<int> bounds(parts.size());
+            int rest = 0;
+            for (size_t i = 0; i < parts.size(); i++) {
+                bounds[i] = lowerBound(parts[i]);
+                rest += bounds[i];
+            }
+
+            int total = 0;
+            bool exact = true;
+            for (size_t i = 0; i < parts.size(); i++) {
+                rest -= bounds[i];
+                const int partLimit = limit - total - rest;
+                const int value = solve(parts[i], partLimit, depth);
+                total += value;
+                if (value >= partLimit) {
+                    exact = false;
+                    total += rest;
+                    break;
+                }
+            }
+
+            store(cells, total, exact && total < limit);
+            return total;
+        }
+
+        const std::vector<Move> candidates = moves(cells);
+        std::atomic<int> best(limit);
+
+        const auto tryMove = [this, &best, bound, depth](const Move& move) {
+            const int current = best;
+            if (current <= bound) {
+                return;
+            }
+
+            const int value = 1 + solve(move.remaining, current - 1, depth + 1);
+            int previous = best;
+            while (value < previous && !best.compare_exchange_weak(previous, value)) {
+            }
+        };
+
+        if (depth < PARALLEL_DEPTH && this->pool.size() > 1 && countCells(cells) >= PARALLEL_MIN_CELLS) {
+            TaskGroup group;
+            for (const Move& move : candidates) {
+                this->pool.spawn(group, [&tryMove, &move] { tryMove(move); });
+            }
+            this->pool.wait(group);
+        } else {
+            for (const Move& move : candidates) {
+                tryMove(move);
+            }
+        }
+
+        const int value = best;
+        store(cells, value, value < limit);
+        return value;
+    }
+
+    bool Search::reconstruct(CellSet cells, int value, std::vector<int>& clicks) {
+        clicks.clear();
+
+        while (value > 0) {
+            bool found = false;
+            for (const Move& move : moves(cells)) {
+                if (solve(move.remaining, value, PARALLEL_DEPTH) == value - 1) {
+                    clicks.push_back(move.cell);
+                    cells = move.remaining;
+                    value--;
+                    found = true;
+                    break;
+                }
+            }
+
+            if (!found) {
+                return false;
+            }
+        }
+        return isEmpty(cells);
+    }
+
+    std::vector<int> Search::beam(const CellSet& cells, const int width) {
+        struct BeamState {
+            CellSet visible;
+            std::vector<int> clicks;
+            int remaining = 0;
+        };
+
+        std::vector<BeamState> states(1);
+        states[0].visible = cells;
+        states[0].remaining = countCells(cells);
+
+        while (true) {
+            for (const BeamState& state : states) {
+                if (state.remaining == 0) {
+                    return state.clicks;
+                }
+            }
+
+            // Cada estado guarda seus width melhores filhos; os estados são expandidos em paralelo.
+            std::vector<std::vector<BeamState>> children(states.size());
+            TaskGroup group;
+            for (size_t i = 0; i < states.size(); i++) {
+                this->pool.spawn(group, [this, &states, &children, i, width] {
+                    const BeamState& parent = states[i];
+                    std::vector<std::pair<int, int>> gains;
+                    forEachCell(parent.visible, [&](const int cell) {
+                        gains.emplace_back(countCommon(parent.visible, eliminatesRow(cell)), cell);
+                    });
+
+                    const size_t keep = std::min(gains.size(), static_cast<size_t>(width));
+                    std::partial_sort(gains.begin(), gains.begin() + keep, gains.end(),
+                                      [](const std::pair<int, int>& a, const std::pair<int, int>& b) {
+                                          return a.first != b.first ? a.first > b.first : a.second < b.second;
+                                      });
+
+                    for (size_t k = 0; k < keep; k++) {
+                        BeamState child;
+                        child.visible = parent.visible;
+                        const uint64_t* row = eliminatesRow(gains[k].second);
+                        for (int word = 0; word < this->words; word++) {
+                            child.visible[word] &= ~row[word];
+                        }
+                        child.clicks = parent.clicks;
+                        child.clicks.push_back(gains[k].second);
+                        child.remaining = parent.remaining - gains[k].first;
+                        children[i].push_back(std::move(child));
+                    }
+                });
+            }
+            this->pool.wait(group);
+
+            std::vector<BeamState> next;
+            for (std::vector<BeamState>& list : children) {
+                for (BeamState& child : list) {
+                    next.push_back(std::move(child));
+                }
+            }
+            std::stable_sort(next.begin(), next.end(), [](const BeamState& a, const BeamState& b) {
+                return a.remaining < b.remaining;
+            });
+
+            states.clear();
+            std::unordered_set<CellSet, CellSetHash> seen;
+            for (BeamState& child : next) {
+                if (static_cast<int>(states.size()) == width) {
+                    break;
+                }
+                if (seen.insert(child.visible).second) {
+                    states.push_back(std::move(child));
+                }
+            }
+        }
+    }
+}
+
+bool solveBoard(Board& board, const SolverOptions& options, Solution& solution) {
+    const Clock::time_point start = Clock::now();
+    const int cells = board.cells();
+
+    if (cells > MAX_SOLVER_CELLS) {
+        std::cout << "Failed to solve board: " << cells << " cells (max " << MAX_SOLVER_CELLS << ")" << std::endl;
+        return false;
+    }
+
+    // Matriz "c elimina j" e sua transposta, montadas pelas prévias do próprio tabuleiro, para o
+    // solver seguir qualquer métrica, tolerância e modo.
+    const int words = static_cast<int>(board.visibleBits.size());
+    std::vector<uint64_t> eliminates(static_cast<size_t>(cells) * words, 0);
+    std::vector<uint64_t> eliminatedBy(static_cast<size_t>(cells) * words, 0);
+
+    std::vector<int> removed;
+    for (int cell = 0; cell < cells; cell++) {
+        if (!board.visible(cell)) {
+            continue;
+        }
+
+        board.preview(cell, removed);
+        for (const int other : removed) {
+            eliminates[static_cast<size_t>(cell) * words + other / 64] |= uint64_t(1) << (other % 64);
+            eliminatedBy[static_cast<size_t>(other) * words + cell / 64] |= uint64_t(1) << (cell % 64);
+        }
+    }
+
+    const bool symmetric = eliminates == eliminatedBy;
+    const CellSet visible = board.visibleBits;
+
+    WorkStealingPool pool(options.threads);
+    Search search(words, symmetric, std::move(eliminates), std::move(eliminatedBy), pool);
+
+    solution = Solution();
+    pool.run([&] {
+        solution.clicks = search.beam(visible, std::max(1, options.beamWidth));
+    });
+    solution.lowerBound = search.lowerBound(visible);
+
+    if (options.seconds > 0.0 && solution.lowerBound < solution.plays()) {
+        search.deadline = start + std::chrono::duration_cast<Clock::duration>(
+                                      std::chrono::duration<double>(options.seconds));
+
+        int value = 0;
+        pool.run([&] {
+            value = search.solve(visible, solution.plays(), 0);
+        });
+
+        // Sem estourar o tempo, um valor >= plays prova que a busca em feixe já era ótima.
+        if (!search.timedOut) {
+            solution.lowerBound = std::min(value, solution.plays());
+
+            std::vector<int> clicks;
+            if (value < solution.plays()) {
+                search.deadline = Clock::time_point::max();
+                if (search.reconstruct(visible, value, clicks)) {
+                    solution.clicks = clicks;
+                }
+            }
+        }
+        solution.states = search.states;
+    }
+
+    solution.optimal = solution.lowerBound == solution.plays();
+    solution.seconds = std::chrono::duration<double>(Clock::now() - start).count();
+    return true;
+}
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <vector>
+
+#include "m3/board.hpp"
+
+// Acima disso a matriz de semelhança (células² bits, duas vezes) não cabe com folga na memória.
+constexpr int MAX_SOLVER_CELLS = 20000;
+
+constexpr int DEFAULT_BEAM_WIDTH = 16;
+constexpr double DEFAULT_SOLVER_SECONDS = 1.0;
+
+struct SolverOptions {
+    // Threads da busca exata e da busca em feixe (0 usa uma por núcleo).
+    unsigned threads = 0;
+    // Tempo da busca exata; ao estourar fica a melhor solução conhecida com um limite inferior.
+    // 0 roda só a busca em feixe.
+    double seconds = DEFAULT_SOLVER_SECONDS;
+    int beamWidth = DEFAULT_BEAM_WIDTH;
+};
+
+struct Solution {
+    // Cliques da melhor sequência encontrada, em ordem.
+    std::vector<int> clicks;
+    // Nenhuma sequência limpa o tabuleiro com menos cliques que isso.
+    int lowerBound = 0;
+    // Se clicks.size() == lowerBound foi provado.
+    bool optimal = false;
+    // Estados visitados pela busca exata.
+    long long states = 0;
+    double seconds = 0.0;
+
+    int plays() const { return static_cast<int>(this->clicks.size()); }
+};
+
+// Menor número de cliques que limpa as células visíveis do tabuleiro, na métrica, tolerância e
+// modo atuais. Como cada célula é eliminada uma única vez, a pontuação final é sempre
+// visíveis * chainMultiplier - cliques * playCost: achar a melhor pontuação é achar menos cliques.
+//
+// Os cliques de uma partida formam um conjunto dominante independente do grafo "c elimina j": cada
+// célula some por algum clique e nenhum clique acontece em uma célula já eliminada. A busca
+// exata separa esse grafo em componentes (grupos de células que não interferem entre si), resolve
+// cada um à parte e memoriza os resultados pelo bitset das células restantes. Em cada estado ela
+// escolhe a célula com menos formas de ser eliminada e ramifica só nos cliques que a eliminam,
+// pulando cliques que eliminariam exatamente as mesmas células. Os ramos rasos são divididos
+// entre as threads de um WorkStealingPool.
+//
+// Antes dela uma busca em feixe dá a solução inicial; em tabuleiros grandes, em que a busca
+// exata não termina no tempo dado, é ela que fica, junto com o limite inferior.
+//
+// O tabuleiro não muda, mas pode ter as regiões rotuladas de novo. Falha com mais de
+// MAX_SOLVER_CELLS células.
+bool solveBoard(Board& board, const SolverOptions& options, Solution& solution);
@@ -0,0 +1,127 @@
+#include "m3/work_stealing_pool.hpp"
+
+namespace {
+    // Qual fila é da thread atual, ou -1 fora do pool.
+    thread_local int currentQueue = -1;
+}
+
+WorkStealingPool::WorkStealingPool(unsigned int threads) {
+    if (threads == 0) {
+        threads = std::thread::hardware_concurrency();
+    }
+    if (threads == 0) {
+        threads = 1;
+    }
+
+    for (unsigned int i = 0; i < threads; i++) {
+        this->queues.push_back(std::make_unique<Queue>());
+    }
+    for (unsigned int i = 1; i < threads; i++) {
+        this->workers.emplace_back([this, i] { work(i); });
+    }
+}
+
+WorkStealingPool::~WorkStealingPool() {
+    {
+        std::lock_guard<std::mutex> lock(this->idleMutex);
+        this->stopping = true;
+    }
+    this->taskAvailable.notify_all();
+
+    for (std::thread& worker : this->workers) {
+        worker.join();
+    }
+}
+
+void WorkStealingPool::run(const std::function<void()>& root) {
+    const int previous = currentQueue;
+    currentQueue = 0;
+
+    TaskGroup group;
+    spawn(group, root);
+    wait(group);
+
+    currentQueue = previous;
+}
+
+void WorkStealingPool::spawn(TaskGroup& group, std::function<void()> task) {
+    group.pending++;
+
+    Queue& queue = *this->queues[currentQueue];
+    {
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        queue.jobs.push_back(Job{std::move(task), &group});
+    }
+
+    // Ninguém dorme enquanto há tarefas nas filas, então só a primeira precisa acordar as threads. O
+    // mutex garante que uma thread que acabou de ver as filas vazias já esteja esperando o aviso.
+    if (this->queued++ <= 0) {
+        std::lock_guard<std::mutex> lock(this->idleMutex);
+        this->taskAvailable.notify_all();
+    }
+}
+
+void WorkStealingPool::wait(TaskGroup& group) {
+    Job job;
+    while (group.pending > 0) {
+        if (take(currentQueue, job)) {
+            execute(job);
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(this->idleMutex);
+        this->taskAvailable.wait(lock, [this, &group] { return this->queued > 0 || group.pending == 0; });
+    }
+}
+
+void WorkStealingPool::work(const unsigned int index) {
+    currentQueue = static_cast<int>(index);
+
+    Job job;
+    while (!this->stopping) {
+        if (take(index, job)) {
+            execute(job);
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(this->idleMutex);
+        this->taskAvailable.wait(lock, [this] { return this->stopping || this->queued > 0; });
+    }
+}
+
+bool WorkStealingPool::take(const unsigned int index, Job& job) {
+    {
+        Queue& own = *this->queues[index];
+        std::lock_guard<std::mutex> lock(own.mutex);
+        if (!own.jobs.empty()) {
+            job = std::move(own.jobs.back());
+            own.jobs.pop_back();
+            this->queued--;
+            return true;
+        }
+    }
+
+    const unsigned int count = size();
+    for (unsigned int offset = 1; offset < count; offset++) {
+        Queue& victim = *this->queues[(index + offset) % count];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if (!victim.jobs.empty()) {
+            job = std::move(victim.jobs.front());
+            victim.jobs.pop_front();
+            this->queued--;
+            return true;
+        }
+    }
+    return false;
+}
+
+void WorkStealingPool::execute(Job& job) {
+    job.work();
+    job.work = nullptr;
+
+    // Quem espera o grupo pode estar dormindo sem tarefas para pegar.
+    if (--job.group->pending == 0) {
+        std::lock_guard<std::mutex> lock(this->idleMutex);
+        this->taskAvailable.notify_all();
+    }
+}
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Tarefas que esperam umas pelas outras: quem chama wait(group) continua executando tarefas até
+// todas as do grupo terminarem, e só dorme quando não há nenhuma para pegar.
+struct TaskGroup {
+    std::atomic<int> pending{0};
+};
+
+// Pool de threads com uma fila por thread. Cada uma empilha e desempilha as próprias tarefas pelo
+// fim (a mais recente, ainda quente na cache) e, sem trabalho, rouba a mais antiga de outra fila.
+// Serve para buscas recursivas, em que cada tarefa cria outras e espera por elas.
+//
+// A thread que chama run() trabalha como a thread 0; as outras threads - 1 são criadas pelo pool.
+class WorkStealingPool {
+public:
+    // 0 usa uma thread por núcleo.
+    explicit WorkStealingPool(unsigned int threads = 0);
+
+    ~WorkStealingPool();
+
+    WorkStealingPool(const WorkStealingPool&) = delete;
+    WorkStealingPool& operator=(const WorkStealingPool&) = delete;
+
+    // Executa root e tudo o que ela criar, e só volta quando terminar.
+    void run(const std::function<void()>& root);
+
+    // Só pode ser chamada de dentro de uma tarefa.
+    void spawn(TaskGroup& group, std::function<void()> task);
+
+    void wait(TaskGroup& group);
+
+    unsigned int size() const { return static_cast<unsigned int>(this->queues.size()); }
+
+private:
+    struct Job {
+        std::function<void()> work;
+        TaskGroup* group = nullptr;
+    };
+
+    struct Queue {
+        std::mutex mutex;
+        std::deque<Job> jobs;
+    };
+
+    void work(unsigned int index);
+
+    // Pega uma tarefa da própria fila ou rouba de outra; false se todas estão vazias.
+    bool take(unsigned int index, Job& job);
+
+    void execute(Job& job);
+
+    std::vector<std::unique_ptr<Queue>> queues;
+    std::vector<std::thread> workers;
+
+    // Tarefas nas filas, para as threads ociosas saberem quando vale procurar.
+    std::atomic<int> queued{0};
+    std::atomic<bool> stopping{false};
+
+    // Threads sem tarefa dormem aqui; spawn() acorda quando as filas deixam de estar vazias, e
+    // execute() quando um grupo termina.
+    std::mutex idleMutex;
+    std::condition_variable taskAvailable;
+};
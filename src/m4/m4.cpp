@@ -3,21 +3,36 @@
 #include <glad.h>
 
 #include <algorithm>
+#include <cstring>
 #include <iostream>
+#include <memory>
 #include <string>
+#include <thread>
+#include <vector>
 
 #include "GLFW/glfw3.h"
 #include "glm/gtx/transform.hpp"
 #include "glm/gtc/type_ptr.hpp"
 
-#define STB_IMAGE_IMPLEMENTATION
-#include <stb_image.h>
-
 #include "glm/gtx/matrix_factorisation.hpp"
 
+#include "renderer/async_texture_loader.hpp"
+#include "renderer/gl_state.hpp"
+#include "renderer/profiler.hpp"
+#include "renderer/render_context.hpp"
+#include "renderer/shader.hpp"
+#include "renderer/software_rasterizer.hpp"
+#include "renderer/sprite_batch.hpp"
+#include "renderer/sprite_mesh.hpp"
+#include "renderer/texture.hpp"
+#include "renderer/texture_atlas.hpp"
+#include "renderer/uniform_buffer.hpp"
+
 class Sprite {
 public:
-    GLuint textureId = 0;
+    AtlasRegion region;
+    // Polígono em volta dos texels visíveis; vazio desenha o quad inteiro.
+    SpriteMesh mesh;
 
     float x = 0;
     float y = 0;
@@ -36,6 +51,9 @@ constexpr int WIDTH = 800;
 constexpr int HEIGHT = 600;
 
 constexpr int PARALLAX_LAYERS = 6;
+constexpr int CHARACTER_IMAGE = PARALLAX_LAYERS;
+constexpr int PARALLAX_TEXTURE_UNIT = 1;
+constexpr auto CHARACTER_FILE = "../assets/m4/character.png";
 
 constexpr float MAX_CHARACTER_Y = 304.0f;
 constexpr float MIN_CHARACTER_Y = 285.0f;
@@ -44,33 +62,91 @@ constexpr float MIN_CHARACTER_X = 0.0f;
 
 Sprite character;
 
-constexpr auto vertexShaderSource = R"GLSL(
- #version 400
- layout (location = 0) in vec3 position;
+// Cada cópia do personagem é desenhada deslocada dele; --scale troca as três cópias do exercício
+// por N espalhadas pela tela.
+std::vector<glm::vec2> characterOffsets = {
+    glm::vec2(0.0f, 0.0f),
+    glm::vec2(-50.0f, 25.0f),
+    glm::vec2(-50.0f, -25.0f),
+};
+
+// Só o personagem ganha mesh: as camadas rolam a textura dentro do quad, então a parte opaca delas
+// muda de lugar a cada frame. --sprite-quads desliga o mesh para comparar.
+bool spriteMeshes = true;
+
+// Com o modo de passada única todas as camadas vêm de uma GL_TEXTURE_2D_ARRAY e são compostas
+// em um só fragment shader; a tecla P volta para o modo antigo, com uma passada por camada.
+bool singlePassParallax = true;
+
+constexpr auto vertexShaderSource = " #version 400\n" FRAME_UNIFORM_BLOCK_GLSL R"GLSL(
+ layout (location = 0) in vec2 position;
  layout (location = 1) in vec2 texc;
+ layout (location = 2) in vec4 color;
+ layout (location = 3) in vec4 region;
  out vec2 tex_coord;
-
- uniform mat4 projection;
- uniform mat4 model;
+ out vec4 tint;
+ flat out vec4 tex_region;
 
  void main()
  {
 	tex_coord = vec2(texc.s, texc.t);
-	gl_Position = projection * model * vec4(position, 1.0);
+	tint = color;
+	tex_region = region;
+	gl_Position = projection * vec4(position, 0.0, 1.0);
  }
  )GLSL";
 
 constexpr auto fragmentShaderSource = R"GLSL(
  #version 400
  in vec2 tex_coord;
+ in vec4 tint;
+ flat in vec4 tex_region;
  out vec4 color;
  uniform sampler2D tex_buff;
 
-uniform vec2 offset;
+ void main()
+ {
+	 color = texture(tex_buff, tex_region.xy + fract(tex_coord) * tex_region.zw) * tint;
+ }
+ )GLSL";
+
+// Usa o mesmo layout de vértice do SpriteBatch, então o quad das camadas passa pelo batch.
+constexpr auto parallaxVertexShaderSource = " #version 400\n" FRAME_UNIFORM_BLOCK_GLSL R"GLSL(
+ layout (location = 0) in vec2 position;
+ layout (location = 1) in vec2 texc;
+ out vec2 tex_coord;
 
  void main()
  {
-	 color = texture(tex_buff, vec2(tex_coord.x + offset.x, tex_coord.y + offset.y));
+	tex_coord = vec2(texc.s, texc.t);
+	gl_Position = projection * vec4(position, 0.0, 1.0);
+ }
+ )GLSL";
+
+// Compõe as camadas da frente para trás e para assim que o pixel fica opaco. A saída não é
+// pré-multiplicada para o blend GL_SRC_ALPHA/GL_ONE_MINUS_SRC_ALPHA de sempre dar o mesmo
+// resultado das passadas separadas.
+constexpr auto parallaxFragmentShaderSource = R"GLSL(
+ #version 400
+ #define MAX_PARALLAX_LAYERS 16
+ in vec2 tex_coord;
+ out vec4 color;
+ uniform sampler2DArray layers;
+ uniform int layerCount;
+ uniform vec2 offsets[MAX_PARALLAX_LAYERS];
+
+ void main()
+ {
+	 vec3 premultiplied = vec3(0.0);
+	 float alpha = 0.0;
+
+	 for (int i = layerCount - 1; i >= 0 && alpha < 0.999; i--) {
+		 vec4 layer = texture(layers, vec3(tex_coord + offsets[i], float(i)));
+		 premultiplied += (1.0 - alpha) * layer.a * layer.rgb;
+		 alpha += (1.0 - alpha) * layer.a;
+	 }
+
+	 color = alpha > 0.0 ? vec4(premultiplied / alpha, alpha) : vec4(0.0);
  }
  )GLSL";
 
@@ -92,140 +168,57 @@ void process_input(GLFWwindow *window) {
     }
 }
 
-GLuint compileShader(const char *shaderSource, int shaderType) {
-    const GLuint shaderId = glCreateShader(shaderType);
-    glShaderSource(shaderId, 1, &shaderSource, nullptr);
-    glCompileShader(shaderId);
+// O quad antigo do setupSprite ia de -1 a 1 com a coordenada t invertida, por isso o tamanho dobrado
+// e o retângulo de UV de cabeça para baixo. O deslocamento de textura vira parte do retângulo de UV.
+void drawSprite(SpriteBatch &batch, const Sprite &sprite, float xTexOffset, float yTexOffset) {
+    const glm::vec2 position = glm::vec2(sprite.x, sprite.y);
+    const glm::vec2 size = glm::vec2(sprite.scaleX, sprite.scaleY) * 2.0f;
+    const glm::vec4 uvRect = glm::vec4(xTexOffset, yTexOffset + 1.0f, xTexOffset + 1.0f, yTexOffset);
 
-    int success;
-    glGetShaderiv(shaderId, GL_COMPILE_STATUS, &success);
-
-    if (!success) {
-        char infoLog[512];
-        glGetShaderInfoLog(shaderId, sizeof(infoLog), nullptr, infoLog);
-        std::cout << "ERROR::SHADER::COMPILATION_FAILED\n"
-                << infoLog << std::endl;
+    if (!sprite.mesh.vertices.empty()) {
+        batch.draw(sprite.region, sprite.mesh, position, sprite.rotation, size, uvRect);
+    } else {
+        batch.draw(sprite.region, position, sprite.rotation, size, uvRect);
     }
-
-    return shaderId;
 }
 
-GLuint createShaderProgram() {
-    const GLuint vertexShader =
-            compileShader(vertexShaderSource, GL_VERTEX_SHADER);
-    const GLuint fragmentShader =
-            compileShader(fragmentShaderSource, GL_FRAGMENT_SHADER);
-
-    const GLuint shaderProgram = glCreateProgram();
-    glAttachShader(shaderProgram, vertexShader);
-    glAttachShader(shaderProgram, fragmentShader);
-    glLinkProgram(shaderProgram);
-
-    int success;
-    glGetProgramiv(shaderProgram, GL_LINK_STATUS, &success);
-    if (!success) {
-        char infoLog[512];
-        glGetProgramInfoLog(shaderProgram, sizeof(infoLog), nullptr, infoLog);
-        std::cout << "ERROR::SHADER::PROGRAM::LINKING_FAILED\n"
-                << infoLog << std::endl;
+std::vector<std::string> parallaxLayerFiles() {
+    std::vector<std::string> files;
+    for (int i = 0; i < PARALLAX_LAYERS; i++) {
+        files.push_back("../assets/m4/" + std::to_string(i) + ".png");
     }
-
-    glDeleteShader(vertexShader);
-    glDeleteShader(fragmentShader);
-
-    return shaderProgram;
+    return files;
 }
 
-GLuint createVBOAndBind(const GLuint VAO, const float *vertices, const int verticesLength) {
-    GLuint VBO;
-    glGenBuffers(1, &VBO);
-    glBindVertexArray(VAO);
-
-    glBindBuffer(GL_ARRAY_BUFFER, VBO);
-    glBufferData(GL_ARRAY_BUFFER, verticesLength * sizeof(float), vertices, GL_STATIC_DRAW);
-
-    return VBO;
-}
-
-GLuint setupSprite(float size) {
-    GLuint VAO;
-    glGenVertexArrays(1, &VAO);
-
-    GLfloat vertices[] = {
-        // x     y     z     s     t
-        -1.0f, 1.0f, 0.0f, 0.0f, 0.0f,
-        -1.0f, -1.0f, 0.0f, 0.0f, 1.0f,
-        1.0f, 1.0f, 0.0f, 1.0f, 0.0f,
-        1.0f, -1.0f, 0.0f, 1.0f, 1.0f
-    };
-
-    for (int i = 0; i < sizeof(vertices) / sizeof(vertices[0]); i++) {
-        vertices[i] *= size;
+// As camadas ocupam as posições 0..PARALLAX_LAYERS-1 do atlas e o personagem vem logo depois.
+// As imagens são decodificadas fora da thread de renderização e o atlas só é montado quando
+// pendingImages chega a zero.
+void requestSpriteAtlasImages(AsyncTextureLoader &loader, std::vector<Image> &images, int &pendingImages) {
+    std::vector<std::string> files = parallaxLayerFiles();
+    files.push_back(CHARACTER_FILE);
+
+    images.resize(files.size());
+    pendingImages = static_cast<int>(files.size());
+
+    for (size_t i = 0; i < files.size(); i++) {
+        loader.decode(files[i], [&images, &pendingImages, i](Image &image) {
+            images[i] = std::move(image);
+            pendingImages--;
+        });
     }
-
-    createVBOAndBind(VAO, vertices, sizeof(vertices) / sizeof(vertices[0]));
-
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 5 * sizeof(float), (void *) 0);
-    glEnableVertexAttribArray(0);
-
-    glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 5 * sizeof(GLfloat), (GLvoid *) (3 * sizeof(GLfloat)));
-    glEnableVertexAttribArray(1);
-
-    glBindBuffer(GL_ARRAY_BUFFER, 0);
-    glBindVertexArray(0);
-
-    return VAO;
 }
 
-GLuint loadTexture(const std::string &filePath) {
-    GLuint texID;
-
-    glGenTextures(1, &texID);
-    glBindTexture(GL_TEXTURE_2D, texID);
-
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-
-    int width, height, nrChannels;
-
-    unsigned char *data = stbi_load(filePath.c_str(), &width, &height, &nrChannels, 0);
-
-    if (data) {
-        if (nrChannels == 3) {
-            glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, width, height, 0, GL_RGB, GL_UNSIGNED_BYTE, data);
-        } else // png
-        {
-            glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, data);
-        }
-        glGenerateMipmap(GL_TEXTURE_2D);
-    } else {
-        std::cout << "Failed to load texture" << std::endl;
+void buildSpriteAtlas(TextureAtlas &atlas, std::vector<Image> &images) {
+    if (spriteMeshes) {
+        character.mesh = loadSpriteMeshes(CHARACTER_FILE, images[CHARACTER_IMAGE]).front();
     }
 
-    stbi_image_free(data);
-
-    glBindTexture(GL_TEXTURE_2D, 0);
-
-    return texID;
-}
-
-
-void drawSprite(const GLuint modelLoc, const GLuint offsetLoc, const Sprite &sprite, float xTexOffset,
-                float yTexOffset) {
-    glBindTexture(GL_TEXTURE_2D, sprite.textureId);
-
-    auto model = glm::mat4(1);
-
-    model = glm::translate(model, glm::vec3(sprite.x, sprite.y, 0.0));
-    model = glm::rotate(model, sprite.rotation, glm::vec3(0, 0, 1));
-    model = glm::scale(model, glm::vec3(sprite.scaleX, sprite.scaleY, 1.0f));
+    for (Image &image : images) {
+        atlas.add(std::move(image));
+    }
+    images.clear();
 
-    glUniform2f(offsetLoc, xTexOffset, yTexOffset);
-    glUniformMatrix4fv(modelLoc, 1,GL_FALSE, value_ptr(model));
-    glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+    atlas.build();
 }
 
 void generateParallaxLayers(ParallaxLayer (&parallaxLayers)[6]) {
@@ -236,8 +229,6 @@ void generateParallaxLayers(ParallaxLayer (&parallaxLayers)[6]) {
         pl.scaleX = WIDTH / 1.8f;
         pl.scaleY = HEIGHT / 1.8f;
         pl.offsetSpeed = (float) i / 16.0f;
-        pl.textureId = loadTexture("../assets/m4/" + std::to_string(i) + ".png");
-        glTexParameteri(pl.textureId, GL_TEXTURE_WRAP_S, GL_REPEAT);
 
         parallaxLayers[i] = pl;
     }
@@ -249,100 +240,247 @@ void generateCharacter() {
     character.scaleX = 25.0f;
     character.scaleY = 25.0f;
     character.rotation = glm::radians(170.0f);
-    character.textureId = loadTexture("../assets/m4/character.png");
 }
 
-void drawCharacter(GLint offsetLoc, GLint modelLoc, float xModifier, float yModifier) {
+void scatterCharacters(const int count) {
+    characterOffsets.clear();
+    for (int i = 0; i < count; i++) {
+        characterOffsets.emplace_back(rand() % WIDTH - WIDTH / 2, rand() % HEIGHT - HEIGHT / 2);
+    }
+}
+
+void assignAtlasRegions(ParallaxLayer (&parallaxLayers)[6], const TextureAtlas &atlas) {
+    for (int i = 0; i < PARALLAX_LAYERS; i++) {
+        parallaxLayers[i].region = atlas.region(i);
+    }
+    character.region = atlas.region(CHARACTER_IMAGE);
+}
+
+glm::vec2 parallaxOffset(const ParallaxLayer &layer, double currentTime) {
+    return glm::vec2(
+        (-currentTime + character.x / 1500) * layer.offsetSpeed,
+        (character.y - HEIGHT / 2) / 100 * layer.offsetSpeed
+    );
+}
+
+// Todas as camadas compartilham posição, escala e rotação, então um único quad cobre todas.
+void drawParallaxSinglePass(SpriteBatch &batch, GLuint parallaxProgram, GLint offsetsLoc,
+                            const ParallaxLayer (&parallaxLayers)[6], double currentTime) {
+    glm::vec2 offsets[PARALLAX_LAYERS];
+    for (int i = 0; i < PARALLAX_LAYERS; i++) {
+        offsets[i] = parallaxOffset(parallaxLayers[i], currentTime);
+    }
+
+    batch.setProgram(parallaxProgram);
+    useProgram(parallaxProgram);
+    glUniform2fv(offsetsLoc, PARALLAX_LAYERS, &offsets[0].x);
+
+    ParallaxLayer layer = parallaxLayers[0];
+    layer.region = AtlasRegion();
+    drawSprite(batch, layer, 0.0f, 0.0f);
+}
+
+void drawParallaxLayers(SpriteBatch &batch, GLuint shaderProgram, const ParallaxLayer (&parallaxLayers)[6],
+                        double currentTime) {
+    batch.setProgram(shaderProgram);
+
+    for (int i = 0; i < PARALLAX_LAYERS; i++) {
+        const glm::vec2 offset = parallaxOffset(parallaxLayers[i], currentTime);
+        drawSprite(batch, parallaxLayers[i], offset.x, offset.y);
+    }
+}
+
+void drawCharacter(SpriteBatch &batch, float xModifier, float yModifier) {
     character.x += xModifier;
     character.y += yModifier;
-    drawSprite(modelLoc, offsetLoc, character, 1.0f, 0.0f);
+    drawSprite(batch, character, 1.0f, 0.0f);
     character.x -= xModifier;
     character.y -= yModifier;
 }
 
-int main() {
-    glfwInit();
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
-    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
-
-    glfwWindowHint(GLFW_SAMPLES, 8);
-
-    GLFWwindow *window = glfwCreateWindow(WIDTH, HEIGHT, "M4 - Mapeamento de Texturas - Otávio", nullptr, nullptr);
-
-    if (window == nullptr) {
-        std::cout << "Failed to create GLFW window" << std::endl;
-        glfwTerminate();
+int main(int argc, char **argv) {
+    ContextOptions options;
+    if (!parseContextOptions(argc, argv, options)) {
         return -1;
     }
+    // A cena é animada: todo frame muda a tela inteira, então não há o que esperar no modo sob demanda.
+    options.onDemand = false;
 
-    glfwMakeContextCurrent(window);
+    for (int i = 1; i < argc; i++) {
+        if (std::strcmp(argv[i], "--sprite-quads") == 0) {
+            spriteMeshes = false;
+        }
+    }
 
-    if (!gladLoadGLLoader((GLADloadproc) glfwGetProcAddress)) {
-        std::cout << "Failed to initialize GLAD" << std::endl;
+    RenderContext context;
+    if (!context.create(WIDTH, HEIGHT, "M4 - Mapeamento de Texturas - Otávio", options, 8)) {
         return -1;
     }
 
-    glViewport(0, 0, WIDTH, HEIGHT);
-    glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
+    GLFWwindow *window = context.window;
+    srand(options.seed);
+
+    glViewport(0, 0, context.width, context.height);
+    if (window != nullptr) {
+        glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
+        glfwSetKeyCallback(window, [](GLFWwindow *window, int key, int scancode, int action, int mods) {
+            if (key == GLFW_KEY_P && action == GLFW_PRESS) {
+                singlePassParallax = !singlePassParallax;
+            }
+        });
+    }
 
-    const GLuint shaderProgram = createShaderProgram();
-    GLuint VAO = setupSprite(1);
+    const GLuint shaderProgram = createShaderProgram(vertexShaderSource, fragmentShaderSource);
+    const GLuint parallaxProgram = createShaderProgram(parallaxVertexShaderSource, parallaxFragmentShaderSource);
+    SpriteBatch batch;
+    batch.create();
 
     ParallaxLayer parallaxLayers[6];
     generateParallaxLayers(parallaxLayers);
     generateCharacter();
+    if (options.scale > 0) {
+        scatterCharacters(options.scale);
+    }
+
+    // Nada de imagem é carregado aqui: os primeiros frames já rodam enquanto as threads de
+    // trabalho decodificam, e cada parte da cena aparece quando as texturas dela ficam prontas.
+    AsyncTextureLoader loader;
+    const std::shared_ptr<AsyncTexture> parallaxTexture = loader.loadArray(parallaxLayerFiles());
+
+    TextureAtlas atlas;
+    atlas.keepPageImages = options.software;
+    bool atlasBuilt = false;
+    std::vector<Image> atlasImages;
+    int pendingAtlasImages = 0;
+    requestSpriteAtlasImages(loader, atlasImages, pendingAtlasImages);
+
+    // No benchmark todos os frames medidos precisam ter a cena completa, e no --golden as imagens não
+    // podem depender de quando cada textura terminou de carregar.
+    if (options.benchmark || !options.goldenDirectory.empty()) {
+        while (!loader.idle()) {
+            loader.pump();
+            std::this_thread::yield();
+        }
+    }
+
+    bindUniformBlocks(shaderProgram);
+    bindUniformBlocks(parallaxProgram);
 
-    glUseProgram(shaderProgram);
-    glActiveTexture(GL_TEXTURE0);
+    useProgram(shaderProgram);
     glUniform1i(glGetUniformLocation(shaderProgram, "tex_buff"), 0);
-    glEnable(GL_DEPTH_TEST);
-    glDepthFunc(GL_ALWAYS);
-    glEnable(GL_BLEND);
-    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-
-    GLint offsetLoc = glGetUniformLocation(shaderProgram, "offset");
-    GLint modelLoc = glGetUniformLocation(shaderProgram, "model");
-
-    glm::mat4 projection = glm::ortho(0.0f, (float) WIDTH, (float) HEIGHT, 0.0f, -1.0f, 1.0f);
-    glUniformMatrix4fv(
-        glGetUniformLocation(shaderProgram, "projection"),
-        1,
-        GL_FALSE,
-        value_ptr(projection)
-    );
+    setDepthTest(true);
+    setDepthFunc(GL_ALWAYS);
+    setBlending(true);
+    setBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+
+    FrameUniformBuffer frameUniformBuffer;
+    frameUniformBuffer.create();
+
+    FrameUniforms frameUniforms;
+    frameUniforms.projection = glm::ortho(0.0f, (float) WIDTH, (float) HEIGHT, 0.0f, -1.0f, 1.0f);
+
+    // Com --software os sprites do batch são rasterizados na CPU e a imagem pronta vai para o framebuffer.
+    std::unique_ptr<SoftwareRasterizer> software;
+    if (options.software) {
+        software = std::make_unique<SoftwareRasterizer>();
+        software->create(context.width, context.height);
+        software->setProjection(frameUniforms.projection);
+        batch.setSoftware(software.get());
+    }
 
-    while (!glfwWindowShouldClose(window)) {
-        glfwPollEvents();
-        process_input(window);
+    useProgram(parallaxProgram);
+    glUniform1i(glGetUniformLocation(parallaxProgram, "layers"), PARALLAX_TEXTURE_UNIT);
+    glUniform1i(glGetUniformLocation(parallaxProgram, "layerCount"), PARALLAX_LAYERS);
+    GLint offsetsLoc = glGetUniformLocation(parallaxProgram, "offsets");
 
-        glClearColor(0.2f, 0.3f, 0.3f, 1.0f);
-        glClear(GL_COLOR_BUFFER_BIT);
+    bindTexture(GL_TEXTURE_2D_ARRAY, parallaxTexture->textureId, PARALLAX_TEXTURE_UNIT);
 
-        glBindVertexArray(VAO);
-        double currentTime = glfwGetTime();
+    while (!context.shouldClose()) {
+        PROFILE_ZONE("frame");
 
-        for (int i = 0; i < PARALLAX_LAYERS; i++) {
-            ParallaxLayer layer = parallaxLayers[i];
+        {
+            PROFILE_ZONE("input");
+            context.pollEvents();
+            if (window != nullptr) {
+                process_input(window);
+            }
+        }
 
-            drawSprite(modelLoc, offsetLoc, layer,
-                       (-currentTime + character.x / 1500) * layer.offsetSpeed,
-                       (character.y - HEIGHT / 2) / 100 * layer.offsetSpeed
-            );
+        {
+            PROFILE_ZONE("loading");
+            loader.pump();
+
+            if (!atlasBuilt && pendingAtlasImages == 0) {
+                buildSpriteAtlas(atlas, atlasImages);
+                assignAtlasRegions(parallaxLayers, atlas);
+                atlasBuilt = true;
+
+                for (size_t i = 0; software && i < atlas.pages().size(); i++) {
+                    software->addTexture(atlas.pages()[i], atlas.pageImages()[i]);
+                }
+            }
         }
 
-        character.y += 10 * sin(currentTime);
-        drawCharacter(offsetLoc, modelLoc, 0, 0);
-        drawCharacter(offsetLoc, modelLoc, -50, 25);
-        drawCharacter(offsetLoc, modelLoc, -50, -25);
-        character.y -= 10 * sin(currentTime);
+        double currentTime = context.time();
 
-        glfwSwapBuffers(window);
-    }
+        {
+            PROFILE_ZONE("update");
+            frameUniforms.time = static_cast<float>(currentTime);
+            frameUniformBuffer.update(frameUniforms);
+        }
+
+        {
+            PROFILE_GPU_ZONE("draw");
+            if (software) {
+                software->clear(glm::vec4(0.2f, 0.3f, 0.3f, 1.0f));
+            } else {
+                glClearColor(0.2f, 0.3f, 0.3f, 1.0f);
+                glClear(GL_COLOR_BUFFER_BIT);
+            }
+
+            batch.begin(shaderProgram);
+
+            // A passada única depende do fragment shader das camadas: na CPU elas vão uma por uma.
+            if (singlePassParallax && !software) {
+                if (parallaxTexture->ready()) {
+                    drawParallaxSinglePass(batch, parallaxProgram, offsetsLoc, parallaxLayers, currentTime);
+                }
+            } else if (atlasBuilt) {
+                drawParallaxLayers(batch, shaderProgram, parallaxLayers, currentTime);
+            }
+
+            if (atlasBuilt) {
+                batch.setProgram(shaderProgram);
+                character.y += 10 * sin(currentTime);
+                for (const glm::vec2 &offset : characterOffsets) {
+                    drawCharacter(batch, offset.x, offset.y);
+                }
+                character.y -= 10 * sin(currentTime);
+            }
+
+            batch.end();
+
+            if (software) {
+                software->present(context.framebuffer());
+            }
+        }
 
-    glDeleteVertexArrays(1, &VAO);
-    glDeleteProgram(shaderProgram);
+        context.swapBuffers();
+    }
 
-    glfwTerminate();
-    return 0;
+    if (software) {
+        software->destroy();
+    }
+    batch.destroy();
+    atlas.destroy();
+    loader.destroy();
+    frameUniformBuffer.destroy();
+    deleteTexture(parallaxTexture->textureId);
+    deleteProgram(parallaxProgram);
+    deleteProgram(shaderProgram);
+
+    context.writeBenchmarkReport("m4", PARALLAX_LAYERS + static_cast<long long>(characterOffsets.size()));
+    const bool goldenPassed = context.checkGoldenImages("m4");
+    context.destroy();
+    return goldenPassed ? 0 : 1;
 }
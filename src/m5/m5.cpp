@@ -3,23 +3,33 @@
 #include <glad.h>
 
 #include <algorithm>
+#include <cstring>
 #include <iostream>
+#include <memory>
 #include <string>
+#include <vector>
 
 #include "GLFW/glfw3.h"
 #include "glm/gtx/transform.hpp"
 #include "glm/gtc/type_ptr.hpp"
 
-#define STB_IMAGE_IMPLEMENTATION
-#include <stb_image.h>
-
 #include "glm/gtx/matrix_factorisation.hpp"
 
+#include "renderer/gl_state.hpp"
+#include "renderer/profiler.hpp"
+#include "renderer/render_context.hpp"
+#include "renderer/shader.hpp"
+#include "renderer/software_rasterizer.hpp"
+#include "renderer/sprite_batch.hpp"
+#include "renderer/sprite_mesh.hpp"
+#include "renderer/texture.hpp"
+#include "renderer/texture_atlas.hpp"
+#include "renderer/uniform_buffer.hpp"
+
 class Sprite {
 public:
-    GLuint VAO = 0;
-    GLuint textureId = 0;
-
+    AtlasRegion region;
+    glm::vec4 uvRect = glm::vec4(0.0f, 0.0f, 1.0f, 1.0f);
 
     float x = 0;
     float y = 0;
@@ -27,24 +37,14 @@ public:
     float scaleX = 1.0f;
     float scaleY = 1.0f;
 
-    glm::mat4 processModel() {
-        auto model = glm::mat4(1);
-
-        model = glm::translate(model, glm::vec3(this->x, this->y, 0.0));
-        model = glm::rotate(model, this->rotation, glm::vec3(0, 0, 1));
-        model = glm::scale(model, glm::vec3(this->scaleX, this->scaleY, 1.0f));
-
-        return model;
-    }
-
-    void draw(const GLuint modelLoc, const GLuint offsetLoc) {
-        auto model = processModel();
-
-        glBindVertexArray(this->VAO);
-        glBindTexture(GL_TEXTURE_2D, this->textureId);
-        glUniformMatrix4fv(modelLoc, 1,GL_FALSE, value_ptr(model));
-        glUniform2f(offsetLoc,0,0);
-        glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+    void draw(SpriteBatch &batch) {
+        batch.draw(
+            this->region,
+            glm::vec2(this->x, this->y),
+            this->rotation,
+            glm::vec2(this->scaleX, this->scaleY),
+            this->uvRect
+        );
     }
 };
 
@@ -69,6 +69,10 @@ public:
 
     bool isIdle = true;
 
+    // Um polígono por quadro da spritesheet, na ordem do buildSpriteMeshes (uma linha por quadro da
+    // animação, uma coluna por direção). Sem ele o quadro é desenhado como o quad inteiro.
+    const std::vector<SpriteMesh> *meshes = nullptr;
+
     void changeDirection(Direction direction) {
         this->isIdle = false;
 
@@ -80,18 +84,28 @@ public:
         animationFrame = 0;
     }
 
-    void draw(const GLuint modelLoc, const GLuint offsetLoc) {
-        auto model = processModel();
-
-        glBindVertexArray(this->VAO);
-        glBindTexture(GL_TEXTURE_2D, this->textureId);
-        glUniform2f(
-            offsetLoc,
+    void draw(SpriteBatch &batch) {
+        const glm::vec2 offset = glm::vec2(
             directionOffset.x * (float) this->direction + this->animationOffset.x * (float) this->animationFrame,
             directionOffset.y * (float) this->direction + this->animationOffset.y * (float) this->animationFrame
         );
-        glUniformMatrix4fv(modelLoc, 1,GL_FALSE, value_ptr(model));
-        glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+
+        const glm::vec4 frameRect = glm::vec4(
+            this->uvRect.x + offset.x,
+            this->uvRect.y + offset.y,
+            this->uvRect.z + offset.x,
+            this->uvRect.w + offset.y
+        );
+
+        if (this->meshes != nullptr) {
+            const SpriteMesh &mesh = (*this->meshes)[this->animationFrame * DIRECTIONS + this->direction];
+            batch.draw(this->region, mesh, glm::vec2(this->x, this->y), this->rotation,
+                       glm::vec2(this->scaleX, this->scaleY), frameRect);
+            return;
+        }
+
+        batch.draw(this->region, glm::vec2(this->x, this->y), this->rotation, glm::vec2(this->scaleX, this->scaleY),
+                   frameRect);
     }
 };
 
@@ -99,35 +113,43 @@ constexpr int WIDTH = 800;
 constexpr int HEIGHT = 600;
 constexpr int FPS = 4;
 
+constexpr int BACKGROUND_IMAGE = 0;
+constexpr int CHARACTER_IMAGE = 1;
+
 AnimatableSprite character;
 
-constexpr auto vertexShaderSource = R"GLSL(
- #version 400
- layout (location = 0) in vec3 position;
+// Com --sprite-quads o personagem volta a ser desenhado como o quad inteiro, para comparar.
+bool spriteMeshes = true;
+
+constexpr auto vertexShaderSource = " #version 400\n" FRAME_UNIFORM_BLOCK_GLSL R"GLSL(
+ layout (location = 0) in vec2 position;
  layout (location = 1) in vec2 texc;
+ layout (location = 2) in vec4 color;
+ layout (location = 3) in vec4 region;
  out vec2 tex_coord;
-
- uniform mat4 projection;
- uniform mat4 model;
+ out vec4 tint;
+ flat out vec4 tex_region;
 
  void main()
  {
 	tex_coord = vec2(texc.s, texc.t);
-	gl_Position = projection * model * vec4(position, 1.0);
+	tint = color;
+	tex_region = region;
+	gl_Position = projection * vec4(position, 0.0, 1.0);
  }
  )GLSL";
 
 constexpr auto fragmentShaderSource = R"GLSL(
  #version 400
  in vec2 tex_coord;
+ in vec4 tint;
+ flat in vec4 tex_region;
  out vec4 color;
  uniform sampler2D tex_buff;
 
-uniform vec2 offset;
-
  void main()
  {
-	 color = texture(tex_buff, vec2(tex_coord.x + offset.x, tex_coord.y + offset.y));
+	 color = texture(tex_buff, tex_region.xy + fract(tex_coord) * tex_region.zw) * tint;
  }
  )GLSL";
 
@@ -155,234 +177,196 @@ void process_input(GLFWwindow *window) {
     }
 }
 
-GLuint compileShader(const char *shaderSource, int shaderType) {
-    const GLuint shaderId = glCreateShader(shaderType);
-    glShaderSource(shaderId, 1, &shaderSource, nullptr);
-    glCompileShader(shaderId);
-
-    int success;
-    glGetShaderiv(shaderId, GL_COMPILE_STATUS, &success);
-
-    if (!success) {
-        char infoLog[512];
-        glGetShaderInfoLog(shaderId, sizeof(infoLog), nullptr, infoLog);
-        std::cout << "ERROR::SHADER::COMPILATION_FAILED\n"
-                << infoLog << std::endl;
-    }
-
-    return shaderId;
-}
-
-GLuint createShaderProgram() {
-    const GLuint vertexShader =
-            compileShader(vertexShaderSource, GL_VERTEX_SHADER);
-    const GLuint fragmentShader =
-            compileShader(fragmentShaderSource, GL_FRAGMENT_SHADER);
-
-    const GLuint shaderProgram = glCreateProgram();
-    glAttachShader(shaderProgram, vertexShader);
-    glAttachShader(shaderProgram, fragmentShader);
-    glLinkProgram(shaderProgram);
-
-    int success;
-    glGetProgramiv(shaderProgram, GL_LINK_STATUS, &success);
-    if (!success) {
-        char infoLog[512];
-        glGetProgramInfoLog(shaderProgram, sizeof(infoLog), nullptr, infoLog);
-        std::cout << "ERROR::SHADER::PROGRAM::LINKING_FAILED\n"
-                << infoLog << std::endl;
-    }
-
-    glDeleteShader(vertexShader);
-    glDeleteShader(fragmentShader);
-
-    return shaderProgram;
-}
-
-GLuint createVBOAndBind(const GLuint VAO, const float *vertices, const int verticesLength) {
-    GLuint VBO;
-    glGenBuffers(1, &VBO);
-    glBindVertexArray(VAO);
-
-    glBindBuffer(GL_ARRAY_BUFFER, VBO);
-    glBufferData(GL_ARRAY_BUFFER, verticesLength * sizeof(float), vertices, GL_STATIC_DRAW);
-
-    return VBO;
-}
-
-GLuint setupSprite(float size, int frames, int directions) {
-    GLuint VAO;
-    glGenVertexArrays(1, &VAO);
-
-    float framesOffset = 1.0f / (float) frames;
-    float directionOffset = 1.0f / (float) directions;
-
-    GLfloat vertices[] = {
-        // x     y     z     s     t
-        -0.5,  0.5, 0.0, 0.0, directionOffset, //V0
-        -0.5, -0.5, 0.0, 0.0, 0.0, //V1
-         0.5,  0.5, 0.0, framesOffset, directionOffset, //V2
-         0.5, -0.5, 0.0, framesOffset, 0.0  //V3
-    };
-
-    for (float & vertice : vertices) {
-        vertice *= size;
-    }
-
-    createVBOAndBind(VAO, vertices, std::size(vertices));
-
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 5 * sizeof(float), (void *) 0);
-    glEnableVertexAttribArray(0);
-
-    glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 5 * sizeof(GLfloat), (GLvoid *) (3 * sizeof(GLfloat)));
-    glEnableVertexAttribArray(1);
-
-    glBindBuffer(GL_ARRAY_BUFFER, 0);
-    glBindVertexArray(0);
-
-    return VAO;
+// Retângulo de UV do primeiro quadro de uma spritesheet com `frames` colunas e `directions` linhas.
+glm::vec4 spriteSheetFrame(int frames, int directions) {
+    return glm::vec4(0.0f, 0.0f, 1.0f / (float) frames, 1.0f / (float) directions);
 }
 
-GLuint loadTexture(const std::string &filePath) {
-    GLuint texID;
-
-    glGenTextures(1, &texID);
-    glBindTexture(GL_TEXTURE_2D, texID);
-
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-
-    int width, height, nrChannels;
-
-    unsigned char *data = stbi_load(filePath.c_str(), &width, &height, &nrChannels, 0);
-
-    if (data) {
-        if (nrChannels == 3) {
-            glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, width, height, 0, GL_RGB, GL_UNSIGNED_BYTE, data);
-        } else // png
-        {
-            glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, data);
-        }
-        glGenerateMipmap(GL_TEXTURE_2D);
-    } else {
-        std::cout << "Failed to load texture" << std::endl;
-    }
+// O fundo é opaco e fica com o quad; a spritesheet do personagem ganha um polígono por quadro,
+// guardado em character.png.mesh.
+std::vector<SpriteMesh> loadSpriteAtlas(TextureAtlas &atlas, const int frames, const int directions) {
+    const std::string characterFile = "../assets/m5/character.png";
+    Image characterImage;
+    loadImage(characterFile, characterImage);
+    std::vector<SpriteMesh> meshes = loadSpriteMeshes(characterFile, characterImage, directions, frames);
 
-    stbi_image_free(data);
+    atlas.add("../assets/m5/background.png");
+    atlas.add(std::move(characterImage));
 
-    glBindTexture(GL_TEXTURE_2D, 0);
+    atlas.build();
 
-    return texID;
+    return meshes;
 }
 
-void generateCharacter() {
+void generateCharacter(const TextureAtlas &atlas, const std::vector<SpriteMesh> &meshes) {
     character.x = (float) WIDTH / 2;
     character.y = (float) HEIGHT / 2;
     character.scaleX = 35;
     character.scaleY = 35;
-    character.textureId = loadTexture("../assets/m5/character.png");
+    character.region = atlas.region(CHARACTER_IMAGE);
 
-    character.VAO = setupSprite(1, 4, 4);
+    character.uvRect = spriteSheetFrame(4, 4);
+    if (spriteMeshes) {
+        character.meshes = &meshes;
+    }
 }
 
-Sprite generateBackground() {
+Sprite generateBackground(const TextureAtlas &atlas) {
     Sprite sprite;
     sprite.x = WIDTH / 2;
     sprite.y = HEIGHT / 2;
     sprite.scaleX = WIDTH;
     sprite.scaleY = HEIGHT;
 
-    sprite.textureId = loadTexture("../assets/m5/background.png");
+    sprite.region = atlas.region(BACKGROUND_IMAGE);
 
-    sprite.VAO = setupSprite(1, 1, 1);
+    sprite.uvRect = spriteSheetFrame(1, 1);
 
     return sprite;
 }
 
-int main() {
-    glfwInit();
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
-    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
-
-    glfwWindowHint(GLFW_SAMPLES, 8);
+int main(int argc, char **argv) {
+    ContextOptions options;
+    if (!parseContextOptions(argc, argv, options)) {
+        return -1;
+    }
+    // A cena é animada: todo frame muda a tela inteira, então não há o que esperar no modo sob demanda.
+    options.onDemand = false;
 
-    GLFWwindow *window = glfwCreateWindow(WIDTH, HEIGHT, "M5 - Personagem com animação - Otávio", nullptr, nullptr);
+    for (int i = 1; i < argc; i++) {
+        if (std::strcmp(argv[i], "--sprite-quads") == 0) {
+            spriteMeshes = false;
+        }
+    }
 
-    if (window == nullptr) {
-        std::cout << "Failed to create GLFW window" << std::endl;
-        glfwTerminate();
+    RenderContext context;
+    if (!context.create(WIDTH, HEIGHT, "M5 - Personagem com animação - Otávio", options, 8)) {
         return -1;
     }
 
-    glfwMakeContextCurrent(window);
+    GLFWwindow *window = context.window;
+    srand(options.seed);
 
-    if (!gladLoadGLLoader((GLADloadproc) glfwGetProcAddress)) {
-        std::cout << "Failed to initialize GLAD" << std::endl;
-        return -1;
+    glViewport(0, 0, context.width, context.height);
+    if (window != nullptr) {
+        glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
     }
 
-    glViewport(0, 0, WIDTH, HEIGHT);
-    glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
+    const GLuint shaderProgram = createShaderProgram(vertexShaderSource, fragmentShaderSource);
+    TextureAtlas atlas;
+    atlas.keepPageImages = options.software;
+    const std::vector<SpriteMesh> characterMeshes = loadSpriteAtlas(atlas, character.animationLength, DIRECTIONS);
 
-    const GLuint shaderProgram = createShaderProgram();
-    Sprite background = generateBackground();
+    Sprite background = generateBackground(atlas);
 
+    SpriteBatch batch;
+    batch.create();
 
-    generateCharacter();
 
-    glUseProgram(shaderProgram);
-    glActiveTexture(GL_TEXTURE0);
-    glUniform1i(glGetUniformLocation(shaderProgram, "tex_buff"), 0);
-    glEnable(GL_DEPTH_TEST);
-    glDepthFunc(GL_ALWAYS);
-    glEnable(GL_BLEND);
-    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    generateCharacter(atlas, characterMeshes);
 
-    GLint offsetLoc = glGetUniformLocation(shaderProgram, "offset");
-    GLint modelLoc = glGetUniformLocation(shaderProgram, "model");
+    // --scale N desenha N personagens: o controlado pelo teclado e N - 1 cópias animadas junto com ele.
+    std::vector<glm::vec2> extraCharacters;
+    for (int i = 1; i < options.scale; i++) {
+        extraCharacters.emplace_back(rand() % WIDTH, rand() % HEIGHT);
+    }
 
-    glm::mat4 projection = glm::ortho((float) WIDTH, 0.0f,  0.0f, (float) HEIGHT, -1.0f, 1.0f);
-    glUniformMatrix4fv(
-        glGetUniformLocation(shaderProgram, "projection"),
-        1,
-        GL_FALSE,
-        value_ptr(projection)
-    );
+    bindUniformBlocks(shaderProgram);
 
-    double lastTime = glfwGetTime();
+    useProgram(shaderProgram);
+    glUniform1i(glGetUniformLocation(shaderProgram, "tex_buff"), 0);
+    setDepthTest(true);
+    setDepthFunc(GL_ALWAYS);
+    setBlending(true);
+    setBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+
+    FrameUniformBuffer frameUniformBuffer;
+    frameUniformBuffer.create();
+
+    FrameUniforms frameUniforms;
+    frameUniforms.projection = glm::ortho((float) WIDTH, 0.0f,  0.0f, (float) HEIGHT, -1.0f, 1.0f);
+
+    // Com --software os sprites do batch são rasterizados na CPU e a imagem pronta vai para o framebuffer.
+    std::unique_ptr<SoftwareRasterizer> software;
+    if (options.software) {
+        software = std::make_unique<SoftwareRasterizer>();
+        software->create(context.width, context.height);
+        software->setProjection(frameUniforms.projection);
+        for (size_t i = 0; i < atlas.pages().size(); i++) {
+            software->addTexture(atlas.pages()[i], atlas.pageImages()[i]);
+        }
+        batch.setSoftware(software.get());
+    }
 
-    while (!glfwWindowShouldClose(window)) {
-        glfwPollEvents();
-        process_input(window);
+    double lastTime = context.time();
 
-        glClearColor(0.2f, 0.3f, 0.3f, 1.0f);
-        glClear(GL_COLOR_BUFFER_BIT);
+    while (!context.shouldClose()) {
+        PROFILE_ZONE("frame");
 
-        double currentTime = glfwGetTime();
-        double deltaTime = currentTime - lastTime;
+        {
+            PROFILE_ZONE("input");
+            context.pollEvents();
+            if (window != nullptr) {
+                process_input(window);
+            }
+        }
 
-        if (deltaTime >= 1.0/FPS)
         {
-            character.animationFrame = !character.isIdle
-                ? (character.animationFrame + 1) % character.animationLength
-                : 0;
-            lastTime = currentTime;
+            PROFILE_ZONE("update");
+            double currentTime = context.time();
+            double deltaTime = currentTime - lastTime;
+
+            frameUniforms.time = static_cast<float>(currentTime);
+            frameUniformBuffer.update(frameUniforms);
+
+            if (deltaTime >= 1.0/FPS)
+            {
+                character.animationFrame = !character.isIdle
+                    ? (character.animationFrame + 1) % character.animationLength
+                    : 0;
+                lastTime = currentTime;
+            }
         }
 
-        background.draw(modelLoc, offsetLoc);
-        character.draw(modelLoc, offsetLoc);
+        {
+            PROFILE_GPU_ZONE("draw");
+            if (software) {
+                software->clear(glm::vec4(0.2f, 0.3f, 0.3f, 1.0f));
+            } else {
+                glClearColor(0.2f, 0.3f, 0.3f, 1.0f);
+                glClear(GL_COLOR_BUFFER_BIT);
+            }
+
+            batch.begin(shaderProgram);
+            background.draw(batch);
+            character.draw(batch);
+
+            for (const glm::vec2 &position : extraCharacters) {
+                AnimatableSprite copy = character;
+                copy.x = position.x;
+                copy.y = position.y;
+                copy.draw(batch);
+            }
+            batch.end();
+
+            if (software) {
+                software->present(context.framebuffer());
+            }
+        }
 
-        glfwSwapBuffers(window);
+        context.swapBuffers();
     }
 
-    glDeleteVertexArrays(1, &character.VAO);
-    glDeleteVertexArrays(1, &background.VAO);
-    glDeleteProgram(shaderProgram);
-
-    glfwTerminate();
-    return 0;
+    if (software) {
+        software->destroy();
+    }
+    batch.destroy();
+    atlas.destroy();
+    frameUniformBuffer.destroy();
+    deleteProgram(shaderProgram);
+
+    context.writeBenchmarkReport("m5", 2 + static_cast<long long>(extraCharacters.size()));
+    const bool goldenPassed = context.checkGoldenImages("m5");
+    context.destroy();
+    return goldenPassed ? 0 : 1;
 }
@@ -0,0 +1,235 @@
+#include "renderer/async_texture_loader.hpp"
+
+#include <cstring>
+#include <iostream>
+
+#include "renderer/gl_state.hpp"
+#include "renderer/profiler.hpp"
+
+namespace {
+    constexpr unsigned char PLACEHOLDER_PIXEL[4] = {0, 0, 0, 0};
+
+    void setTextureParameters(const GLenum target) {
+        glTexParameteri(target, GL_TEXTURE_WRAP_S, GL_REPEAT);
+        glTexParameteri(target, GL_TEXTURE_WRAP_T, GL_REPEAT);
+
+        glTexParameteri(target, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri(target, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    }
+
+    bool fenceSignaled(const GLsync fence) {
+        const GLenum status = glClientWaitSync(fence, 0, 0);
+        return status == GL_ALREADY_SIGNALED || status == GL_CONDITION_SATISFIED;
+    }
+}
+
+AsyncTextureLoader::AsyncTextureLoader(const unsigned int threads) : workers(threads) {
+}
+
+std::shared_ptr<AsyncTexture> AsyncTextureLoader::load(const std::string& filePath) {
+    auto texture = std::make_shared<AsyncTexture>();
+    texture->target = GL_TEXTURE_2D;
+    texture->pendingImages = 1;
+
+    glGenTextures(1, &texture->textureId);
+    bindTexture(GL_TEXTURE_2D, texture->textureId);
+    setTextureParameters(GL_TEXTURE_2D);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, 1, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, PLACEHOLDER_PIXEL);
+
+    DecodedImage request;
+    request.texture = texture;
+    request.filePath = filePath;
+    enqueue(std::move(request));
+
+    return texture;
+}
+
+std::shared_ptr<AsyncTexture> AsyncTextureLoader::loadArray(const std::vector<std::string>& filePaths) {
+    auto texture = std::make_shared<AsyncTexture>();
+    texture->target = GL_TEXTURE_2D_ARRAY;
+    texture->layers = static_cast<int>(filePaths.size());
+    texture->pendingImages = texture->layers;
+
+    const std::vector<unsigned char> placeholder(static_cast<size_t>(texture->layers) * 4, 0);
+
+    glGenTextures(1, &texture->textureId);
+    bindTexture(GL_TEXTURE_2D_ARRAY, texture->textureId);
+    setTextureParameters(GL_TEXTURE_2D_ARRAY);
+    glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_RGBA8, 1, 1, texture->layers, 0, GL_RGBA, GL_UNSIGNED_BYTE,
+                 placeholder.data());
+
+    for (size_t i = 0; i < filePaths.size(); i++) {
+        DecodedImage request;
+        request.texture = texture;
+        request.layer = static_cast<int>(i);
+        request.filePath = filePaths[i];
+        enqueue(std::move(request));
+    }
+
+    return texture;
+}
+
+void AsyncTextureLoader::decode(const std::string& filePath, std::function<void(Image&)> onDecoded) {
+    DecodedImage request;
+    request.filePath = filePath;
+    request.onDecoded = std::move(onDecoded);
+    enqueue(std::move(request));
+}
+
+void AsyncTextureLoader::enqueue(DecodedImage request) {
+    this->inFlight++;
+
+    // std::function precisa de algo copiável, então o pedido vai num shared_ptr.
+    auto pending = std::make_shared<DecodedImage>(std::move(request));
+
+    this->workers.submit([this, pending] {
+        PROFILE_ZONE("decode image");
+        pending->decoded = loadImage(pending->filePath, pending->image);
+
+        std::lock_guard<std::mutex> lock(this->completedMutex);
+        this->completed.push_back(std::move(*pending));
+    });
+}
+
+void AsyncTextureLoader::pump(const size_t maxBytes) {
+    PROFILE_ZONE("texture uploads");
+
+    std::vector<DecodedImage> ready;
+    {
+        std::lock_guard<std::mutex> lock(this->completedMutex);
+        ready.swap(this->completed);
+    }
+
+    size_t uploadedBytes = 0;
+    size_t next = 0;
+
+    for (; next < ready.size(); next++) {
+        if (next > 0 && uploadedBytes >= maxBytes) {
+            break;
+        }
+
+        DecodedImage& request = ready[next];
+        uploadedBytes += request.image.pixels.size();
+
+        if (request.onDecoded) {
+            request.onDecoded(request.image);
+        } else {
+            upload(request);
+        }
+
+        this->inFlight--;
+    }
+
+    // O que passou do orçamento volta para a fila, na frente do que chegou enquanto isso.
+    if (next < ready.size()) {
+        std::lock_guard<std::mutex> lock(this->completedMutex);
+        this->completed.insert(this->completed.begin(), std::make_move_iterator(ready.begin() + next),
+                               std::make_move_iterator(ready.end()));
+    }
+}
+
+void AsyncTextureLoader::upload(DecodedImage& request) {
+    AsyncTexture& texture = *request.texture;
+    texture.pendingImages--;
+
+    if (!request.decoded) {
+        texture.failed = true;
+        return;
+    }
+
+    const Image& image = request.image;
+    const bool firstImage = texture.width == 0;
+
+    if (!firstImage && (image.width != texture.width || image.height != texture.height)) {
+        std::cout << "Failed to load texture array layer " << request.filePath << ": size mismatch" << std::endl;
+        texture.failed = true;
+        return;
+    }
+
+    const GLsizeiptr size = static_cast<GLsizeiptr>(image.pixels.size());
+    PixelBuffer& pixelBuffer = acquirePixelBuffer(size);
+
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, pixelBuffer.buffer);
+
+    // Se o mapeamento falhar (sem memória ou com o contexto perdido) o upload sai direto da imagem,
+    // sem o PBO e sem a cópia assíncrona.
+    GLuint unpackBuffer = pixelBuffer.buffer;
+    const void* pixels = nullptr;
+    if (void* destination = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, size,
+                                             GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT)) {
+        std::memcpy(destination, image.pixels.data(), image.pixels.size());
+        glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+    } else {
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+        unpackBuffer = 0;
+        pixels = image.pixels.data();
+    }
+
+    bindTexture(texture.target, texture.textureId);
+
+    // Com um PBO ligado o ponteiro de dados vira um offset dentro dele, e a cópia para a textura
+    // fica a cargo do driver sem travar esta thread.
+    if (texture.target == GL_TEXTURE_2D) {
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, image.width, image.height, 0, GL_RGBA, GL_UNSIGNED_BYTE, pixels);
+        glGenerateMipmap(GL_TEXTURE_2D);
+    } else {
+        if (firstImage) {
+            glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+            glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_RGBA8, image.width, image.height, texture.layers, 0,
+                         GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+            glBindBuffer(GL_PIXEL_UNPACK_BUFFER, unpackBuffer);
+        }
+        glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, 0, 0, request.layer, image.width, image.height, 1,
+                        GL_RGBA, GL_UNSIGNED_BYTE, pixels);
+    }
+
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+    if (unpackBuffer != 0) {
+        pixelBuffer.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    }
+
+    texture.width = image.width;
+    texture.height = image.height;
+}
+
+AsyncTextureLoader::PixelBuffer& AsyncTextureLoader::acquirePixelBuffer(const GLsizeiptr size) {
+    // Um PBO só pode ser reaproveitado depois que a GPU terminou de ler o upload anterior.
+    for (PixelBuffer& pixelBuffer : this->pixelBuffers) {
+        if (pixelBuffer.fence != nullptr) {
+            if (!fenceSignaled(pixelBuffer.fence)) {
+                continue;
+            }
+            glDeleteSync(pixelBuffer.fence);
+            pixelBuffer.fence = nullptr;
+        }
+
+        if (pixelBuffer.size < size) {
+            glBindBuffer(GL_PIXEL_UNPACK_BUFFER, pixelBuffer.buffer);
+            glBufferData(GL_PIXEL_UNPACK_BUFFER, size, nullptr, GL_STREAM_DRAW);
+            glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+            pixelBuffer.size = size;
+        }
+        return pixelBuffer;
+    }
+
+    PixelBuffer pixelBuffer;
+    glGenBuffers(1, &pixelBuffer.buffer);
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, pixelBuffer.buffer);
+    glBufferData(GL_PIXEL_UNPACK_BUFFER, size, nullptr, GL_STREAM_DRAW);
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    pixelBuffer.size = size;
+
+    this->pixelBuffers.push_back(pixelBuffer);
+    return this->pixelBuffers.back();
+}
+
+void AsyncTextureLoader::destroy() {
+    for (PixelBuffer& pixelBuffer : this->pixelBuffers) {
+        if (pixelBuffer.fence != nullptr) {
+            glDeleteSync(pixelBuffer.fence);
+        }
+        glDeleteBuffers(1, &pixelBuffer.buffer);
+    }
+    this->pixelBuffers.clear();
+}
@@ -0,0 +1,87 @@
+#pragma once
+
+#include <glad.h>
+
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "renderer/texture.hpp"
+#include "renderer/thread_pool.hpp"
+
+// Textura pedida ao AsyncTextureLoader. O id é válido desde o pedido: até o upload terminar ele
+// aponta para um placeholder transparente de 1x1, e depois para a imagem de verdade.
+struct AsyncTexture {
+    GLuint textureId = 0;
+    GLenum target = GL_TEXTURE_2D;
+    int width = 0;
+    int height = 0;
+    int layers = 1;
+
+    int pendingImages = 0;
+    bool failed = false;
+
+    bool ready() const { return this->pendingImages == 0; }
+};
+
+// Decodifica imagens em threads de trabalho e envia os pixels para a GPU por pixel buffer objects.
+// Todas as chamadas de OpenGL acontecem em pump(), que deve ser chamado uma vez por frame na
+// thread do contexto; os pedidos podem ser feitos a qualquer momento nessa mesma thread.
+class AsyncTextureLoader {
+public:
+    // 0 usa uma thread por núcleo.
+    explicit AsyncTextureLoader(unsigned int threads = 0);
+
+    // Mesmos parâmetros do loadTexture.
+    std::shared_ptr<AsyncTexture> load(const std::string& filePath);
+
+    // Mesmos parâmetros do loadTextureArray. O tamanho das camadas vem da primeira que chegar.
+    std::shared_ptr<AsyncTexture> loadArray(const std::vector<std::string>& filePaths);
+
+    // Só decodifica; onDecoded roda dentro do pump() com a imagem já pronta na CPU, ou vazia se
+    // a decodificação falhar.
+    void decode(const std::string& filePath, std::function<void(Image&)> onDecoded);
+
+    // Envia as imagens decodificadas até gastar maxBytes neste frame (sempre envia pelo menos uma).
+    void pump(size_t maxBytes = 16 * 1024 * 1024);
+
+    // Verdadeiro quando não há mais nada sendo decodificado nem esperando upload.
+    bool idle() const { return this->inFlight == 0; }
+
+    // Libera os PBOs. As texturas entregues continuam sendo de quem pediu.
+    void destroy();
+
+private:
+    struct DecodedImage {
+        std::shared_ptr<AsyncTexture> texture;
+        int layer = 0;
+        std::string filePath;
+        Image image;
+        bool decoded = false;
+        std::function<void(Image&)> onDecoded;
+    };
+
+    struct PixelBuffer {
+        GLuint buffer = 0;
+        GLsizeiptr size = 0;
+        GLsync fence = nullptr;
+    };
+
+    void enqueue(DecodedImage request);
+
+    void upload(DecodedImage& request);
+
+    PixelBuffer& acquirePixelBuffer(GLsizeiptr size);
+
+    std::vector<PixelBuffer> pixelBuffers;
+
+    std::mutex completedMutex;
+    std::vector<DecodedImage> completed;
+
+    int inFlight = 0;
+
+    // Declarado por último para as threads pararem antes do resto ser destruído.
+    ThreadPool workers;
+};
@@ -0,0 +1,74 @@
+#include "renderer/benchmark.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+namespace {
+    // Percentil pelo método do posto mais próximo, sobre tempos já ordenados.
+    double percentile(const std::vector<double>& sorted, const double fraction) {
+        if (sorted.empty()) {
+            return 0.0;
+        }
+        const size_t rank = static_cast<size_t>(std::ceil(fraction * static_cast<double>(sorted.size())));
+        return sorted[std::min(sorted.size(), std::max<size_t>(rank, 1)) - 1];
+    }
+}
+
+void FrameStats::record(const double seconds, const int drawCalls) {
+    this->frameTimes.push_back(seconds);
+    this->drawCalls += drawCalls;
+}
+
+bool FrameStats::write(const BenchmarkReport& report, const std::string& filePath) const {
+    std::vector<double> sorted = this->frameTimes;
+    std::sort(sorted.begin(), sorted.end());
+
+    double total = 0.0;
+    for (const double seconds : sorted) {
+        total += seconds;
+    }
+
+    const double frames = static_cast<double>(sorted.size());
+    const double mean = frames > 0 ? total / frames : 0.0;
+
+    std::ostringstream json;
+    json << "{\n"
+         << "  \"exercise\": \"" << report.exercise << "\",\n"
+         << "  \"objects\": " << report.objects << ",\n"
+         << "  \"scale\": " << report.scale << ",\n"
+         << "  \"seed\": " << report.seed << ",\n"
+         << "  \"width\": " << report.width << ",\n"
+         << "  \"height\": " << report.height << ",\n"
+         << "  \"headless\": " << (report.headless ? "true" : "false") << ",\n"
+         << "  \"warmup_frames\": " << BENCHMARK_WARMUP_FRAMES << ",\n"
+         << "  \"frames\": " << sorted.size() << ",\n"
+         << "  \"frame_time_ms\": {\n"
+         << "    \"min\": " << (sorted.empty() ? 0.0 : sorted.front()) * 1000.0 << ",\n"
+         << "    \"mean\": " << mean * 1000.0 << ",\n"
+         << "    \"median\": " << percentile(sorted, 0.5) * 1000.0 << ",\n"
+         << "    \"p95\": " << percentile(sorted, 0.95) * 1000.0 << ",\n"
+         << "    \"p99\": " << percentile(sorted, 0.99) * 1000.0 << ",\n"
+         << "    \"max\": " << (sorted.empty() ? 0.0 : sorted.back()) * 1000.0 << "\n"
+         << "  },\n"
+         << "  \"draw_calls_per_frame\": " << (frames > 0 ? static_cast<double>(this->drawCalls) / frames : 0.0) << ",\n"
+         << "  \"fps\": " << (total > 0 ? frames / total : 0.0) << ",\n"
+         << "  \"objects_per_second\": " << (total > 0 ? static_cast<double>(report.objects) * frames / total : 0.0) << "\n"
+         << "}\n";
+
+    if (filePath.empty()) {
+        std::cout << json.str();
+        return true;
+    }
+
+    std::ofstream file(filePath);
+    if (!file) {
+        std::cout << "Failed to write benchmark report to " << filePath << std::endl;
+        return false;
+    }
+    file << json.str();
+
+    return static_cast<bool>(file);
+}
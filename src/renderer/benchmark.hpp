@@ -0,0 +1,36 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+// Frames descartados no começo do modo benchmark (compilação de shaders, primeiros uploads).
+constexpr int BENCHMARK_WARMUP_FRAMES = 10;
+
+// Frames medidos no modo benchmark quando --frames não é informado.
+constexpr int BENCHMARK_DEFAULT_FRAMES = 500;
+
+struct BenchmarkReport {
+    std::string exercise;
+    long long objects = 0;
+    int scale = 0;
+    unsigned int seed = 0;
+    int width = 0;
+    int height = 0;
+    bool headless = false;
+};
+
+// Tempo e draw calls de cada frame medido.
+class FrameStats {
+public:
+    void record(double seconds, int drawCalls);
+
+    int frames() const { return static_cast<int>(this->frameTimes.size()); }
+
+    // JSON com min/mediana/p95/p99 do tempo de frame, draw calls por frame e vazão.
+    // Sem filePath o relatório vai para a saída padrão.
+    bool write(const BenchmarkReport& report, const std::string& filePath) const;
+
+private:
+    std::vector<double> frameTimes;
+    long long drawCalls = 0;
+};
@@ -0,0 +1,14 @@
+#include "renderer/buffer.hpp"
+
+#include "renderer/gl_state.hpp"
+
+GLuint createVBOAndBind(const GLuint VAO, const float* vertices, const int verticesLength) {
+    GLuint VBO;
+    glGenBuffers(1, &VBO);
+    bindVertexArray(VAO);
+
+    glBindBuffer(GL_ARRAY_BUFFER, VBO);
+    glBufferData(GL_ARRAY_BUFFER, verticesLength * sizeof(float), vertices, GL_STATIC_DRAW);
+
+    return VBO;
+}
@@ -0,0 +1,5 @@
+#pragma once
+
+#include <glad.h>
+
+GLuint createVBOAndBind(GLuint VAO, const float* vertices, int verticesLength);
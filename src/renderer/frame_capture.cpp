@@ -0,0 +1,269 @@
+#include "renderer/frame_capture.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+
+#include "renderer/profiler.hpp"
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define CAPTURE_USE_SSE2
+#endif
+
+namespace {
+    // BT.601 de faixa completa (Y e cor em 0-255, o XCOLORRANGE=FULL do cabeçalho; o C420jpeg só diz
+    // onde ficam as amostras de cor), em ponto fixo com 8 bits de fração. Nas diferenças de cor o
+    // deslocamento de 128 << 8 mantém a soma positiva antes do shift.
+    constexpr int LUMA_WEIGHTS[3] = {77, 150, 29};
+    constexpr int BLUE_WEIGHTS[3] = {-43, -85, 128};
+    constexpr int RED_WEIGHTS[3] = {128, -107, -21};
+    constexpr int LUMA_OFFSET = 128;
+    constexpr int CHROMA_OFFSET = (128 << 8) + 128;
+
+    unsigned char weighted(const unsigned char* rgba, const int (&weights)[3], const int offset) {
+        // Azul puro em U e vermelho puro em V dão 256: satura como o packus do caminho SSE2.
+        const int sum = weights[0] * rgba[0] + weights[1] * rgba[1] + weights[2] * rgba[2] + offset;
+        return static_cast<unsigned char>(std::min(sum >> 8, 255));
+    }
+
+    // Média arredondada para cima, a mesma do _mm_avg_epu8, para os dois caminhos darem o mesmo vídeo.
+    unsigned char average(const unsigned char a, const unsigned char b) {
+        return static_cast<unsigned char>((a + b + 1) >> 1);
+    }
+
+#ifdef CAPTURE_USE_SSE2
+    __m128i weightsVector(const int (&weights)[3]) {
+        return _mm_setr_epi16(static_cast<short>(weights[0]), static_cast<short>(weights[1]),
+                              static_cast<short>(weights[2]), 0, static_cast<short>(weights[0]),
+                              static_cast<short>(weights[1]), static_cast<short>(weights[2]), 0);
+    }
+
+    // Soma ponderada dos canais de 4 pixels RGBA8: o madd junta r com g e b com a, e as duas metades
+    // de cada pixel são somadas separando as posições pares e ímpares.
+    __m128i weightedSum(const __m128i pixels, const __m128i weights, const __m128i offset) {
+        const __m128i zero = _mm_setzero_si128();
+        const __m128 low = _mm_castsi128_ps(_mm_madd_epi16(_mm_unpacklo_epi8(pixels, zero), weights));
+        const __m128 high = _mm_castsi128_ps(_mm_madd_epi16(_mm_unpackhi_epi8(pixels, zero), weights));
+        const __m128i even = _mm_castps_si128(_mm_shuffle_ps(low, high, _MM_SHUFFLE(2, 0, 2, 0)));
+        const __m128i odd = _mm_castps_si128(_mm_shuffle_ps(low, high, _MM_SHUFFLE(3, 1, 3, 1)));
+        return _mm_srai_epi32(_mm_add_epi32(_mm_add_epi32(even, odd), offset), 8);
+    }
+#endif
+
+    void convertLumaRow(const unsigned char* source, unsigned char* destination, const int width) {
+        int x = 0;
+#ifdef CAPTURE_USE_SSE2
+        const __m128i weights = weightsVector(LUMA_WEIGHTS);
+        const __m128i offset = _mm_set1_epi32(LUMA_OFFSET);
+        for (; x + 8 <= width; x += 8) {
+            const __m128i first = _mm_loadu_si128(reinterpret_cast<const __m128i*>(source + x * 4));
+            const __m128i second = _mm_loadu_si128(reinterpret_cast<const __m128i*>(source + x * 4 + 16));
+            const __m128i words = _mm_packs_epi32(weightedSum(first, weights, offset),
+                                                  weightedSum(second, weights, offset));
+            _mm_storel_epi64(reinterpret_cast<__m128i*>(destination + x), _mm_packus_epi16(words, words));
+        }
+#endif
+        for (; x < width; x++) {
+            destination[x] = weighted(source + x * 4, LUMA_WEIGHTS, LUMA_OFFSET);
+        }
+    }
+
+    // Cada amostra de cor vem da média de um bloco 2x2 das linhas top e bottom.
+    void convertChromaRow(const unsigned char* top, const unsigned char* bottom, unsigned char* u,
+                          unsigned char* v, const int width) {
+        const int chromaWidth = (width + 1) / 2;
+        int x = 0;
+#ifdef CAPTURE_USE_SSE2
+        const __m128i blueWeights = weightsVector(BLUE_WEIGHTS);
+        const __m128i redWeights = weightsVector(RED_WEIGHTS);
+        const __m128i offset = _mm_set1_epi32(CHROMA_OFFSET);
+        for (; 2 * x + 8 <= width; x += 4) {
+            const int source = 2 * x * 4;
+            const __m128 first = _mm_castsi128_ps(
+                    _mm_avg_epu8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(top + source)),
+                                 _mm_loadu_si128(reinterpret_cast<const __m128i*>(bottom + source))));
+            const __m128 second = _mm_castsi128_ps(
+                    _mm_avg_epu8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(top + source + 16)),
+                                 _mm_loadu_si128(reinterpret_cast<const __m128i*>(bottom + source + 16))));
+            const __m128i blocks =
+                    _mm_avg_epu8(_mm_castps_si128(_mm_shuffle_ps(first, second, _MM_SHUFFLE(2, 0, 2, 0))),
+                                 _mm_castps_si128(_mm_shuffle_ps(first, second, _MM_SHUFFLE(3, 1, 3, 1))));
+
+            const __m128i words = _mm_packs_epi32(weightedSum(blocks, blueWeights, offset),
+                                                  weightedSum(blocks, redWeights, offset));
+            const __m128i bytes = _mm_packus_epi16(words, words);
+            const int blue = _mm_cvtsi128_si32(bytes);
+            const int red = _mm_cvtsi128_si32(_mm_srli_si128(bytes, 4));
+            std::memcpy(u + x, &blue, sizeof(blue));
+            std::memcpy(v + x, &red, sizeof(red));
+        }
+#endif
+        for (; x < chromaWidth; x++) {
+            const int left = 2 * x * 4;
+            const int right = std::min(2 * x + 1, width - 1) * 4;
+
+            unsigned char block[4];
+            for (int channel = 0; channel < 3; channel++) {
+                block[channel] = average(average(top[left + channel], bottom[left + channel]),
+                                         average(top[right + channel], bottom[right + channel]));
+            }
+            u[x] = weighted(block, BLUE_WEIGHTS, CHROMA_OFFSET);
+            v[x] = weighted(block, RED_WEIGHTS, CHROMA_OFFSET);
+        }
+    }
+
+    // Planos Y, U e V de um frame Y4M 4:2:0. O frame lido tem a linha 0 embaixo; o Y4M começa no topo.
+    std::vector<unsigned char> convertToYuv420(const ReadbackFrame& frame) {
+        PROFILE_ZONE("capture yuv");
+
+        const int width = frame.width;
+        const int height = frame.height;
+        const int chromaWidth = (width + 1) / 2;
+        const int chromaHeight = (height + 1) / 2;
+
+        std::vector<unsigned char> planes(static_cast<size_t>(width) * height +
+                                          2 * static_cast<size_t>(chromaWidth) * chromaHeight);
+        unsigned char* lumaPlane = planes.data();
+        unsigned char* uPlane = lumaPlane + static_cast<size_t>(width) * height;
+        unsigned char* vPlane = uPlane + static_cast<size_t>(chromaWidth) * chromaHeight;
+
+        const auto row = [&frame, width, height](const int y) {
+            return &frame.pixels[static_cast<size_t>(height - 1 - y) * width * 4];
+        };
+
+        for (int y = 0; y < height; y++) {
+            convertLumaRow(row(y), lumaPlane + static_cast<size_t>(y) * width, width);
+        }
+
+        // Com altura ímpar o último bloco repete a última linha.
+        for (int y = 0; y < chromaHeight; y++) {
+            convertChromaRow(row(2 * y), row(std::min(2 * y + 1, height - 1)),
+                             uPlane + static_cast<size_t>(y) * chromaWidth,
+                             vPlane + static_cast<size_t>(y) * chromaWidth, width);
+        }
+
+        return planes;
+    }
+}
+
+bool FrameCapture::create(const std::string& path, const int width, const int height, const int framesPerSecond,
+                          const unsigned int threads) {
+    this->path = path;
+    this->width = width;
+    this->height = height;
+    this->requested = 0;
+    this->queued = 0;
+    this->failed = false;
+    this->nextWrite = 0;
+    this->converted.clear();
+
+    this->video = path.size() >= 4 && path.compare(path.size() - 4, 4, ".y4m") == 0;
+    if (this->video) {
+        this->videoFile = std::fopen(path.c_str(), "wb");
+        if (this->videoFile == nullptr) {
+            std::cout << "Failed to open capture file " << path << std::endl;
+            return false;
+        }
+        std::fprintf(this->videoFile, "YUV4MPEG2 W%d H%d F%d:1 Ip A1:1 C420jpeg XCOLORRANGE=FULL\n", width, height,
+                     framesPerSecond);
+    } else {
+        std::error_code error;
+        std::filesystem::create_directories(path, error);
+        if (error) {
+            std::cout << "Failed to create capture directory " << path << ": " << error.message() << std::endl;
+            return false;
+        }
+    }
+
+    this->readback.create(width, height);
+    this->encoders = std::make_unique<ThreadPool>(threads);
+    return true;
+}
+
+void FrameCapture::destroy() {
+    if (!active()) {
+        return;
+    }
+
+    collect(true);
+    this->encoders->wait();
+    this->encoders.reset();
+    this->readback.destroy();
+
+    if (this->videoFile != nullptr) {
+        this->failed = std::fclose(this->videoFile) != 0 || this->failed;
+        this->videoFile = nullptr;
+    }
+
+    if (this->failed) {
+        std::cout << "Failed to write some of the captured frames to " << this->path << std::endl;
+    } else {
+        std::cout << "Captured " << this->requested << " frames to " << this->path << std::endl;
+    }
+}
+
+void FrameCapture::capture(const GLuint framebuffer) {
+    PROFILE_ZONE("capture");
+
+    this->readback.request(framebuffer, this->requested++);
+    collect(false);
+}
+
+void FrameCapture::collect(const bool wait) {
+    ReadbackFrame frame;
+    while (this->readback.poll(frame, wait)) {
+        {
+            std::unique_lock lock(this->queueMutex);
+            if (this->queued >= CAPTURE_MAX_QUEUED_FRAMES) {
+                PROFILE_ZONE("capture backpressure");
+                this->frameEncoded.wait(lock, [this] { return this->queued < CAPTURE_MAX_QUEUED_FRAMES; });
+            }
+            this->queued++;
+        }
+
+        this->encoders->submit([this, frame = std::move(frame)]() mutable { encode(std::move(frame)); });
+    }
+}
+
+void FrameCapture::encode(ReadbackFrame frame) {
+    bool written;
+
+    if (this->video) {
+        std::vector<unsigned char> planes = convertToYuv420(frame);
+
+        std::lock_guard lock(this->writeMutex);
+        this->converted.emplace(frame.frame, std::move(planes));
+        written = writeVideoFrames();
+    } else {
+        PROFILE_ZONE("capture png");
+
+        char name[32];
+        std::snprintf(name, sizeof(name), "frame_%05d.png", frame.frame);
+        written = writeImage((std::filesystem::path(this->path) / name).string(), flippedImage(frame));
+    }
+
+    {
+        std::lock_guard lock(this->queueMutex);
+        this->queued--;
+        this->failed = this->failed || !written;
+    }
+    this->frameEncoded.notify_all();
+}
+
+bool FrameCapture::writeVideoFrames() {
+    bool written = true;
+
+    for (auto next = this->converted.find(this->nextWrite); next != this->converted.end();
+         next = this->converted.find(this->nextWrite)) {
+        const std::vector<unsigned char>& planes = next->second;
+        written = std::fputs("FRAME\n", this->videoFile) >= 0 &&
+                  std::fwrite(planes.data(), 1, planes.size(), this->videoFile) == planes.size() && written;
+
+        this->converted.erase(next);
+        this->nextWrite++;
+    }
+
+    return written;
+}
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <glad.h>
+
+#include <condition_variable>
+#include <cstdio>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "renderer/framebuffer_readback.hpp"
+#include "renderer/thread_pool.hpp"
+
+// Frames lidos esperando os encoders. Acima disso capture() espera: sem limite um encoder mais lento
+// que a renderização acumularia frames na memória até acabar.
+constexpr int CAPTURE_MAX_QUEUED_FRAMES = 16;
+
+// Grava todos os frames apresentados, para gravar uma partida. A leitura usa o FramebufferReadback (PBOs
+// com fences), então a renderização não para esperando a GPU; os frames lidos vão para um pool de
+// encoders. Um caminho terminado em .y4m vira um vídeo YUV 4:2:0 (convertido em paralelo e escrito em
+// ordem); qualquer outro é um diretório com um PNG por frame, comprimidos em paralelo.
+class FrameCapture {
+public:
+    // threads 0 usa uma por núcleo.
+    bool create(const std::string& path, int width, int height, int framesPerSecond, unsigned int threads = 0);
+
+    // Espera os encoders terminarem e fecha o arquivo.
+    void destroy();
+
+    bool active() const { return this->encoders != nullptr; }
+
+    // Chamado antes do swap: enfileira a leitura deste frame e entrega aos encoders as que já terminaram.
+    void capture(GLuint framebuffer);
+
+private:
+    void collect(bool wait);
+
+    void encode(ReadbackFrame frame);
+
+    // Escreve os frames Y4M convertidos na ordem, a partir de nextWrite. Chamado com writeMutex travado.
+    bool writeVideoFrames();
+
+    std::string path;
+    bool video = false;
+    std::FILE* videoFile = nullptr;
+    int width = 0;
+    int height = 0;
+
+    FramebufferReadback readback;
+    std::unique_ptr<ThreadPool> encoders;
+    int requested = 0;
+
+    std::mutex queueMutex;
+    std::condition_variable frameEncoded;
+    int queued = 0;
+    bool failed = false;
+
+    // Frames Y4M já convertidos que esperam os anteriores.
+    std::mutex writeMutex;
+    std::map<int, std::vector<unsigned char>> converted;
+    int nextWrite = 0;
+};
@@ -0,0 +1,119 @@
+#include "renderer/framebuffer_readback.hpp"
+
+#include <cstring>
+
+#include "renderer/profiler.hpp"
+
+namespace {
+    bool fenceSignaled(const GLsync fence, const GLuint64 timeout) {
+        const GLenum status = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, timeout);
+        return status == GL_ALREADY_SIGNALED || status == GL_CONDITION_SATISFIED;
+    }
+}
+
+Image flippedImage(const ReadbackFrame& frame) {
+    Image image;
+    image.width = frame.width;
+    image.height = frame.height;
+    image.pixels.resize(frame.pixels.size());
+
+    const size_t stride = static_cast<size_t>(frame.width) * 4;
+    for (int y = 0; y < frame.height; y++) {
+        std::memcpy(&image.pixels[y * stride], &frame.pixels[(frame.height - 1 - y) * stride], stride);
+    }
+    return image;
+}
+
+void FramebufferReadback::create(const int width, const int height, const int slots) {
+    this->width = width;
+    this->height = height;
+    this->nextSlot = 0;
+
+    this->buffers.assign(slots, 0);
+    glGenBuffers(slots, this->buffers.data());
+    for (const GLuint buffer : this->buffers) {
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, buffer);
+        glBufferData(GL_PIXEL_PACK_BUFFER, static_cast<GLsizeiptr>(width) * height * 4, nullptr, GL_STREAM_READ);
+    }
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+}
+
+void FramebufferReadback::destroy() {
+    for (const PendingRead& pending : this->inFlight) {
+        glDeleteSync(pending.fence);
+    }
+    this->inFlight.clear();
+    this->ready.clear();
+
+    if (!this->buffers.empty()) {
+        glDeleteBuffers(static_cast<GLsizei>(this->buffers.size()), this->buffers.data());
+        this->buffers.clear();
+    }
+}
+
+void FramebufferReadback::request(const GLuint framebuffer, const int frame) {
+    PROFILE_ZONE("readback request");
+
+    if (this->inFlight.size() == this->buffers.size()) {
+        const PendingRead oldest = this->inFlight.front();
+        while (!fenceSignaled(oldest.fence, 1000000)) {
+        }
+        this->ready.push_back(read(oldest));
+        this->inFlight.pop_front();
+    }
+
+    const int slot = this->nextSlot;
+    this->nextSlot = (this->nextSlot + 1) % static_cast<int>(this->buffers.size());
+
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, framebuffer);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, this->buffers[slot]);
+    glReadPixels(0, 0, this->width, this->height, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+    this->inFlight.push_back(PendingRead{slot, frame, glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0)});
+}
+
+bool FramebufferReadback::poll(ReadbackFrame& result, const bool wait) {
+    if (!this->ready.empty()) {
+        result = std::move(this->ready.front());
+        this->ready.pop_front();
+        return true;
+    }
+
+    if (this->inFlight.empty()) {
+        return false;
+    }
+
+    const PendingRead& oldest = this->inFlight.front();
+    if (wait) {
+        while (!fenceSignaled(oldest.fence, 1000000)) {
+        }
+    } else if (!fenceSignaled(oldest.fence, 0)) {
+        return false;
+    }
+
+    result = read(oldest);
+    this->inFlight.pop_front();
+    return true;
+}
+
+ReadbackFrame FramebufferReadback::read(const PendingRead& pending) {
+    PROFILE_ZONE("readback map");
+
+    ReadbackFrame frame;
+    frame.frame = pending.frame;
+    frame.width = this->width;
+    frame.height = this->height;
+    frame.pixels.resize(static_cast<size_t>(this->width) * this->height * 4);
+
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, this->buffers[pending.slot]);
+    if (const void* data = glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, static_cast<GLsizeiptr>(frame.pixels.size()),
+                                            GL_MAP_READ_BIT)) {
+        std::memcpy(frame.pixels.data(), data, frame.pixels.size());
+        glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+    }
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+    glDeleteSync(pending.fence);
+    return frame;
+}
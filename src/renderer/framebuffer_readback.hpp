@@ -0,0 +1,60 @@
+#pragma once
+
+#include <glad.h>
+
+#include <deque>
+#include <vector>
+
+#include "renderer/texture.hpp"
+
+// Leituras que podem estar em andamento ao mesmo tempo. Com 3 a CPU só mapeia um PBO dois frames
+// depois da cópia, quando a GPU já terminou de escrevê-lo.
+constexpr int READBACK_SLOTS = 3;
+
+// Frame lido de volta: RGBA8 com a linha 0 embaixo, como o glReadPixels entrega.
+struct ReadbackFrame {
+    int frame = 0;
+    int width = 0;
+    int height = 0;
+    std::vector<unsigned char> pixels;
+};
+
+// Cópia com a primeira linha no topo, como nos arquivos de imagem.
+Image flippedImage(const ReadbackFrame& frame);
+
+// Lê o framebuffer para a CPU por um anel de PBOs. O glReadPixels de request() só enfileira a cópia
+// para o PBO e marca uma fence; o mapeamento acontece no poll(), quando a fence já passou, então o
+// pipeline não para esperando a GPU a cada frame lido.
+class FramebufferReadback {
+public:
+    void create(int width, int height, int slots = READBACK_SLOTS);
+
+    void destroy();
+
+    // Copia o framebuffer inteiro para o próximo slot. Com todos ocupados espera o mais antigo e
+    // guarda o resultado para o poll().
+    void request(GLuint framebuffer, int frame);
+
+    // Entrega a leitura mais antiga já pronta. Com wait espera por ela em vez de devolver false.
+    bool poll(ReadbackFrame& result, bool wait = false);
+
+    bool pending() const { return !this->inFlight.empty() || !this->ready.empty(); }
+
+private:
+    struct PendingRead {
+        int slot;
+        int frame;
+        GLsync fence;
+    };
+
+    ReadbackFrame read(const PendingRead& pending);
+
+    int width = 0;
+    int height = 0;
+
+    std::vector<GLuint> buffers;
+    int nextSlot = 0;
+
+    std::deque<PendingRead> inFlight;
+    std::deque<ReadbackFrame> ready;
+};
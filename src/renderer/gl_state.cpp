@@ -0,0 +1,189 @@
+#include "renderer/gl_state.hpp"
+
+namespace {
+    // Valores desconhecidos (UNKNOWN_OBJECT, GL_NONE, Toggle::Unknown) fazem a próxima chamada sempre chegar ao driver.
+    constexpr GLuint UNKNOWN_OBJECT = 0xFFFFFFFFu;
+
+    enum class Toggle {
+        Unknown,
+        Enabled,
+        Disabled,
+    };
+
+    enum TextureSlot {
+        Texture2D = 0,
+        Texture2DArray = 1,
+        TEXTURE_SLOTS = 2,
+    };
+
+    struct GLStateCache {
+        GLuint program = UNKNOWN_OBJECT;
+        GLuint VAO = UNKNOWN_OBJECT;
+
+        int activeTextureUnit = -1;
+        GLuint textures[MAX_CACHED_TEXTURE_UNITS][TEXTURE_SLOTS] = {};
+
+        Toggle blending = Toggle::Unknown;
+        GLenum blendSourceFactor = GL_NONE;
+        GLenum blendDestinationFactor = GL_NONE;
+
+        Toggle depthTest = Toggle::Unknown;
+        GLenum depthFunc = GL_NONE;
+
+        GLStateCache() {
+            for (auto& unit : textures) {
+                for (GLuint& texture : unit) {
+                    texture = UNKNOWN_OBJECT;
+                }
+            }
+        }
+    };
+
+    GLStateCache state;
+
+    int drawCalls = 0;
+
+    int textureSlot(const GLenum target) {
+        switch (target) {
+            case GL_TEXTURE_2D:
+                return Texture2D;
+            case GL_TEXTURE_2D_ARRAY:
+                return Texture2DArray;
+            default:
+                return -1;
+        }
+    }
+
+    void setToggle(Toggle& cached, const GLenum capability, const bool enabled) {
+        const Toggle wanted = enabled ? Toggle::Enabled : Toggle::Disabled;
+        if (cached == wanted) {
+            return;
+        }
+
+        if (enabled) {
+            glEnable(capability);
+        } else {
+            glDisable(capability);
+        }
+        cached = wanted;
+    }
+}
+
+void useProgram(const GLuint program) {
+    if (state.program == program) {
+        return;
+    }
+
+    glUseProgram(program);
+    state.program = program;
+}
+
+void bindVertexArray(const GLuint VAO) {
+    if (state.VAO == VAO) {
+        return;
+    }
+
+    glBindVertexArray(VAO);
+    state.VAO = VAO;
+}
+
+void bindTexture(const GLenum target, const GLuint texture, const int unit) {
+    const int slot = textureSlot(target);
+    const bool cached = slot >= 0 && unit >= 0 && unit < MAX_CACHED_TEXTURE_UNITS;
+
+    if (cached && state.textures[unit][slot] == texture) {
+        return;
+    }
+
+    if (state.activeTextureUnit != unit) {
+        glActiveTexture(GL_TEXTURE0 + unit);
+        state.activeTextureUnit = unit;
+    }
+
+    glBindTexture(target, texture);
+
+    if (cached) {
+        state.textures[unit][slot] = texture;
+    }
+}
+
+void setBlending(const bool enabled) {
+    setToggle(state.blending, GL_BLEND, enabled);
+}
+
+void setBlendFunc(const GLenum sourceFactor, const GLenum destinationFactor) {
+    if (state.blendSourceFactor == sourceFactor && state.blendDestinationFactor == destinationFactor) {
+        return;
+    }
+
+    glBlendFunc(sourceFactor, destinationFactor);
+    state.blendSourceFactor = sourceFactor;
+    state.blendDestinationFactor = destinationFactor;
+}
+
+void setDepthTest(const bool enabled) {
+    setToggle(state.depthTest, GL_DEPTH_TEST, enabled);
+}
+
+void setDepthFunc(const GLenum func) {
+    if (state.depthFunc == func) {
+        return;
+    }
+
+    glDepthFunc(func);
+    state.depthFunc = func;
+}
+
+// Ao deletar um objeto ligado o OpenGL volta o binding para 0, e o nome pode ser reaproveitado
+// por um objeto novo; o cache precisa acompanhar para não pular o próximo bind.
+void deleteProgram(const GLuint program) {
+    glDeleteProgram(program);
+    if (state.program == program) {
+        state.program = UNKNOWN_OBJECT;
+    }
+}
+
+void deleteVertexArray(const GLuint VAO) {
+    glDeleteVertexArrays(1, &VAO);
+    if (state.VAO == VAO) {
+        state.VAO = UNKNOWN_OBJECT;
+    }
+}
+
+void deleteTexture(const GLuint texture) {
+    glDeleteTextures(1, &texture);
+    for (auto& unit : state.textures) {
+        for (GLuint& bound : unit) {
+            if (bound == texture) {
+                bound = UNKNOWN_OBJECT;
+            }
+        }
+    }
+}
+
+void invalidateStateCache() {
+    state = GLStateCache();
+}
+
+void drawArrays(const GLenum mode, const GLint first, const GLsizei count) {
+    glDrawArrays(mode, first, count);
+    drawCalls++;
+}
+
+void drawArraysInstanced(const GLenum mode, const GLint first, const GLsizei count, const GLsizei instanceCount) {
+    glDrawArraysInstanced(mode, first, count, instanceCount);
+    drawCalls++;
+}
+
+void drawElements(const GLenum mode, const GLsizei count, const GLenum type, const void* indices) {
+    glDrawElements(mode, count, type, indices);
+    drawCalls++;
+}
+
+int drawCallCount() {
+    return drawCalls;
+}
+
+void resetDrawCallCount() {
+    drawCalls = 0;
+}
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <glad.h>
+
+// Cache do estado de OpenGL usado pelos exercícios. Todas as trocas de programa, VAO, textura,
+// blend e depth test devem passar por aqui: chamadas que não mudariam nada não chegam ao driver.
+// Se algum código chamar a API de OpenGL diretamente, use invalidateStateCache() em seguida.
+
+constexpr int MAX_CACHED_TEXTURE_UNITS = 16;
+
+void useProgram(GLuint program);
+
+void bindVertexArray(GLuint VAO);
+
+void bindTexture(GLenum target, GLuint texture, int unit = 0);
+
+void setBlending(bool enabled);
+
+void setBlendFunc(GLenum sourceFactor, GLenum destinationFactor);
+
+void setDepthTest(bool enabled);
+
+void setDepthFunc(GLenum func);
+
+void deleteProgram(GLuint program);
+
+void deleteVertexArray(GLuint VAO);
+
+void deleteTexture(GLuint texture);
+
+void invalidateStateCache();
+
+// Draw calls também passam por aqui, para o modo benchmark poder contá-los.
+void drawArrays(GLenum mode, GLint first, GLsizei count);
+
+void drawArraysInstanced(GLenum mode, GLint first, GLsizei count, GLsizei instanceCount);
+
+void drawElements(GLenum mode, GLsizei count, GLenum type, const void* indices);
+
+// Draw calls feitos desde o último resetDrawCallCount().
+int drawCallCount();
+
+void resetDrawCallCount();
@@ -0,0 +1,209 @@
+#include "renderer/golden_image.hpp"
+
+#include <algorithm>
+#include <bitset>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define GOLDEN_USE_SSE2
+#endif
+
+namespace {
+    constexpr uint32_t DIFF_COLOR = 0xffff00ff; // magenta opaco em RGBA8
+
+    // Canais em 1/4 do brilho e alpha opaco, para os pixels diferentes se destacarem.
+    uint32_t dimmed(const uint32_t pixel) {
+        return (pixel >> 2 & 0x003f3f3f) | 0xff000000;
+    }
+
+    // Compara um pixel; devolve a maior diferença entre os canais.
+    int channelDifference(const unsigned char* expected, const unsigned char* actual) {
+        int difference = 0;
+        for (int channel = 0; channel < 4; channel++) {
+            difference = std::max(difference, std::abs(expected[channel] - actual[channel]));
+        }
+        return difference;
+    }
+
+    std::string frameFileName(const std::string& exercise, const int frame, const char* suffix) {
+        char name[64];
+        std::snprintf(name, sizeof(name), "_%04d%s.png", frame, suffix);
+        return exercise + name;
+    }
+}
+
+ImageDifference compareImages(const unsigned char* expected, const unsigned char* actual, const size_t pixelCount,
+                              const int tolerance, unsigned char* diff) {
+    ImageDifference result;
+    size_t i = 0;
+
+#ifdef GOLDEN_USE_SSE2
+    const __m128i limit = _mm_set1_epi8(static_cast<char>(std::clamp(tolerance, 0, 255)));
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i ones = _mm_set1_epi32(-1);
+    const __m128i dimMask = _mm_set1_epi32(0x003f3f3f);
+    const __m128i opaque = _mm_set1_epi32(static_cast<int>(0xff000000));
+    const __m128i magenta = _mm_set1_epi32(static_cast<int>(DIFF_COLOR));
+    __m128i largest = zero;
+
+    // 4 pixels por vez: |a - b| por canal com subtração saturada nos dois sentidos.
+    for (; i + 4 <= pixelCount; i += 4) {
+        const __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(expected + i * 4));
+        const __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(actual + i * 4));
+        const __m128i difference = _mm_or_si128(_mm_subs_epu8(a, b), _mm_subs_epu8(b, a));
+        largest = _mm_max_epu8(largest, difference);
+
+        // Um pixel está dentro da tolerância quando os 4 canais estão.
+        const __m128i channelsWithin = _mm_cmpeq_epi8(_mm_subs_epu8(difference, limit), zero);
+        const __m128i within = _mm_cmpeq_epi32(channelsWithin, ones);
+        const int differing = ~_mm_movemask_ps(_mm_castsi128_ps(within)) & 0xf;
+        result.pixels += static_cast<long long>(std::bitset<4>(differing).count());
+
+        if (diff != nullptr) {
+            const __m128i dim = _mm_or_si128(_mm_and_si128(_mm_srli_epi32(b, 2), dimMask), opaque);
+            const __m128i marked = _mm_or_si128(_mm_and_si128(within, dim), _mm_andnot_si128(within, magenta));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(diff + i * 4), marked);
+        }
+    }
+
+    unsigned char lanes[16];
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(lanes), largest);
+    result.maxChannel = *std::max_element(lanes, lanes + 16);
+#endif
+
+    for (; i < pixelCount; i++) {
+        const int difference = channelDifference(expected + i * 4, actual + i * 4);
+        result.maxChannel = std::max(result.maxChannel, difference);
+        if (difference > tolerance) {
+            result.pixels++;
+        }
+
+        if (diff != nullptr) {
+            uint32_t pixel;
+            std::memcpy(&pixel, actual + i * 4, sizeof(pixel));
+            pixel = difference > tolerance ? DIFF_COLOR : dimmed(pixel);
+            std::memcpy(diff + i * 4, &pixel, sizeof(pixel));
+        }
+    }
+
+    return result;
+}
+
+void GoldenImageTest::create(const std::string& directory, const std::vector<int>& frames, const int tolerance,
+                             const bool update, const int width, const int height) {
+    this->directory = directory;
+    this->frames = frames;
+    this->tolerance = tolerance;
+    this->update = update;
+    this->captured.clear();
+
+    this->readback.create(width, height);
+}
+
+void GoldenImageTest::destroy() {
+    if (active()) {
+        this->readback.destroy();
+    }
+    this->captured.clear();
+}
+
+void GoldenImageTest::capture(const GLuint framebuffer, const int frame) {
+    if (std::find(this->frames.begin(), this->frames.end(), frame) != this->frames.end()) {
+        this->readback.request(framebuffer, frame);
+    }
+    collect(false);
+}
+
+void GoldenImageTest::collect(const bool wait) {
+    ReadbackFrame frame;
+    while (this->readback.poll(frame, wait)) {
+        this->captured.emplace_back(frame.frame, flippedImage(frame));
+    }
+}
+
+bool GoldenImageTest::check(const std::string& exercise) {
+    if (!active()) {
+        return true;
+    }
+
+    collect(true);
+
+    const std::filesystem::path directory = this->directory;
+    if (this->update) {
+        std::error_code error;
+        std::filesystem::create_directories(directory, error);
+    }
+
+    bool passed = true;
+    int matched = 0;
+
+    for (const auto& [frame, image] : this->captured) {
+        const std::filesystem::path path = directory / frameFileName(exercise, frame, "");
+
+        if (this->update) {
+            passed = writeImage(path.string(), image) && passed;
+            continue;
+        }
+
+        Image expected;
+        if (!std::filesystem::exists(path)) {
+            std::cout << "Missing golden image " << path.string() << " (record it with --golden-update)" << std::endl;
+            passed = false;
+            continue;
+        }
+        if (!loadImage(path.string(), expected)) {
+            passed = false;
+            continue;
+        }
+        if (expected.width != image.width || expected.height != image.height) {
+            std::cout << "Golden image " << path.string() << " is " << expected.width << "x" << expected.height
+                      << " but the frame is " << image.width << "x" << image.height << std::endl;
+            passed = false;
+            continue;
+        }
+
+        Image diff;
+        diff.width = image.width;
+        diff.height = image.height;
+        diff.pixels.resize(image.pixels.size());
+
+        const ImageDifference difference = compareImages(expected.pixels.data(), image.pixels.data(),
+                                                         static_cast<size_t>(image.width) * image.height,
+                                                         this->tolerance, diff.pixels.data());
+        if (difference.pixels == 0) {
+            matched++;
+            continue;
+        }
+
+        std::cout << "Golden image mismatch: " << path.string() << ": " << difference.pixels
+                  << " pixels differ (max channel difference " << difference.maxChannel << ")" << std::endl;
+        writeImage((directory / frameFileName(exercise, frame, "_actual")).string(), image);
+        writeImage((directory / frameFileName(exercise, frame, "_diff")).string(), diff);
+        passed = false;
+    }
+
+    // Frames pedidos depois do último renderizado nunca foram lidos.
+    for (const int frame : this->frames) {
+        const bool found = std::any_of(this->captured.begin(), this->captured.end(),
+                                       [frame](const auto& entry) { return entry.first == frame; });
+        if (!found) {
+            std::cout << "Golden frame " << frame << " of " << exercise << " was never rendered" << std::endl;
+            passed = false;
+        }
+    }
+
+    if (this->update) {
+        std::cout << "Recorded " << this->captured.size() << " golden images of " << exercise << " in "
+                  << directory.string() << std::endl;
+    } else {
+        std::cout << "Golden images of " << exercise << ": " << matched << "/" << this->frames.size() << " match"
+                  << std::endl;
+    }
+
+    return passed;
+}
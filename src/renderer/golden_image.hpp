@@ -0,0 +1,55 @@
+#pragma once
+
+#include <glad.h>
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include "renderer/framebuffer_readback.hpp"
+#include "renderer/texture.hpp"
+
+// Tolerância padrão por canal: absorve arredondamentos de driver sem esconder mudanças visíveis.
+constexpr int GOLDEN_DEFAULT_TOLERANCE = 2;
+
+// Quanto duas imagens RGBA8 do mesmo tamanho diferem.
+struct ImageDifference {
+    long long pixels = 0;
+    int maxChannel = 0;
+};
+
+// Um pixel difere quando algum canal passa de tolerance. Se diff não for nullptr (RGBA8, mesmo
+// tamanho), recebe a imagem atual escurecida com os pixels diferentes em magenta.
+ImageDifference compareImages(const unsigned char* expected, const unsigned char* actual, size_t pixelCount,
+                              int tolerance, unsigned char* diff = nullptr);
+
+// Modo de teste --golden: lê de volta alguns frames pelo FramebufferReadback e, no fim, compara
+// cada um com <diretório>/<exercício>_<frame>.png. Quando um frame difere grava ao lado o
+// _actual.png e o _diff.png. Com update grava as referências em vez de comparar.
+class GoldenImageTest {
+public:
+    void create(const std::string& directory, const std::vector<int>& frames, int tolerance, bool update, int width,
+                int height);
+
+    void destroy();
+
+    bool active() const { return !this->directory.empty(); }
+
+    // Chamado antes do swap. Só enfileira a leitura dos frames da lista; nada espera a GPU.
+    void capture(GLuint framebuffer, int frame);
+
+    // Devolve false se algum frame diferiu, faltou referência ou não chegou a ser renderizado.
+    bool check(const std::string& exercise);
+
+private:
+    void collect(bool wait);
+
+    std::string directory;
+    std::vector<int> frames;
+    int tolerance = GOLDEN_DEFAULT_TOLERANCE;
+    bool update = false;
+
+    FramebufferReadback readback;
+    // Frames lidos, já com a primeira linha no topo como nos PNGs.
+    std::vector<std::pair<int, Image>> captured;
+};
@@ -0,0 +1,239 @@
+#include "renderer/profiler.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace {
+    struct ProfileEvent {
+        const char* name = nullptr;
+        uint64_t start = 0;
+        uint64_t end = 0;
+    };
+
+    // Só a thread dona escreve; a exportação lê no fim, quando as threads já estão paradas.
+    struct ThreadEvents {
+        int id = 0;
+        std::string name;
+        std::vector<ProfileEvent> events = std::vector<ProfileEvent>(PROFILER_EVENTS_PER_THREAD);
+        std::atomic<uint64_t> written{0};
+
+        void record(const char* eventName, const uint64_t start, const uint64_t end) {
+            const uint64_t index = this->written.load(std::memory_order_relaxed);
+            ProfileEvent& event = this->events[index % PROFILER_EVENTS_PER_THREAD];
+            event.name = eventName;
+            event.start = start;
+            event.end = end;
+            this->written.store(index + 1, std::memory_order_release);
+        }
+    };
+
+    struct GpuFrame {
+        GLuint queries[PROFILER_MAX_GPU_ZONES_PER_FRAME] = {};
+        const char* names[PROFILER_MAX_GPU_ZONES_PER_FRAME] = {};
+        uint64_t starts[PROFILER_MAX_GPU_ZONES_PER_FRAME] = {};
+        int used = 0;
+        bool created = false;
+    };
+
+    std::atomic<bool> enabled{false};
+    const std::chrono::steady_clock::time_point epoch = std::chrono::steady_clock::now();
+
+    std::mutex threadsMutex;
+    std::vector<std::unique_ptr<ThreadEvents>> threads;
+    thread_local ThreadEvents* currentThread = nullptr;
+    thread_local const char* currentThreadName = nullptr;
+
+    // Trilha extra no trace com as durações medidas pela GPU, posicionadas no instante em que a
+    // CPU abriu a zona.
+    ThreadEvents* gpuTrack = nullptr;
+    GpuFrame gpuFrames[PROFILER_GPU_FRAMES];
+    int gpuFrameIndex = 0;
+    bool gpuZoneOpen = false;
+    uint64_t droppedGpuZones = 0;
+
+    ThreadEvents* registerTrack(const std::string& name) {
+        std::lock_guard<std::mutex> lock(threadsMutex);
+        threads.push_back(std::make_unique<ThreadEvents>());
+        ThreadEvents* track = threads.back().get();
+        track->id = static_cast<int>(threads.size()) - 1;
+        track->name = name.empty() ? "thread " + std::to_string(track->id) : name;
+        return track;
+    }
+
+    ThreadEvents& threadEvents() {
+        if (currentThread == nullptr) {
+            currentThread = registerTrack(currentThreadName != nullptr ? currentThreadName : "");
+        }
+        return *currentThread;
+    }
+
+    void writeEscaped(std::ofstream& file, const std::string& text) {
+        for (const char c : text) {
+            if (c == '"' || c == '\\') {
+                file << '\\';
+            }
+            file << c;
+        }
+    }
+
+    void writeMicroseconds(std::ofstream& file, const uint64_t nanoseconds) {
+        file << nanoseconds / 1000 << '.' << std::setw(3) << std::setfill('0') << nanoseconds % 1000;
+    }
+}
+
+void enableProfiler() {
+    if (enabled.load()) {
+        return;
+    }
+
+    nameProfilerThread("main");
+    threadEvents();
+    gpuTrack = registerTrack("GPU");
+    enabled.store(true);
+}
+
+bool profilerEnabled() {
+    return enabled.load(std::memory_order_relaxed);
+}
+
+void nameProfilerThread(const char* name) {
+    // O ring buffer só é criado no primeiro evento da thread, então aqui basta guardar o nome.
+    currentThreadName = name;
+
+    if (currentThread != nullptr) {
+        std::lock_guard<std::mutex> lock(threadsMutex);
+        currentThread->name = name;
+    }
+}
+
+uint64_t profilerNow() {
+    // +1 para 0 continuar significando "zona desligada" no ProfileZone.
+    return static_cast<uint64_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - epoch).count()) + 1;
+}
+
+void recordProfileZone(const char* name, const uint64_t start, const uint64_t end) {
+    threadEvents().record(name, start, end);
+}
+
+GpuProfileZone::GpuProfileZone(const char* name) {
+    if (!profilerEnabled() || gpuZoneOpen) {
+        return;
+    }
+
+    GpuFrame& frame = gpuFrames[gpuFrameIndex];
+    if (!frame.created) {
+        glGenQueries(PROFILER_MAX_GPU_ZONES_PER_FRAME, frame.queries);
+        frame.created = true;
+    }
+    if (frame.used == PROFILER_MAX_GPU_ZONES_PER_FRAME) {
+        droppedGpuZones++;
+        return;
+    }
+
+    const int zone = frame.used++;
+    frame.names[zone] = name;
+    frame.starts[zone] = profilerNow();
+    glBeginQuery(GL_TIME_ELAPSED, frame.queries[zone]);
+
+    gpuZoneOpen = true;
+    this->active = true;
+}
+
+GpuProfileZone::~GpuProfileZone() {
+    if (this->active) {
+        glEndQuery(GL_TIME_ELAPSED);
+        gpuZoneOpen = false;
+    }
+}
+
+void endProfilerFrame() {
+    if (!profilerEnabled()) {
+        return;
+    }
+
+    // O slot seguinte é o mais antigo: as queries dele foram emitidas PROFILER_GPU_FRAMES frames atrás.
+    gpuFrameIndex = (gpuFrameIndex + 1) % PROFILER_GPU_FRAMES;
+    GpuFrame& frame = gpuFrames[gpuFrameIndex];
+
+    for (int zone = 0; zone < frame.used; zone++) {
+        GLint available = 0;
+        glGetQueryObjectiv(frame.queries[zone], GL_QUERY_RESULT_AVAILABLE, &available);
+
+        // Se ainda não chegou a zona é descartada em vez de esperar pela GPU.
+        if (!available) {
+            droppedGpuZones++;
+            continue;
+        }
+
+        GLuint64 elapsed = 0;
+        glGetQueryObjectui64v(frame.queries[zone], GL_QUERY_RESULT, &elapsed);
+        gpuTrack->record(frame.names[zone], frame.starts[zone], frame.starts[zone] + elapsed);
+    }
+
+    frame.used = 0;
+}
+
+bool writeChromeTrace(const std::string& filePath) {
+    std::ofstream file(filePath);
+    if (!file) {
+        std::cout << "Failed to write profile to " << filePath << std::endl;
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(threadsMutex);
+
+    file << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+
+    size_t eventCount = 0;
+    bool first = true;
+
+    for (const std::unique_ptr<ThreadEvents>& track : threads) {
+        file << (first ? "" : ",") << "\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << track->id
+             << ",\"args\":{\"name\":\"";
+        writeEscaped(file, track->name);
+        file << "\"}}";
+        first = false;
+
+        // Se o ring deu a volta só os últimos PROFILER_EVENTS_PER_THREAD eventos sobrevivem.
+        const uint64_t written = track->written.load(std::memory_order_acquire);
+        const uint64_t begin = written > PROFILER_EVENTS_PER_THREAD ? written - PROFILER_EVENTS_PER_THREAD : 0;
+
+        for (uint64_t i = begin; i < written; i++) {
+            const ProfileEvent& event = track->events[i % PROFILER_EVENTS_PER_THREAD];
+
+            file << ",\n{\"name\":\"";
+            writeEscaped(file, event.name);
+            file << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << track->id << ",\"ts\":";
+            writeMicroseconds(file, event.start);
+            file << ",\"dur\":";
+            writeMicroseconds(file, event.end - event.start);
+            file << "}";
+        }
+
+        eventCount += written - begin;
+    }
+
+    file << "\n]}\n";
+
+    std::cout << "Profile written to " << filePath << " (" << eventCount << " events, " << droppedGpuZones
+              << " GPU zones dropped)" << std::endl;
+
+    return static_cast<bool>(file);
+}
+
+void destroyProfiler() {
+    for (GpuFrame& frame : gpuFrames) {
+        if (frame.created) {
+            glDeleteQueries(PROFILER_MAX_GPU_ZONES_PER_FRAME, frame.queries);
+            frame.created = false;
+            frame.used = 0;
+        }
+    }
+}
@@ -0,0 +1,81 @@
+#pragma once
+
+#include <glad.h>
+
+#include <cstdint>
+#include <string>
+
+// Profiler de frames. As zonas de CPU vão para um ring buffer por thread; as de GPU usam
+// queries GL_TIME_ELAPSED lidas só PROFILER_GPU_FRAMES frames depois, para nunca travar esperando
+// a GPU. Enquanto enableProfiler() não é chamado as zonas só testam uma flag.
+//
+//     PROFILE_ZONE("update");       // mede até o fim do escopo
+//     PROFILE_GPU_ZONE("draw");     // mede CPU e GPU; zonas de GPU não podem ser aninhadas
+//
+// Os nomes precisam ser literais: só o ponteiro é guardado.
+
+constexpr int PROFILER_EVENTS_PER_THREAD = 1 << 16;
+constexpr int PROFILER_GPU_FRAMES = 2;
+constexpr int PROFILER_MAX_GPU_ZONES_PER_FRAME = 32;
+
+void enableProfiler();
+
+bool profilerEnabled();
+
+// Nome da thread atual no trace. enableProfiler() já chama a thread que o habilitou de "main".
+void nameProfilerThread(const char* name);
+
+// Fecha as queries do frame atual e recolhe as de PROFILER_GPU_FRAMES frames atrás. Chamar uma
+// vez por frame, na thread do contexto, depois do swap.
+void endProfilerFrame();
+
+// Grava tudo o que ainda está nos ring buffers no formato JSON do chrome://tracing / Perfetto.
+bool writeChromeTrace(const std::string& filePath);
+
+// Libera as queries; precisa do contexto ainda ativo.
+void destroyProfiler();
+
+uint64_t profilerNow();
+
+void recordProfileZone(const char* name, uint64_t start, uint64_t end);
+
+class ProfileZone {
+public:
+    explicit ProfileZone(const char* name) : name(name), start(profilerEnabled() ? profilerNow() : 0) {
+    }
+
+    ~ProfileZone() {
+        if (this->start != 0) {
+            recordProfileZone(this->name, this->start, profilerNow());
+        }
+    }
+
+    ProfileZone(const ProfileZone&) = delete;
+    ProfileZone& operator=(const ProfileZone&) = delete;
+
+private:
+    const char* name;
+    uint64_t start;
+};
+
+class GpuProfileZone {
+public:
+    explicit GpuProfileZone(const char* name);
+
+    ~GpuProfileZone();
+
+    GpuProfileZone(const GpuProfileZone&) = delete;
+    GpuProfileZone& operator=(const GpuProfileZone&) = delete;
+
+private:
+    bool active = false;
+};
+
+#define PROFILE_CONCAT_INNER(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_INNER(a, b)
+
+#define PROFILE_ZONE(name) ProfileZone PROFILE_CONCAT(profileZone, __LINE__)(name)
+
+#define PROFILE_GPU_ZONE(name)                                  \
+    ProfileZone PROFILE_CONCAT(profileZone, __LINE__)(name);    \
+    GpuProfileZone PROFILE_CONCAT(gpuProfileZone, __LINE__)(name)
@@ -0,0 +1,589 @@
+#include "renderer/render_context.hpp"
+
+#include "renderer/gl_state.hpp"
+#include "renderer/profiler.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+
+#ifdef RENDERER_HAS_EGL
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#endif
+
+namespace {
+    // Contexto sob demanda da janela aberta: o ponteiro de usuário da GLFW fica livre para os exercícios.
+    RenderContext* onDemandContext = nullptr;
+
+    bool touches(const DamageRect& a, const DamageRect& b) {
+        return a.x <= b.x + b.width && b.x <= a.x + a.width && a.y <= b.y + b.height && b.y <= a.y + a.height;
+    }
+
+    DamageRect merged(const DamageRect& a, const DamageRect& b) {
+        const int left = std::min(a.x, b.x);
+        const int bottom = std::min(a.y, b.y);
+        const int right = std::max(a.x + a.width, b.x + b.width);
+        const int top = std::max(a.y + a.height, b.y + b.height);
+        return DamageRect{left, bottom, right - left, top - bottom};
+    }
+
+    bool readValue(const int argc, char** argv, int& i, std::string& value) {
+        if (i + 1 >= argc) {
+            std::cout << "Missing value for " << argv[i] << std::endl;
+            return false;
+        }
+        value = argv[++i];
+        return true;
+    }
+
+    bool readNonNegative(const int argc, char** argv, int& i, long& value) {
+        std::string text;
+        if (!readValue(argc, argv, i, text)) {
+            return false;
+        }
+
+        char* end = nullptr;
+        value = std::strtol(text.c_str(), &end, 10);
+        if (text.empty() || *end != '\0' || value < 0) {
+            std::cout << "Invalid value for " << argv[i - 1] << ": " << text << std::endl;
+            return false;
+        }
+        return true;
+    }
+
+    // Lista separada por vírgulas, como "0,30,59".
+    bool readFrameList(const int argc, char** argv, int& i, std::vector<int>& frames) {
+        std::string text;
+        if (!readValue(argc, argv, i, text)) {
+            return false;
+        }
+
+        frames.clear();
+        const char* cursor = text.c_str();
+        while (*cursor != '\0') {
+            char* end = nullptr;
+            const long frame = std::strtol(cursor, &end, 10);
+            if (end == cursor || frame < 0 || (*end != ',' && *end != '\0')) {
+                std::cout << "Invalid value for " << argv[i - 1] << ": " << text << std::endl;
+                return false;
+            }
+            frames.push_back(static_cast<int>(frame));
+            cursor = *end == ',' ? end + 1 : end;
+        }
+        return true;
+    }
+}
+
+bool parseContextOptions(const int argc, char** argv, ContextOptions& options) {
+    for (int i = 1; i < argc; i++) {
+        const std::string argument = argv[i];
+        long value = 0;
+
+        if (argument == "--headless") {
+            options.headless = true;
+        } else if (argument == "--benchmark") {
+            options.benchmark = true;
+        } else if (argument == "--on-demand") {
+            options.onDemand = true;
+        } else if (argument == "--software") {
+            options.software = true;
+        } else if (argument == "--golden-update") {
+            options.goldenUpdate = true;
+        } else if (argument == "--golden") {
+            if (!readValue(argc, argv, i, options.goldenDirectory)) {
+                return false;
+            }
+        } else if (argument == "--capture") {
+            if (!readValue(argc, argv, i, options.captureOutput)) {
+                return false;
+            }
+        } else if (argument == "--golden-frames") {
+            if (!readFrameList(argc, argv, i, options.goldenFrames)) {
+                return false;
+            }
+        } else if (argument == "--profile") {
+            if (!readValue(argc, argv, i, options.profileOutput)) {
+                return false;
+            }
+        } else if (argument == "--benchmark-output") {
+            if (!readValue(argc, argv, i, options.benchmarkOutput)) {
+                return false;
+            }
+        } else if (argument == "--frames" || argument == "--scale" || argument == "--seed" ||
+                   argument == "--width" || argument == "--height" || argument == "--golden-tolerance") {
+            if (!readNonNegative(argc, argv, i, value)) {
+                return false;
+            }
+
+            if (argument == "--frames") {
+                options.frames = static_cast<int>(value);
+            } else if (argument == "--scale") {
+                options.scale = static_cast<int>(value);
+            } else if (argument == "--seed") {
+                options.seed = static_cast<unsigned int>(value);
+            } else if (argument == "--width") {
+                options.width = static_cast<int>(value);
+            } else if (argument == "--golden-tolerance") {
+                options.goldenTolerance = static_cast<int>(value);
+            } else {
+                options.height = static_cast<int>(value);
+            }
+        }
+    }
+
+    if (options.frames == 0) {
+        if (options.benchmark) {
+            options.frames = BENCHMARK_DEFAULT_FRAMES;
+        } else if (options.headless || !options.goldenDirectory.empty()) {
+            options.frames = HEADLESS_DEFAULT_FRAMES;
+        }
+    }
+
+    if (!options.goldenDirectory.empty() && options.goldenFrames.empty()) {
+        options.goldenFrames = {0, options.frames / 2, options.frames - 1};
+        options.goldenFrames.erase(std::unique(options.goldenFrames.begin(), options.goldenFrames.end()),
+                                   options.goldenFrames.end());
+    }
+
+    return true;
+}
+
+bool RenderContext::create(const int width, const int height, const char* title, const ContextOptions& options,
+                           const int samples) {
+    this->width = options.width > 0 ? options.width : width;
+    this->height = options.height > 0 ? options.height : height;
+    this->options = options;
+    this->frameCount = 0;
+    // Headless nunca espera eventos, o benchmark precisa medir todo frame e o --golden e o --capture
+    // ler frames inteiros a um ritmo fixo.
+    this->onDemandActive = options.onDemand && !options.headless && !options.benchmark &&
+                           options.goldenDirectory.empty() && options.captureOutput.empty();
+
+    if (!options.profileOutput.empty()) {
+        enableProfiler();
+    }
+
+    if (!(options.headless ? createHeadless() : createWindow(title, samples))) {
+        return false;
+    }
+
+    if (!options.goldenDirectory.empty()) {
+        this->golden.create(options.goldenDirectory, options.goldenFrames, options.goldenTolerance,
+                            options.goldenUpdate, this->width, this->height);
+    }
+
+    if (!options.captureOutput.empty() &&
+        !this->frameCapture.create(options.captureOutput, this->width, this->height,
+                                   static_cast<int>(1.0 / HEADLESS_FRAME_TIME + 0.5))) {
+        return false;
+    }
+
+    resetDrawCallCount();
+    this->frameStart = std::chrono::steady_clock::now();
+
+    return true;
+}
+
+bool RenderContext::createWindow(const char* title, const int samples) {
+    glfwInit();
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, this->options.glMajor);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, this->options.glMinor);
+    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+
+    if (samples > 0) {
+        glfwWindowHint(GLFW_SAMPLES, samples);
+    }
+
+    this->window = glfwCreateWindow(this->width, this->height, title, nullptr, nullptr);
+
+    if (this->window == nullptr) {
+        std::cout << "Failed to create GLFW window" << std::endl;
+        glfwTerminate();
+        return false;
+    }
+
+    glfwMakeContextCurrent(this->window);
+
+    if (!gladLoadGLLoader((GLADloadproc) glfwGetProcAddress)) {
+        std::cout << "Failed to initialize GLAD" << std::endl;
+        return false;
+    }
+
+    // O vsync limitaria o benchmark à taxa do monitor.
+    if (this->options.benchmark) {
+        glfwSwapInterval(0);
+    }
+
+    if (this->onDemandActive) {
+        glfwGetFramebufferSize(this->window, &this->width, &this->height);
+        onDemandContext = this;
+        glfwSetWindowRefreshCallback(this->window, windowRefreshCallback);
+
+        if (!createOffscreenFramebuffer()) {
+            return false;
+        }
+        damageAll();
+    }
+
+    return true;
+}
+
+#ifdef RENDERER_HAS_EGL
+
+bool RenderContext::createHeadless() {
+    EGLDisplay display = EGL_NO_DISPLAY;
+
+    // A plataforma surfaceless da Mesa não precisa de servidor gráfico nem de /dev/dri.
+    const char* clientExtensions = eglQueryString(EGL_NO_DISPLAY, EGL_EXTENSIONS);
+    const auto getPlatformDisplay =
+            reinterpret_cast<PFNEGLGETPLATFORMDISPLAYEXTPROC>(eglGetProcAddress("eglGetPlatformDisplayEXT"));
+
+    if (getPlatformDisplay != nullptr && clientExtensions != nullptr &&
+        std::strstr(clientExtensions, "EGL_MESA_platform_surfaceless") != nullptr) {
+        display = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr);
+    }
+    if (display == EGL_NO_DISPLAY) {
+        display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+    }
+
+    if (display == EGL_NO_DISPLAY || !eglInitialize(display, nullptr, nullptr)) {
+        std::cout << "Failed to initialize EGL display" << std::endl;
+        return false;
+    }
+    this->eglDisplay = display;
+
+    if (!eglBindAPI(EGL_OPENGL_API)) {
+        std::cout << "Failed to bind the OpenGL API on EGL" << std::endl;
+        return false;
+    }
+
+    // Não pedimos nenhum tipo de superfície: tudo é desenhado no FBO.
+    const EGLint configAttributes[] = {
+        EGL_SURFACE_TYPE, 0,
+        EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+        EGL_NONE
+    };
+
+    EGLConfig config;
+    EGLint configCount = 0;
+    if (!eglChooseConfig(display, configAttributes, &config, 1, &configCount) || configCount == 0) {
+        std::cout << "Failed to choose an EGL config" << std::endl;
+        return false;
+    }
+
+    const EGLint contextAttributes[] = {
+        EGL_CONTEXT_MAJOR_VERSION, this->options.glMajor,
+        EGL_CONTEXT_MINOR_VERSION, this->options.glMinor,
+        EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+        EGL_NONE
+    };
+
+    EGLContext context = eglCreateContext(display, config, EGL_NO_CONTEXT, contextAttributes);
+    if (context == EGL_NO_CONTEXT) {
+        std::cout << "Failed to create EGL context" << std::endl;
+        return false;
+    }
+    this->eglContext = context;
+
+    if (!eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, context)) {
+        std::cout << "Failed to make the EGL context current (EGL_KHR_surfaceless_context missing?)" << std::endl;
+        return false;
+    }
+
+    if (!gladLoadGLLoader((GLADloadproc) eglGetProcAddress)) {
+        std::cout << "Failed to initialize GLAD" << std::endl;
+        return false;
+    }
+
+    return createOffscreenFramebuffer();
+}
+
+#else
+
+bool RenderContext::createHeadless() {
+    std::cout << "Headless rendering is not available: the renderer was built without EGL" << std::endl;
+    return false;
+}
+
+#endif
+
+bool RenderContext::createOffscreenFramebuffer() {
+    glGenRenderbuffers(1, &this->colorRenderbuffer);
+    glBindRenderbuffer(GL_RENDERBUFFER, this->colorRenderbuffer);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, this->width, this->height);
+
+    glGenRenderbuffers(1, &this->depthRenderbuffer);
+    glBindRenderbuffer(GL_RENDERBUFFER, this->depthRenderbuffer);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, this->width, this->height);
+
+    glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+    glGenFramebuffers(1, &this->offscreenFramebuffer);
+    glBindFramebuffer(GL_FRAMEBUFFER, this->offscreenFramebuffer);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, this->colorRenderbuffer);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, this->depthRenderbuffer);
+
+    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+        std::cout << "Failed to create the offscreen framebuffer" << std::endl;
+        return false;
+    }
+
+    // Fica ligado o tempo todo: para os exercícios ele faz o papel da janela.
+    return true;
+}
+
+void RenderContext::destroyOffscreenFramebuffer() {
+    if (this->offscreenFramebuffer == 0) {
+        return;
+    }
+
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    glDeleteFramebuffers(1, &this->offscreenFramebuffer);
+    glDeleteRenderbuffers(1, &this->colorRenderbuffer);
+    glDeleteRenderbuffers(1, &this->depthRenderbuffer);
+    this->offscreenFramebuffer = 0;
+    this->colorRenderbuffer = 0;
+    this->depthRenderbuffer = 0;
+}
+
+void RenderContext::resizeOnDemand() {
+    int width = 0;
+    int height = 0;
+    glfwGetFramebufferSize(this->window, &width, &height);
+
+    // Minimizada a janela tem tamanho 0: mantém o FBO até ela voltar.
+    if (width <= 0 || height <= 0 || (width == this->width && height == this->height)) {
+        return;
+    }
+
+    this->width = width;
+    this->height = height;
+    destroyOffscreenFramebuffer();
+    createOffscreenFramebuffer();
+    damageAll();
+}
+
+void RenderContext::windowRefreshCallback(GLFWwindow* window) {
+    // O FBO continua com a cena: basta copiá-lo de novo para a janela.
+    if (onDemandContext != nullptr && onDemandContext->window == window) {
+        onDemandContext->presentPending = true;
+    }
+}
+
+void RenderContext::damage(const int x, const int y, const int width, const int height) {
+    if (!this->onDemandActive) {
+        return;
+    }
+
+    const int left = std::max(x, 0);
+    const int bottom = std::max(y, 0);
+    const int right = std::min(x + width, this->width);
+    const int top = std::min(y + height, this->height);
+    if (right <= left || bottom >= top) {
+        return;
+    }
+
+    // Junta o retângulo com os que ele toca até não sobrar nenhum: a sobreposição seria desenhada duas vezes.
+    DamageRect rect{left, bottom, right - left, top - bottom};
+    for (size_t i = 0; i < this->damageRects.size();) {
+        if (touches(this->damageRects[i], rect)) {
+            rect = merged(this->damageRects[i], rect);
+            this->damageRects[i] = this->damageRects.back();
+            this->damageRects.pop_back();
+            i = 0;
+        } else {
+            i++;
+        }
+    }
+    this->damageRects.push_back(rect);
+
+    if (this->damageRects.size() > MAX_DAMAGE_RECTS) {
+        DamageRect bounds = this->damageRects.front();
+        for (const DamageRect& other : this->damageRects) {
+            bounds = merged(bounds, other);
+        }
+        this->damageRects.assign(1, bounds);
+    }
+}
+
+void RenderContext::damageAll() {
+    damage(0, 0, this->width, this->height);
+}
+
+void RenderContext::drawDamaged(const std::function<void()>& drawScene) {
+    if (!this->onDemandActive) {
+        drawScene();
+        return;
+    }
+
+    if (this->damageRects.empty()) {
+        return;
+    }
+
+    glEnable(GL_SCISSOR_TEST);
+    for (const DamageRect& rect : this->damageRects) {
+        glScissor(rect.x, rect.y, rect.width, rect.height);
+        drawScene();
+    }
+    glDisable(GL_SCISSOR_TEST);
+
+    this->damageRects.clear();
+    this->presentPending = true;
+}
+
+void RenderContext::drawDamagedFrame(const std::function<void(const std::vector<DamageRect>&)>& drawFrame) {
+    if (!this->onDemandActive) {
+        drawFrame({});
+        return;
+    }
+
+    if (this->damageRects.empty()) {
+        return;
+    }
+
+    drawFrame(this->damageRects);
+
+    this->damageRects.clear();
+    this->presentPending = true;
+}
+
+bool RenderContext::shouldClose() const {
+    const int warmupFrames = this->options.benchmark ? BENCHMARK_WARMUP_FRAMES : 0;
+    if (this->options.frames > 0 && this->frameCount >= this->options.frames + warmupFrames) {
+        return true;
+    }
+    return this->window != nullptr && glfwWindowShouldClose(this->window);
+}
+
+void RenderContext::pollEvents() {
+    if (this->window == nullptr) {
+        return;
+    }
+
+    if (!this->onDemandActive) {
+        glfwPollEvents();
+        return;
+    }
+
+    // Com a cena toda na tela não há o que fazer até chegar um evento: a CPU fica parada aqui.
+    if (this->damageRects.empty() && !this->presentPending && !this->frameRequested) {
+        PROFILE_ZONE("wait events");
+        glfwWaitEvents();
+    } else {
+        glfwPollEvents();
+    }
+    this->frameRequested = false;
+    resizeOnDemand();
+}
+
+void RenderContext::swapBuffers() {
+    // Nada mudou desde a última troca: a janela já mostra a cena e o frame não conta.
+    if (this->onDemandActive && !this->presentPending) {
+        resetDrawCallCount();
+        return;
+    }
+
+    // A leitura é enfileirada antes do swap, enquanto o back buffer ainda tem o frame.
+    if (this->golden.active()) {
+        this->golden.capture(framebuffer(), this->frameCount);
+    }
+    if (this->frameCapture.active()) {
+        this->frameCapture.capture(framebuffer());
+    }
+
+    {
+        PROFILE_ZONE("swap");
+        if (this->onDemandActive) {
+            glBindFramebuffer(GL_READ_FRAMEBUFFER, this->offscreenFramebuffer);
+            glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
+            glBlitFramebuffer(0, 0, this->width, this->height, 0, 0, this->width, this->height, GL_COLOR_BUFFER_BIT,
+                              GL_NEAREST);
+            glfwSwapBuffers(this->window);
+            glBindFramebuffer(GL_FRAMEBUFFER, this->offscreenFramebuffer);
+            this->presentPending = false;
+        } else if (this->window != nullptr) {
+            glfwSwapBuffers(this->window);
+        } else {
+            // Sem swap nada força o driver a executar os comandos do frame.
+            glFlush();
+        }
+    }
+
+    endProfilerFrame();
+
+    if (this->options.benchmark) {
+        // Sem esperar a GPU terminar o tempo medido seria só o de enfileirar comandos.
+        glFinish();
+
+        const auto now = std::chrono::steady_clock::now();
+        if (this->frameCount >= BENCHMARK_WARMUP_FRAMES) {
+            this->frameStats.record(std::chrono::duration<double>(now - this->frameStart).count(), drawCallCount());
+        }
+        this->frameStart = now;
+    }
+    resetDrawCallCount();
+
+    this->frameCount++;
+}
+
+double RenderContext::time() const {
+    if (this->window == nullptr || this->golden.active() || this->frameCapture.active()) {
+        return this->frameCount * HEADLESS_FRAME_TIME;
+    }
+    return glfwGetTime();
+}
+
+void RenderContext::writeBenchmarkReport(const std::string& exercise, const long long objects) const {
+    if (!this->options.benchmark) {
+        return;
+    }
+
+    BenchmarkReport report;
+    report.exercise = exercise;
+    report.objects = objects;
+    report.scale = this->options.scale;
+    report.seed = this->options.seed;
+    report.width = this->width;
+    report.height = this->height;
+    report.headless = this->options.headless;
+
+    this->frameStats.write(report, this->options.benchmarkOutput);
+}
+
+bool RenderContext::checkGoldenImages(const std::string& exercise) {
+    return this->golden.check(exercise);
+}
+
+void RenderContext::destroy() {
+    if (!this->options.profileOutput.empty()) {
+        writeChromeTrace(this->options.profileOutput);
+        destroyProfiler();
+    }
+
+    this->frameCapture.destroy();
+    this->golden.destroy();
+    destroyOffscreenFramebuffer();
+    if (onDemandContext == this) {
+        onDemandContext = nullptr;
+    }
+
+#ifdef RENDERER_HAS_EGL
+    if (this->eglDisplay != nullptr) {
+        eglMakeCurrent(this->eglDisplay, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+        if (this->eglContext != nullptr) {
+            eglDestroyContext(this->eglDisplay, this->eglContext);
+        }
+        eglTerminate(this->eglDisplay);
+        this->eglDisplay = nullptr;
+        this->eglContext = nullptr;
+    }
+#endif
+
+    if (this->window != nullptr) {
+        glfwTerminate();
+        this->window = nullptr;
+    }
+}
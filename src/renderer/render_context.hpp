@@ -0,0 +1,177 @@
+#pragma once
+
+#include <glad.h>
+
+#include <chrono>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "GLFW/glfw3.h"
+
+#include "renderer/benchmark.hpp"
+#include "renderer/frame_capture.hpp"
+#include "renderer/golden_image.hpp"
+
+// Frames renderizados no modo headless quando --frames não é informado.
+constexpr int HEADLESS_DEFAULT_FRAMES = 60;
+
+// Passo de tempo fixo do modo headless, do --golden e do --capture, para duas execuções produzirem as mesmas imagens.
+constexpr double HEADLESS_FRAME_TIME = 1.0 / 60.0;
+
+// Acima disso os retângulos danificados viram um só, o que os envolve: cada um custa um desenho da cena.
+constexpr int MAX_DAMAGE_RECTS = 8;
+
+struct DamageRect {
+    int x, y, width, height;
+};
+
+// Opções de linha de comando comuns a todos os executáveis:
+//   --headless    renderiza sem janela (EGL) em um framebuffer offscreen
+//   --frames N    encerra depois de N frames (0 roda até a janela ser fechada)
+//   --profile F   liga o profiler e grava um trace do Chrome em F ao encerrar
+//   --benchmark   mede cada frame (sem vsync, com glFinish) e imprime um relatório JSON ao encerrar
+//   --benchmark-output F   grava o relatório em F em vez da saída padrão
+//   --scale N     tamanho da cena; o que conta como objeto depende do exercício (0 usa o padrão)
+//   --seed S      semente do rand() usado para montar a cena
+//   --width W, --height H  resolução da janela ou do framebuffer offscreen
+//   --on-demand   só redesenha o que mudou e dorme em glfwWaitEvents enquanto nada muda (ignorado com
+//                 --headless e --benchmark)
+//   --software    rasteriza a cena na CPU (SoftwareRasterizer); a GPU só mostra a imagem pronta
+//   --golden DIR  compara alguns frames com as imagens de referência em DIR; o código de saída diz
+//                 se passaram (desliga --on-demand e, sem --frames, roda HEADLESS_DEFAULT_FRAMES)
+//   --golden-update        grava os frames como novas referências em vez de comparar
+//   --golden-frames A,B,C  frames comparados (padrão: o primeiro, o do meio e o último)
+//   --golden-tolerance N   diferença aceita por canal (padrão GOLDEN_DEFAULT_TOLERANCE)
+//   --capture P   grava todos os frames: P terminado em .y4m vira um vídeo, senão um diretório de PNGs
+//                 (desliga --on-demand)
+struct ContextOptions {
+    bool headless = false;
+    int frames = 0;
+    std::string profileOutput;
+
+    bool benchmark = false;
+    std::string benchmarkOutput;
+    int scale = 0;
+    unsigned int seed = 1;
+    int width = 0;
+    int height = 0;
+    bool onDemand = false;
+    bool software = false;
+
+    std::string goldenDirectory;
+    bool goldenUpdate = false;
+    std::vector<int> goldenFrames;
+    int goldenTolerance = GOLDEN_DEFAULT_TOLERANCE;
+    std::string captureOutput;
+
+    // Versão do contexto. Não vem da linha de comando: o exercício pede mais que 3.3 quando precisa
+    // (compute shaders precisam de 4.3, que o macOS não tem).
+    int glMajor = 3;
+    int glMinor = 3;
+};
+
+// Argumentos desconhecidos são ignorados para cada exercício poder ler os seus.
+bool parseContextOptions(int argc, char** argv, ContextOptions& options);
+
+// Contexto OpenGL core de um exercício (3.3, a não ser que as opções peçam outra versão): uma
+// janela GLFW ou, no modo headless, um contexto EGL sem superfície renderizando em um FBO do
+// tamanho pedido.
+//
+// No modo sob demanda a cena fica em um FBO persistente copiado para a janela a cada apresentação: o
+// exercício marca com damage() o que mudou e drawDamaged() só redesenha esses retângulos. Sem dano o
+// pollEvents() bloqueia até chegar um evento e o swapBuffers() não faz nada.
+class RenderContext {
+public:
+    // nullptr no modo headless; toda entrada de usuário deve checar isso antes.
+    GLFWwindow* window = nullptr;
+
+    int width = 0;
+    int height = 0;
+
+    // width e height são o padrão do exercício; --width e --height têm prioridade.
+    // samples só vale para a janela; o FBO headless não tem multisample.
+    bool create(int width, int height, const char* title, const ContextOptions& options, int samples = 0);
+
+    bool shouldClose() const;
+
+    void pollEvents();
+
+    // Também fecha o frame do profiler e, no modo benchmark, mede o frame.
+    void swapBuffers();
+
+    // Segundos desde a criação. No modo headless, no --golden e no --capture avança HEADLESS_FRAME_TIME por frame.
+    double time() const;
+
+    int frame() const { return this->frameCount; }
+
+    bool headless() const { return this->options.headless; }
+
+    bool onDemand() const { return this->onDemandActive; }
+
+    // Marca um retângulo do framebuffer como sujo, em pixels com origem embaixo à esquerda.
+    // Fora do modo sob demanda não faz nada: todo frame já redesenha tudo.
+    void damage(int x, int y, int width, int height);
+
+    void damageAll();
+
+    // Faz o próximo pollEvents() não esperar: para efeitos que continuam sem eventos novos, como um
+    // botão segurado.
+    void requestFrame() { this->frameRequested = true; }
+
+    // Fora do modo sob demanda chama drawScene uma vez. Nele chama uma vez por retângulo danificado,
+    // com o scissor recortando, e nenhuma se nada mudou.
+    void drawDamaged(const std::function<void()>& drawScene);
+
+    // Para quem monta o frame inteiro de uma vez, como o SoftwareRasterizer: drawFrame é chamada uma
+    // vez só, com os retângulos a copiar para o framebuffer (vazio fora do modo sob demanda, quando
+    // vale o frame todo), e nenhuma se nada mudou. O recorte fica com quem copia.
+    void drawDamagedFrame(const std::function<void(const std::vector<DamageRect>&)>& drawFrame);
+
+    // No modo benchmark grava o relatório dos frames medidos; fora dele não faz nada.
+    void writeBenchmarkReport(const std::string& exercise, long long objects) const;
+
+    // No modo --golden compara (ou grava) os frames lidos e devolve se todos bateram; fora dele devolve true.
+    bool checkGoldenImages(const std::string& exercise);
+
+    // Framebuffer onde a cena é desenhada: 0 com janela, o FBO offscreen no modo headless ou sob demanda.
+    GLuint framebuffer() const { return this->offscreenFramebuffer; }
+
+    void destroy();
+
+private:
+    bool createWindow(const char* title, int samples);
+
+    bool createHeadless();
+
+    bool createOffscreenFramebuffer();
+
+    void destroyOffscreenFramebuffer();
+
+    static void windowRefreshCallback(GLFWwindow* window);
+
+    // Acompanha o tamanho do framebuffer da janela, recriando o FBO do modo sob demanda.
+    void resizeOnDemand();
+
+    ContextOptions options;
+    int frameCount = 0;
+
+    bool onDemandActive = false;
+    std::vector<DamageRect> damageRects;
+    // Há algo desenhado no FBO que a janela ainda não mostrou (ou a janela pediu para ser repintada).
+    bool presentPending = false;
+    bool frameRequested = false;
+
+    FrameStats frameStats;
+    GoldenImageTest golden;
+    FrameCapture frameCapture;
+    std::chrono::steady_clock::time_point frameStart;
+
+    GLuint offscreenFramebuffer = 0;
+    GLuint colorRenderbuffer = 0;
+    GLuint depthRenderbuffer = 0;
+
+    // Objetos EGL guardados como void* para o cabeçalho não depender do EGL.
+    void* eglDisplay = nullptr;
+    void* eglContext = nullptr;
+};
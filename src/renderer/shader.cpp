@@ -0,0 +1,257 @@
+#include "renderer/shader.hpp"
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <vector>
+
+namespace {
+    constexpr uint32_t PROGRAM_CACHE_MAGIC = 0x42534750; // "PGSB"
+    constexpr uint32_t PROGRAM_CACHE_VERSION = 2;
+
+    struct ProgramCacheHeader {
+        uint32_t magic;
+        uint32_t version;
+        uint64_t key;
+        uint32_t format;
+        uint32_t length;
+    };
+
+    // FNV-1a de 64 bits: não precisa ser criptográfico, só espalhar bem as fontes.
+    void hashBytes(uint64_t& hash, const void* data, const size_t length) {
+        const auto* bytes = static_cast<const unsigned char*>(data);
+        for (size_t i = 0; i < length; i++) {
+            hash ^= bytes[i];
+            hash *= 0x100000001b3ull;
+        }
+    }
+
+    void hashString(uint64_t& hash, const char* text) {
+        const std::string value = text ? text : "";
+        hashBytes(hash, value.data(), value.size());
+        // Separador para "ab" + "c" não colidir com "a" + "bc".
+        hashBytes(hash, "\0", 1);
+    }
+
+    // Fonte de cada estágio do programa, já com os defines.
+    using ShaderStages = std::vector<std::pair<GLenum, std::string>>;
+
+    uint64_t programCacheKey(const ShaderStages& stages, const std::string& defines) {
+        uint64_t hash = 0xcbf29ce484222325ull;
+
+        hashBytes(hash, &PROGRAM_CACHE_VERSION, sizeof(PROGRAM_CACHE_VERSION));
+        hashString(hash, reinterpret_cast<const char*>(glGetString(GL_VENDOR)));
+        hashString(hash, reinterpret_cast<const char*>(glGetString(GL_RENDERER)));
+        hashString(hash, reinterpret_cast<const char*>(glGetString(GL_VERSION)));
+        hashString(hash, defines.c_str());
+        for (const auto& [type, source] : stages) {
+            hashBytes(hash, &type, sizeof(type));
+            hashString(hash, source.c_str());
+        }
+
+        return hash;
+    }
+
+    std::filesystem::path programCacheDirectory() {
+        if (const char* directory = std::getenv("PG_SHADER_CACHE_DIR")) {
+            return directory;
+        }
+
+        if (const char* cacheHome = std::getenv("XDG_CACHE_HOME"); cacheHome && *cacheHome) {
+            return std::filesystem::path(cacheHome) / "processamento-grafico" / "shaders";
+        }
+
+#ifdef _WIN32
+        if (const char* localAppData = std::getenv("LOCALAPPDATA")) {
+            return std::filesystem::path(localAppData) / "processamento-grafico" / "shaders";
+        }
+#else
+        if (const char* home = std::getenv("HOME")) {
+            return std::filesystem::path(home) / ".cache" / "processamento-grafico" / "shaders";
+        }
+#endif
+
+        return {};
+    }
+
+    std::filesystem::path programCachePath(const uint64_t key) {
+        const std::filesystem::path directory = programCacheDirectory();
+        if (directory.empty()) {
+            return {};
+        }
+
+        char name[32];
+        std::snprintf(name, sizeof(name), "%016llx.bin", static_cast<unsigned long long>(key));
+        return directory / name;
+    }
+
+    bool programBinariesSupported() {
+        GLint formats = 0;
+        glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+        return formats > 0;
+    }
+
+    GLuint loadCachedProgram(const std::filesystem::path& path, const uint64_t key) {
+        std::ifstream file(path, std::ios::binary);
+        if (!file) {
+            return 0;
+        }
+
+        ProgramCacheHeader header = {};
+        file.read(reinterpret_cast<char*>(&header), sizeof(header));
+        if (!file || header.magic != PROGRAM_CACHE_MAGIC || header.version != PROGRAM_CACHE_VERSION
+            || header.key != key) {
+            return 0;
+        }
+
+        std::vector<char> binary(header.length);
+        file.read(binary.data(), header.length);
+        if (!file) {
+            return 0;
+        }
+
+        const GLuint program = glCreateProgram();
+        glProgramBinary(program, header.format, binary.data(), static_cast<GLsizei>(binary.size()));
+
+        // Uma atualização de driver pode recusar o binário mesmo com vendor/versão iguais.
+        int success;
+        glGetProgramiv(program, GL_LINK_STATUS, &success);
+        if (!success) {
+            glDeleteProgram(program);
+            return 0;
+        }
+
+        return program;
+    }
+
+    void storeCachedProgram(const std::filesystem::path& path, const uint64_t key, const GLuint program) {
+        GLint length = 0;
+        glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+        if (length <= 0) {
+            return;
+        }
+
+        std::vector<char> binary(length);
+        GLenum format = 0;
+        glGetProgramBinary(program, length, nullptr, &format, binary.data());
+
+        std::error_code error;
+        std::filesystem::create_directories(path.parent_path(), error);
+
+        // Escreve em um arquivo temporário e renomeia, para execuções paralelas nunca lerem um binário pela metade.
+        std::filesystem::path temporary = path;
+        temporary += ".tmp" + std::to_string(std::chrono::steady_clock::now().time_since_epoch().count());
+
+        {
+            std::ofstream file(temporary, std::ios::binary | std::ios::trunc);
+            if (!file) {
+                return;
+            }
+
+            const ProgramCacheHeader header = {
+                PROGRAM_CACHE_MAGIC,
+                PROGRAM_CACHE_VERSION,
+                key,
+                format,
+                static_cast<uint32_t>(length),
+            };
+            file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+            file.write(binary.data(), length);
+        }
+
+        std::filesystem::rename(temporary, path, error);
+        if (error) {
+            std::filesystem::remove(temporary, error);
+        }
+    }
+
+    std::string injectDefines(const char* source, const std::string& defines) {
+        std::string result = source;
+        if (defines.empty()) {
+            return result;
+        }
+
+        const size_t version = result.find("#version");
+        const size_t lineEnd = version == std::string::npos ? std::string::npos : result.find('\n', version);
+        if (lineEnd == std::string::npos) {
+            return defines + "\n" + result;
+        }
+
+        result.insert(lineEnd + 1, defines + "\n");
+        return result;
+    }
+
+    GLuint createProgram(const ShaderStages& stages, const std::string& defines) {
+        const bool cacheEnabled = programBinariesSupported();
+        const uint64_t key = cacheEnabled ? programCacheKey(stages, defines) : 0;
+        const std::filesystem::path cachePath = cacheEnabled ? programCachePath(key) : std::filesystem::path();
+
+        if (!cachePath.empty()) {
+            if (const GLuint program = loadCachedProgram(cachePath, key)) {
+                return program;
+            }
+        }
+
+        const GLuint shaderProgram = glCreateProgram();
+        std::vector<GLuint> shaders;
+        for (const auto& [type, source] : stages) {
+            shaders.push_back(compileShader(source.c_str(), static_cast<int>(type)));
+            glAttachShader(shaderProgram, shaders.back());
+        }
+
+        if (!cachePath.empty()) {
+            glProgramParameteri(shaderProgram, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+        }
+
+        glLinkProgram(shaderProgram);
+
+        int success;
+        glGetProgramiv(shaderProgram, GL_LINK_STATUS, &success);
+        if (!success) {
+            char infoLog[512];
+            glGetProgramInfoLog(shaderProgram, sizeof(infoLog), nullptr, infoLog);
+            std::cout << "ERROR::SHADER::PROGRAM::LINKING_FAILED\n" << infoLog << std::endl;
+        } else if (!cachePath.empty()) {
+            storeCachedProgram(cachePath, key, shaderProgram);
+        }
+
+        for (const GLuint shader : shaders) {
+            glDeleteShader(shader);
+        }
+
+        return shaderProgram;
+    }
+}
+
+GLuint compileShader(const char* shaderSource, int shaderType) {
+    const GLuint shaderId = glCreateShader(shaderType);
+    glShaderSource(shaderId, 1, &shaderSource, nullptr);
+    glCompileShader(shaderId);
+
+    int success;
+    glGetShaderiv(shaderId, GL_COMPILE_STATUS, &success);
+
+    if (!success) {
+        char infoLog[512];
+        glGetShaderInfoLog(shaderId, sizeof(infoLog), nullptr, infoLog);
+        std::cout << "ERROR::SHADER::COMPILATION_FAILED\n" << infoLog << std::endl;
+    }
+
+    return shaderId;
+}
+
+GLuint createShaderProgram(const char* vertexShaderSource, const char* fragmentShaderSource,
+                           const std::string& defines) {
+    return createProgram({
+        {GL_VERTEX_SHADER, injectDefines(vertexShaderSource, defines)},
+        {GL_FRAGMENT_SHADER, injectDefines(fragmentShaderSource, defines)},
+    }, defines);
+}
+
+GLuint createComputeProgram(const char* computeShaderSource, const std::string& defines) {
+    return createProgram({{GL_COMPUTE_SHADER, injectDefines(computeShaderSource, defines)}}, defines);
+}
@@ -0,0 +1,22 @@
+#pragma once
+
+#include <glad.h>
+
+#include <string>
+#include <utility>
+#include <vector>
+
+GLuint compileShader(const char* shaderSource, int shaderType);
+
+// Compila e linka o programa. `defines` (linhas "#define ...") é inserido logo depois da linha
+// #version dos dois shaders.
+//
+// Programas linkados ficam guardados em disco com glGetProgramBinary, indexados por um hash das
+// fontes, dos defines e do vendor/renderer/versão do driver; na próxima execução o binário é
+// recarregado com glProgramBinary e só volta a compilar se o driver recusar. O diretório vem de
+// PG_SHADER_CACHE_DIR (vazio desativa o cache), senão de $XDG_CACHE_HOME ou ~/.cache.
+GLuint createShaderProgram(const char* vertexShaderSource, const char* fragmentShaderSource,
+                           const std::string& defines = "");
+
+// O mesmo para um compute shader sozinho (GL 4.3).
+GLuint createComputeProgram(const char* computeShaderSource, const std::string& defines = "");
@@ -0,0 +1,597 @@
+#include "renderer/software_rasterizer.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstring>
+
+#include "renderer/gl_state.hpp"
+#include "renderer/profiler.hpp"
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define RASTERIZER_USE_SSE2
+#endif
+
+namespace {
+    uint32_t packColor(const glm::vec4& color) {
+        const auto channel = [](const float value) {
+            const float clamped = value < 0.0f ? 0.0f : value > 1.0f ? 1.0f : value;
+            return static_cast<uint32_t>(clamped * 255.0f + 0.5f);
+        };
+
+        return channel(color.r) | channel(color.g) << 8 | channel(color.b) << 16 | channel(color.a) << 24;
+    }
+
+    // x * y / 255 arredondado, exato para x e y em [0, 255].
+    uint32_t multiplyChannel(const uint32_t x, const uint32_t y) {
+        const uint32_t t = x * y + 128;
+        return (t + (t >> 8)) >> 8;
+    }
+
+    uint32_t modulate(const uint32_t texel, const uint32_t tint) {
+        uint32_t result = 0;
+        for (int shift = 0; shift < 32; shift += 8) {
+            result |= multiplyChannel(texel >> shift & 0xff, tint >> shift & 0xff) << shift;
+        }
+        return result;
+    }
+
+    // u = a * x + b * y + c passando pelos três pontos.
+    void planeThrough(const glm::vec2 (&points)[3], const float (&values)[3], float (&plane)[3]) {
+        const glm::vec2 edge1 = points[1] - points[0];
+        const glm::vec2 edge2 = points[2] - points[0];
+        const float determinant = edge1.x * edge2.y - edge2.x * edge1.y;
+        const float delta1 = values[1] - values[0];
+        const float delta2 = values[2] - values[0];
+
+        plane[0] = (delta1 * edge2.y - delta2 * edge1.y) / determinant;
+        plane[1] = (edge1.x * delta2 - edge2.x * delta1) / determinant;
+        plane[2] = values[0] - plane[0] * points[0].x - plane[1] * points[0].y;
+    }
+
+    // Regra top-left: o pixel exatamente em cima de uma aresta compartilhada fica com um só dos
+    // dois triângulos. A aresta vizinha tem (a, b, c) negados exatamente, então E também é negado.
+    bool inclusiveEdge(const float a, const float b) {
+        return a > 0.0f || (a == 0.0f && b < 0.0f);
+    }
+
+    // Pixels da linha y que podem estar dentro, resolvendo cada aresta para x. Sobra um pixel de
+    // cada lado por causa do arredondamento; quem decide de fato é o teste das arestas.
+    bool rowSpan(const float (&edges)[9], const float y, int& first, int& last) {
+        float left = -INFINITY;
+        float right = INFINITY;
+        for (int i = 0; i < 3; i++) {
+            const float a = edges[i * 3];
+            const float rest = edges[i * 3 + 1] * y + edges[i * 3 + 2];
+            if (a > 0.0f) {
+                left = std::max(left, -rest / a);
+            } else if (a < 0.0f) {
+                right = std::min(right, -rest / a);
+            } else if (rest < 0.0f) {
+                return false;
+            }
+        }
+
+        if (left > right + 2.0f) {
+            return false;
+        }
+        first = std::isfinite(left) ? std::max(first, static_cast<int>(std::floor(left - 0.5f)) - 1) : first;
+        last = std::isfinite(right) ? std::min(last, static_cast<int>(std::ceil(right - 0.5f)) + 1) : last;
+        return first <= last;
+    }
+
+#ifdef RASTERIZER_USE_SSE2
+
+    // Funções de aresta de 4 pixels vizinhos de uma linha por vez.
+    class EdgeStepper {
+    public:
+        explicit EdgeStepper(const float (&edges)[9]) {
+            for (int i = 0; i < 3; i++) {
+                this->a[i] = _mm_set1_ps(edges[i * 3]);
+                this->b[i] = edges[i * 3 + 1];
+                this->c[i] = edges[i * 3 + 2];
+                this->inclusive[i] = _mm_castsi128_ps(
+                        _mm_set1_epi32(inclusiveEdge(edges[i * 3], edges[i * 3 + 1]) ? -1 : 0));
+            }
+        }
+
+        void beginRow(const float y) {
+            for (int i = 0; i < 3; i++) {
+                this->row[i] = _mm_set1_ps(this->b[i] * y + this->c[i]);
+            }
+        }
+
+        // Bit k ligado se o centro do pixel x + k está dentro.
+        int mask(const float x) const {
+            const __m128 px = _mm_add_ps(_mm_set1_ps(x), _mm_set_ps(3.5f, 2.5f, 1.5f, 0.5f));
+            const __m128 zero = _mm_setzero_ps();
+
+            __m128 inside = _mm_castsi128_ps(_mm_set1_epi32(-1));
+            for (int i = 0; i < 3; i++) {
+                const __m128 value = _mm_add_ps(_mm_mul_ps(this->a[i], px), this->row[i]);
+                const __m128 edgeInside = _mm_or_ps(_mm_cmpgt_ps(value, zero),
+                                                    _mm_and_ps(_mm_cmpeq_ps(value, zero), this->inclusive[i]));
+                inside = _mm_and_ps(inside, edgeInside);
+            }
+            return _mm_movemask_ps(inside);
+        }
+
+    private:
+        __m128 a[3];
+        float b[3];
+        float c[3];
+        __m128 inclusive[3];
+        __m128 row[3];
+    };
+
+    // fract() sem SSE4.1: trunca e corrige os negativos.
+    __m128 fract(const __m128 value) {
+        const __m128 truncated = _mm_cvtepi32_ps(_mm_cvttps_epi32(value));
+        const __m128 floor = _mm_sub_ps(truncated, _mm_and_ps(_mm_cmpgt_ps(truncated, value), _mm_set1_ps(1.0f)));
+        return _mm_sub_ps(value, floor);
+    }
+
+    // Texel (GL_NEAREST, clamp to edge) de region.xy + fract(uv) * region.zw em 4 pixels vizinhos.
+    __m128i texelAxis(const float (&plane)[3], const __m128 px, const float y, const float offset, const float extent,
+                      const int size) {
+        const __m128 value = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(plane[0]), px), _mm_set1_ps(plane[1] * y + plane[2]));
+        const __m128 coordinate = _mm_add_ps(_mm_set1_ps(offset), _mm_mul_ps(fract(value), _mm_set1_ps(extent)));
+        const __m128 scaled = _mm_mul_ps(coordinate, _mm_set1_ps(static_cast<float>(size)));
+        const __m128 clamped = _mm_min_ps(_mm_max_ps(scaled, _mm_setzero_ps()),
+                                          _mm_set1_ps(static_cast<float>(size - 1)));
+        return _mm_cvttps_epi32(clamped);
+    }
+
+    void texelCoordinates(const float (&u)[3], const float (&v)[3], const glm::vec4& region, const int width,
+                          const int height, const float x, const float y, int (&columns)[4], int (&rows)[4]) {
+        const __m128 px = _mm_add_ps(_mm_set1_ps(x), _mm_set_ps(3.5f, 2.5f, 1.5f, 0.5f));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(columns), texelAxis(u, px, y, region.x, region.z, width));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(rows), texelAxis(v, px, y, region.y, region.w, height));
+    }
+
+    // Blend GL_SRC_ALPHA/GL_ONE_MINUS_SRC_ALPHA de 4 pixels, nos 4 canais, em inteiros de 16 bits.
+    __m128i blendHalf(const __m128i source, const __m128i destination) {
+        __m128i alpha = _mm_shufflelo_epi16(source, _MM_SHUFFLE(3, 3, 3, 3));
+        alpha = _mm_shufflehi_epi16(alpha, _MM_SHUFFLE(3, 3, 3, 3));
+        const __m128i inverse = _mm_sub_epi16(_mm_set1_epi16(255), alpha);
+
+        const __m128i sum = _mm_add_epi16(_mm_add_epi16(_mm_mullo_epi16(source, alpha),
+                                                         _mm_mullo_epi16(destination, inverse)),
+                                          _mm_set1_epi16(128));
+        return _mm_srli_epi16(_mm_add_epi16(sum, _mm_srli_epi16(sum, 8)), 8);
+    }
+
+    void blendPixels(const uint32_t (&source)[4], uint32_t (&destination)[4]) {
+        const __m128i zero = _mm_setzero_si128();
+        const __m128i src = _mm_loadu_si128(reinterpret_cast<const __m128i*>(source));
+        const __m128i dst = _mm_loadu_si128(reinterpret_cast<const __m128i*>(destination));
+
+        const __m128i low = blendHalf(_mm_unpacklo_epi8(src, zero), _mm_unpacklo_epi8(dst, zero));
+        const __m128i high = blendHalf(_mm_unpackhi_epi8(src, zero), _mm_unpackhi_epi8(dst, zero));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(destination), _mm_packus_epi16(low, high));
+    }
+
+#else
+
+    class EdgeStepper {
+    public:
+        explicit EdgeStepper(const float (&edges)[9]) {
+            for (int i = 0; i < 3; i++) {
+                this->a[i] = edges[i * 3];
+                this->b[i] = edges[i * 3 + 1];
+                this->c[i] = edges[i * 3 + 2];
+                this->inclusive[i] = inclusiveEdge(this->a[i], this->b[i]);
+            }
+        }
+
+        void beginRow(const float y) {
+            for (int i = 0; i < 3; i++) {
+                this->row[i] = this->b[i] * y + this->c[i];
+            }
+        }
+
+        int mask(const float x) const {
+            int result = 0;
+            for (int k = 0; k < 4; k++) {
+                bool inside = true;
+                for (int i = 0; i < 3 && inside; i++) {
+                    const float value = this->a[i] * (x + static_cast<float>(k) + 0.5f) + this->row[i];
+                    inside = value > 0.0f || (value == 0.0f && this->inclusive[i]);
+                }
+                result |= inside ? 1 << k : 0;
+            }
+            return result;
+        }
+
+    private:
+        float a[3];
+        float b[3];
+        float c[3];
+        bool inclusive[3];
+        float row[3];
+    };
+
+    int texelAxis(const float (&plane)[3], const float x, const float y, const float offset, const float extent,
+                  const int size) {
+        const float value = plane[0] * x + (plane[1] * y + plane[2]);
+        const float coordinate = offset + (value - std::floor(value)) * extent;
+        return std::clamp(static_cast<int>(coordinate * static_cast<float>(size)), 0, size - 1);
+    }
+
+    void texelCoordinates(const float (&u)[3], const float (&v)[3], const glm::vec4& region, const int width,
+                          const int height, const float x, const float y, int (&columns)[4], int (&rows)[4]) {
+        for (int k = 0; k < 4; k++) {
+            const float px = x + static_cast<float>(k) + 0.5f;
+            columns[k] = texelAxis(u, px, y, region.x, region.z, width);
+            rows[k] = texelAxis(v, px, y, region.y, region.w, height);
+        }
+    }
+
+    void blendPixels(const uint32_t (&source)[4], uint32_t (&destination)[4]) {
+        for (int k = 0; k < 4; k++) {
+            const uint32_t alpha = source[k] >> 24;
+            uint32_t result = 0;
+            for (int shift = 0; shift < 32; shift += 8) {
+                const uint32_t t = (source[k] >> shift & 0xff) * alpha
+                                   + (destination[k] >> shift & 0xff) * (255 - alpha) + 128;
+                result |= ((t + (t >> 8)) >> 8) << shift;
+            }
+            destination[k] = result;
+        }
+    }
+
+#endif
+
+}
+
+SoftwareRasterizer::SoftwareRasterizer(const unsigned int threads) : workers(threads) {
+}
+
+void SoftwareRasterizer::create(const int width, const int height) {
+    this->imageWidth = width;
+    this->imageHeight = height;
+    this->tilesX = (width + SOFTWARE_TILE_SIZE - 1) / SOFTWARE_TILE_SIZE;
+    this->tilesY = (height + SOFTWARE_TILE_SIZE - 1) / SOFTWARE_TILE_SIZE;
+
+    this->colorBuffer.assign(static_cast<size_t>(width) * height, 0);
+    this->bins.assign(static_cast<size_t>(this->tilesX) * this->tilesY, {});
+
+    glGenTextures(1, &this->texture);
+    bindTexture(GL_TEXTURE_2D, this->texture);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+
+    // Só serve de origem para o glBlitFramebuffer do present().
+    GLint previous = 0;
+    glGetIntegerv(GL_FRAMEBUFFER_BINDING, &previous);
+    glGenFramebuffers(1, &this->readFramebuffer);
+    glBindFramebuffer(GL_FRAMEBUFFER, this->readFramebuffer);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, this->texture, 0);
+    glBindFramebuffer(GL_FRAMEBUFFER, static_cast<GLuint>(previous));
+}
+
+void SoftwareRasterizer::destroy() {
+    deleteTexture(this->texture);
+    glDeleteFramebuffers(1, &this->readFramebuffer);
+    this->texture = 0;
+    this->readFramebuffer = 0;
+
+    this->textures.clear();
+}
+
+void SoftwareRasterizer::setProjection(const glm::mat4& projection) {
+    this->projection = projection;
+}
+
+void SoftwareRasterizer::addTexture(const GLuint textureId, const Image& image) {
+    SoftwareTexture& texture = this->textures[textureId];
+    texture.width = image.width;
+    texture.height = image.height;
+    texture.texels.resize(static_cast<size_t>(image.width) * image.height);
+    std::memcpy(texture.texels.data(), image.pixels.data(), texture.texels.size() * sizeof(uint32_t));
+}
+
+void SoftwareRasterizer::clear(const glm::vec4& color) {
+    this->clearColor = packColor(color);
+    this->primitives.clear();
+    this->spriteData.clear();
+    for (std::vector<uint32_t>& bin : this->bins) {
+        bin.clear();
+    }
+}
+
+glm::vec2 SoftwareRasterizer::toPixels(const glm::vec2& point) const {
+    const glm::vec4 clip = this->projection * glm::vec4(point.x, point.y, 0.0f, 1.0f);
+    return glm::vec2(
+        (clip.x / clip.w * 0.5f + 0.5f) * static_cast<float>(this->imageWidth),
+        (clip.y / clip.w * 0.5f + 0.5f) * static_cast<float>(this->imageHeight)
+    );
+}
+
+bool SoftwareRasterizer::addTriangle(glm::vec2 a, glm::vec2 b, glm::vec2 c, const uint32_t color,
+                                     const PrimitiveKind kind, const int sprite) {
+    const float area = (b.x - a.x) * (c.y - a.y) - (c.x - a.x) * (b.y - a.y);
+    if (area == 0.0f) {
+        return false;
+    }
+    // As arestas esperam sentido anti-horário; o espelhamento das projeções inverte alguns.
+    if (area < 0.0f) {
+        std::swap(b, c);
+    }
+
+    Primitive primitive = {};
+    const glm::vec2 vertices[3] = {a, b, c};
+    for (int i = 0; i < 3; i++) {
+        const glm::vec2& from = vertices[i];
+        const glm::vec2& to = vertices[(i + 1) % 3];
+        primitive.edges[i * 3] = from.y - to.y;
+        primitive.edges[i * 3 + 1] = to.x - from.x;
+        primitive.edges[i * 3 + 2] = from.x * to.y - to.x * from.y;
+    }
+
+    // Pixels cujo centro (i + 0.5) cai dentro da caixa do triângulo.
+    const glm::vec2 low = glm::min(a, glm::min(b, c));
+    const glm::vec2 high = glm::max(a, glm::max(b, c));
+    primitive.minX = std::max(0, static_cast<int>(std::ceil(low.x - 0.5f)));
+    primitive.minY = std::max(0, static_cast<int>(std::ceil(low.y - 0.5f)));
+    primitive.maxX = std::min(this->imageWidth - 1, static_cast<int>(std::floor(high.x - 0.5f)));
+    primitive.maxY = std::min(this->imageHeight - 1, static_cast<int>(std::floor(high.y - 0.5f)));
+    if (primitive.minX > primitive.maxX || primitive.minY > primitive.maxY) {
+        return false;
+    }
+
+    primitive.color = color;
+    primitive.kind = kind;
+    primitive.sprite = sprite;
+
+    this->primitives.push_back(primitive);
+    bin(static_cast<uint32_t>(this->primitives.size() - 1));
+    return true;
+}
+
+void SoftwareRasterizer::bin(const uint32_t primitive) {
+    const Primitive& bounds = this->primitives[primitive];
+    for (int tileY = bounds.minY / SOFTWARE_TILE_SIZE; tileY <= bounds.maxY / SOFTWARE_TILE_SIZE; tileY++) {
+        for (int tileX = bounds.minX / SOFTWARE_TILE_SIZE; tileX <= bounds.maxX / SOFTWARE_TILE_SIZE; tileX++) {
+            this->bins[static_cast<size_t>(tileY) * this->tilesX + tileX].push_back(primitive);
+        }
+    }
+}
+
+void SoftwareRasterizer::drawTriangle(const glm::vec2& a, const glm::vec2& b, const glm::vec2& c,
+                                      const glm::vec4& color) {
+    addTriangle(toPixels(a), toPixels(b), toPixels(c), packColor(color), PrimitiveKind::Triangle, -1);
+}
+
+void SoftwareRasterizer::drawRect(const glm::vec2& corner, const glm::vec2& oppositeCorner, const glm::vec4& color) {
+    const glm::vec2 a = toPixels(corner);
+    const glm::vec2 b = toPixels(oppositeCorner);
+    const glm::vec2 low = glm::min(a, b);
+    const glm::vec2 high = glm::max(a, b);
+
+    // Intervalo meio aberto, para retângulos vizinhos não dividirem uma coluna de pixels.
+    Primitive primitive = {};
+    primitive.minX = std::max(0, static_cast<int>(std::ceil(low.x - 0.5f)));
+    primitive.minY = std::max(0, static_cast<int>(std::ceil(low.y - 0.5f)));
+    primitive.maxX = std::min(this->imageWidth, static_cast<int>(std::ceil(high.x - 0.5f))) - 1;
+    primitive.maxY = std::min(this->imageHeight, static_cast<int>(std::ceil(high.y - 0.5f))) - 1;
+    if (primitive.minX > primitive.maxX || primitive.minY > primitive.maxY) {
+        return;
+    }
+
+    primitive.color = packColor(color);
+    primitive.kind = PrimitiveKind::Rect;
+    primitive.sprite = -1;
+
+    this->primitives.push_back(primitive);
+    bin(static_cast<uint32_t>(this->primitives.size() - 1));
+}
+
+void SoftwareRasterizer::drawSprite(const AtlasRegion& region, const glm::vec2& position, const float rotation,
+                                    const glm::vec2& size, const glm::vec4& uvRect, const glm::vec4& tint) {
+    const auto texture = this->textures.find(region.textureId);
+    if (texture == this->textures.end()) {
+        return;
+    }
+
+    // Mesmos cantos e UVs do SpriteBatch.
+    const float cosine = std::cos(rotation);
+    const float sine = std::sin(rotation);
+    const glm::vec2 axisX = glm::vec2(cosine, sine) * (size.x * 0.5f);
+    const glm::vec2 axisY = glm::vec2(-sine, cosine) * (size.y * 0.5f);
+
+    const glm::vec2 corners[4] = {
+        toPixels(position - axisX - axisY),
+        toPixels(position + axisX - axisY),
+        toPixels(position + axisX + axisY),
+        toPixels(position - axisX + axisY),
+    };
+
+    // A projeção é ortográfica, então u e v são afins na tela e três cantos definem o quad inteiro.
+    SpriteData data = {};
+    const glm::vec2 plane[3] = {corners[0], corners[1], corners[2]};
+    const float us[3] = {uvRect.x, uvRect.z, uvRect.z};
+    const float vs[3] = {uvRect.y, uvRect.y, uvRect.w};
+    planeThrough(plane, us, data.u);
+    planeThrough(plane, vs, data.v);
+    if (!std::isfinite(data.u[0]) || !std::isfinite(data.v[0])) {
+        return;
+    }
+
+    data.region = glm::vec4(
+        region.uvRect.x,
+        region.uvRect.y,
+        region.uvRect.z - region.uvRect.x,
+        region.uvRect.w - region.uvRect.y
+    );
+    data.texture = &texture->second;
+    data.tint = packColor(tint);
+
+    this->spriteData.push_back(data);
+    const int sprite = static_cast<int>(this->spriteData.size()) - 1;
+    addTriangle(corners[0], corners[1], corners[2], 0, PrimitiveKind::Sprite, sprite);
+    addTriangle(corners[2], corners[3], corners[0], 0, PrimitiveKind::Sprite, sprite);
+}
+
+void SoftwareRasterizer::rasterizeTile(const int tile) {
+    const int tileMinX = tile % this->tilesX * SOFTWARE_TILE_SIZE;
+    const int tileMinY = tile / this->tilesX * SOFTWARE_TILE_SIZE;
+    const int tileMaxX = std::min(tileMinX + SOFTWARE_TILE_SIZE, this->imageWidth) - 1;
+    const int tileMaxY = std::min(tileMinY + SOFTWARE_TILE_SIZE, this->imageHeight) - 1;
+
+    for (int y = tileMinY; y <= tileMaxY; y++) {
+        uint32_t* row = &this->colorBuffer[static_cast<size_t>(y) * this->imageWidth];
+        std::fill(row + tileMinX, row + tileMaxX + 1, this->clearColor);
+    }
+
+    for (const uint32_t index : this->bins[tile]) {
+        const Primitive& primitive = this->primitives[index];
+        const int minX = std::max(primitive.minX, tileMinX);
+        const int minY = std::max(primitive.minY, tileMinY);
+        const int maxX = std::min(primitive.maxX, tileMaxX);
+        const int maxY = std::min(primitive.maxY, tileMaxY);
+
+        if (primitive.kind == PrimitiveKind::Rect) {
+            for (int y = minY; y <= maxY; y++) {
+                uint32_t* row = &this->colorBuffer[static_cast<size_t>(y) * this->imageWidth];
+                std::fill(row + minX, row + maxX + 1, primitive.color);
+            }
+            continue;
+        }
+
+        const SpriteData* sprite = primitive.sprite >= 0 ? &this->spriteData[primitive.sprite] : nullptr;
+        EdgeStepper edges(primitive.edges);
+
+        for (int y = minY; y <= maxY; y++) {
+            const float centerY = static_cast<float>(y) + 0.5f;
+            uint32_t* row = &this->colorBuffer[static_cast<size_t>(y) * this->imageWidth];
+            int first = minX;
+            int last = maxX;
+            if (!rowSpan(primitive.edges, centerY, first, last)) {
+                continue;
+            }
+            edges.beginRow(centerY);
+
+            for (int x = first; x <= last; x += 4) {
+                const int lanes = std::min(4, last - x + 1);
+                const int mask = edges.mask(static_cast<float>(x)) & ((1 << lanes) - 1);
+                if (mask == 0) {
+                    continue;
+                }
+
+                if (sprite == nullptr && mask == 0xf) {
+                    std::fill_n(row + x, 4, primitive.color);
+                    continue;
+                }
+
+                if (sprite == nullptr) {
+                    for (int k = 0; k < lanes; k++) {
+                        if (mask & 1 << k) {
+                            row[x + k] = primitive.color;
+                        }
+                    }
+                    continue;
+                }
+
+                const SoftwareTexture& texture = *sprite->texture;
+                int columns[4];
+                int rows[4];
+                texelCoordinates(sprite->u, sprite->v, sprite->region, texture.width, texture.height,
+                                 static_cast<float>(x), centerY, columns, rows);
+
+                // Pixels fora do triângulo entram com alpha 0 e saem iguais do blend.
+                uint32_t source[4] = {};
+                uint32_t destination[4] = {};
+                std::memcpy(destination, row + x, lanes * sizeof(uint32_t));
+                for (int k = 0; k < lanes; k++) {
+                    if (mask & 1 << k) {
+                        source[k] = texture.texels[static_cast<size_t>(rows[k]) * texture.width + columns[k]];
+                        if (sprite->tint != 0xffffffffu) {
+                            source[k] = modulate(source[k], sprite->tint);
+                        }
+                    }
+                }
+
+                // Camadas de parallax são quase todas opacas ou transparentes: o blend não mudaria nada.
+                const uint32_t opaque = source[0] & source[1] & source[2] & source[3];
+                const uint32_t visible = source[0] | source[1] | source[2] | source[3];
+                if ((visible >> 24) == 0) {
+                    continue;
+                }
+                if (mask == 0xf && (opaque >> 24) == 0xff) {
+                    std::memcpy(row + x, source, sizeof(source));
+                    continue;
+                }
+
+                blendPixels(source, destination);
+                std::memcpy(row + x, destination, lanes * sizeof(uint32_t));
+            }
+        }
+    }
+}
+
+void SoftwareRasterizer::present(const GLuint framebuffer, const std::vector<DamageRect>& damage) {
+    {
+        PROFILE_ZONE("software rasterize");
+
+        // Cada worker pega o próximo tile livre: tiles cheios e vazios se equilibram sozinhos.
+        const int tiles = this->tilesX * this->tilesY;
+        std::atomic<int> nextTile{0};
+        for (unsigned int i = 0; i < this->workers.size(); i++) {
+            this->workers.submit([this, tiles, &nextTile] {
+                for (int tile = nextTile++; tile < tiles; tile = nextTile++) {
+                    rasterizeTile(tile);
+                }
+            });
+        }
+        this->workers.wait();
+    }
+
+    PROFILE_ZONE("software present");
+
+    GLint viewport[4];
+    glGetIntegerv(GL_VIEWPORT, viewport);
+
+    // Sem esticar, uma linha da imagem é uma linha do framebuffer e basta enviar as que os
+    // retângulos cobrem.
+    int firstRow = 0;
+    int lastRow = this->imageHeight;
+    if (!damage.empty() && viewport[2] == this->imageWidth && viewport[3] == this->imageHeight) {
+        firstRow = this->imageHeight;
+        lastRow = 0;
+        for (const DamageRect& rect : damage) {
+            firstRow = std::min(firstRow, std::max(rect.y - viewport[1], 0));
+            lastRow = std::max(lastRow, std::min(rect.y + rect.height - viewport[1], this->imageHeight));
+        }
+    }
+
+    if (firstRow < lastRow) {
+        bindTexture(GL_TEXTURE_2D, this->texture);
+        glTexSubImage2D(GL_TEXTURE_2D, 0, 0, firstRow, this->imageWidth, lastRow - firstRow, GL_RGBA,
+                        GL_UNSIGNED_BYTE, &this->colorBuffer[static_cast<size_t>(firstRow) * this->imageWidth]);
+    }
+
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, this->readFramebuffer);
+    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, framebuffer);
+
+    const auto blit = [this, &viewport] {
+        glBlitFramebuffer(0, 0, this->imageWidth, this->imageHeight, viewport[0], viewport[1],
+                          viewport[0] + viewport[2], viewport[1] + viewport[3], GL_COLOR_BUFFER_BIT, GL_NEAREST);
+    };
+
+    if (damage.empty()) {
+        blit();
+    } else {
+        // O blit respeita o scissor, então cada retângulo copia só os seus pixels.
+        glEnable(GL_SCISSOR_TEST);
+        for (const DamageRect& rect : damage) {
+            glScissor(rect.x, rect.y, rect.width, rect.height);
+            blit();
+        }
+        glDisable(GL_SCISSOR_TEST);
+    }
+
+    glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+}
@@ -0,0 +1,136 @@
+#pragma once
+
+#include <glad.h>
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+#include "glm/mat4x4.hpp"
+#include "glm/vec2.hpp"
+#include "glm/vec4.hpp"
+#include "renderer/render_context.hpp"
+#include "renderer/texture.hpp"
+#include "renderer/texture_atlas.hpp"
+#include "renderer/thread_pool.hpp"
+
+// Lado dos tiles em pixels. Cada tile é rasterizado inteiro por uma thread, então 64x64 RGBA8
+// (16 KiB) cabe com folga no L1 de qualquer núcleo.
+constexpr int SOFTWARE_TILE_SIZE = 64;
+
+// Backend de CPU para o que os exercícios desenham: triângulos e retângulos de cor sólida (opacos)
+// e quads de sprite texturizados, com tint e blend GL_SRC_ALPHA/GL_ONE_MINUS_SRC_ALPHA, amostrados
+// como os shaders de sprite (region.xy + fract(uv) * region.zw, GL_NEAREST).
+//
+// Os draws só guardam a primitiva e a colocam na lista de cada tile que o retângulo envolvente
+// toca. present() rasteriza os tiles em paralelo, cada um do clear até a última primitiva na ordem
+// dos draws, com as funções de aresta e o blend de 4 pixels por vez em SSE2, e copia o resultado
+// para o framebuffer do contexto. Nada depende de a GPU ser rápida: ela só recebe uma textura.
+//
+// Uso por frame: clear(), draws, present(context.framebuffer()), e então o swapBuffers() de sempre.
+// No modo sob demanda o frame é montado dentro do RenderContext::drawDamagedFrame, que passa os
+// retângulos danificados para o present().
+class SoftwareRasterizer {
+public:
+    // 0 usa uma thread por núcleo.
+    explicit SoftwareRasterizer(unsigned int threads = 0);
+
+    // Tamanho da imagem; present() estica para o viewport atual se ele for diferente.
+    void create(int width, int height);
+
+    void destroy();
+
+    // Mesma projeção dos shaders: leva as coordenadas da cena para [-1, 1].
+    void setProjection(const glm::mat4& projection);
+
+    // Cópia na CPU da imagem de uma textura, para os sprites que desenham com ela. Linha 0 no topo,
+    // como foi enviada ao glTexImage2D.
+    void addTexture(GLuint textureId, const Image& image);
+
+    void clear(const glm::vec4& color);
+
+    void drawTriangle(const glm::vec2& a, const glm::vec2& b, const glm::vec2& c, const glm::vec4& color);
+
+    // Retângulo alinhado aos eixos entre dois cantos opostos, na cena.
+    void drawRect(const glm::vec2& corner, const glm::vec2& oppositeCorner, const glm::vec4& color);
+
+    // Mesmos parâmetros do SpriteBatch::draw. Uma textura sem addTexture() não desenha nada.
+    void drawSprite(const AtlasRegion& region, const glm::vec2& position, float rotation, const glm::vec2& size,
+                    const glm::vec4& uvRect, const glm::vec4& tint = glm::vec4(1.0f));
+
+    // Rasteriza o frame e o copia para framebuffer, que continua ligado depois. Com damage só esses
+    // retângulos são copiados, e só as linhas que eles cobrem vão para a textura; vazio copia tudo.
+    void present(GLuint framebuffer, const std::vector<DamageRect>& damage = {});
+
+    int width() const { return this->imageWidth; }
+
+    int height() const { return this->imageHeight; }
+
+    // RGBA8 com a linha 0 embaixo, como o glReadPixels devolveria. Válido depois do present().
+    const std::vector<uint32_t>& pixels() const { return this->colorBuffer; }
+
+private:
+    struct SoftwareTexture {
+        int width = 0;
+        int height = 0;
+        std::vector<uint32_t> texels;
+    };
+
+    enum class PrimitiveKind : uint8_t {
+        Triangle,
+        Rect,
+        Sprite,
+    };
+
+    // Arestas como E(x, y) = a * x + b * y + c, positivas dentro. A caixa é em pixels, inclusiva.
+    struct Primitive {
+        float edges[9];
+        int minX;
+        int minY;
+        int maxX;
+        int maxY;
+        uint32_t color;
+        PrimitiveKind kind;
+        // Índice em spriteData para os sprites.
+        int sprite;
+    };
+
+    // Planos de u e v em pixels (u = a * x + b * y + c), mais o que o shader de sprite recebe.
+    struct SpriteData {
+        float u[3];
+        float v[3];
+        glm::vec4 region;
+        const SoftwareTexture* texture;
+        uint32_t tint;
+    };
+
+    glm::vec2 toPixels(const glm::vec2& point) const;
+
+    // Guarda um triângulo em pixels, em qualquer orientação. Devolve false se ele não cobre nenhum pixel.
+    bool addTriangle(glm::vec2 a, glm::vec2 b, glm::vec2 c, uint32_t color, PrimitiveKind kind, int sprite);
+
+    void bin(uint32_t primitive);
+
+    void rasterizeTile(int tile);
+
+    ThreadPool workers;
+
+    int imageWidth = 0;
+    int imageHeight = 0;
+    int tilesX = 0;
+    int tilesY = 0;
+
+    glm::mat4 projection = glm::mat4(1.0f);
+    uint32_t clearColor = 0;
+
+    std::vector<uint32_t> colorBuffer;
+    std::vector<Primitive> primitives;
+    std::vector<SpriteData> spriteData;
+    // Índices das primitivas que tocam cada tile, na ordem dos draws.
+    std::vector<std::vector<uint32_t>> bins;
+
+    std::unordered_map<GLuint, SoftwareTexture> textures;
+
+    GLuint texture = 0;
+    GLuint readFramebuffer = 0;
+};
@@ -0,0 +1,208 @@
+#include "renderer/sprite_batch.hpp"
+
+#include <cmath>
+#include <cstddef>
+
+#include "renderer/gl_state.hpp"
+#include "renderer/profiler.hpp"
+#include "renderer/software_rasterizer.hpp"
+
+namespace {
+    // Um polígono convexo de n vértices vira um leque de n - 2 triângulos.
+    constexpr int MAX_INDICES = SpriteBatch::MAX_VERTICES * 3;
+
+    static_assert(SpriteBatch::MAX_VERTICES <= 65536, "os índices do batch são de 16 bits");
+
+    uint32_t packColor(const glm::vec4& color) {
+        const auto channel = [](const float value) {
+            const float clamped = value < 0.0f ? 0.0f : value > 1.0f ? 1.0f : value;
+            return static_cast<uint32_t>(clamped * 255.0f + 0.5f);
+        };
+
+        return channel(color.r) | channel(color.g) << 8 | channel(color.b) << 16 | channel(color.a) << 24;
+    }
+}
+
+void SpriteBatch::create() {
+    this->vertices.reserve(MAX_VERTICES);
+    this->indices.reserve(MAX_INDICES);
+
+    glGenVertexArrays(1, &this->VAO);
+    glGenBuffers(1, &this->VBO);
+    glGenBuffers(1, &this->EBO);
+
+    bindVertexArray(this->VAO);
+
+    glBindBuffer(GL_ARRAY_BUFFER, this->VBO);
+    glBufferData(GL_ARRAY_BUFFER, MAX_VERTICES * sizeof(SpriteVertex), nullptr, GL_STREAM_DRAW);
+
+    // Os índices são reenviados a cada draw: sprites com mesh têm polígonos de tamanhos diferentes.
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, this->EBO);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, MAX_INDICES * sizeof(GLushort), nullptr, GL_STREAM_DRAW);
+
+    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, sizeof(SpriteVertex), (void *) offsetof(SpriteVertex, position));
+    glEnableVertexAttribArray(0);
+
+    glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, sizeof(SpriteVertex), (void *) offsetof(SpriteVertex, uv));
+    glEnableVertexAttribArray(1);
+
+    glVertexAttribPointer(2, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(SpriteVertex), (void *) offsetof(SpriteVertex, color));
+    glEnableVertexAttribArray(2);
+
+    glVertexAttribPointer(3, 4, GL_FLOAT, GL_FALSE, sizeof(SpriteVertex), (void *) offsetof(SpriteVertex, region));
+    glEnableVertexAttribArray(3);
+
+    bindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+void SpriteBatch::destroy() {
+    glDeleteBuffers(1, &this->VBO);
+    glDeleteBuffers(1, &this->EBO);
+    deleteVertexArray(this->VAO);
+
+    this->VAO = 0;
+    this->VBO = 0;
+    this->EBO = 0;
+}
+
+void SpriteBatch::begin(const GLuint program) {
+    setProgram(program);
+
+    this->frameDrawCalls = 0;
+}
+
+void SpriteBatch::setProgram(const GLuint program) {
+    if (program == this->program) {
+        return;
+    }
+
+    flush();
+    this->program = program;
+}
+
+void SpriteBatch::draw(const GLuint textureId, const glm::vec2& position, const float rotation, const glm::vec2& size,
+                       const glm::vec4& uvRect, const glm::vec4& tint) {
+    AtlasRegion region;
+    region.textureId = textureId;
+
+    draw(region, position, rotation, size, uvRect, tint);
+}
+
+void SpriteBatch::draw(const AtlasRegion& region, const glm::vec2& position, const float rotation,
+                       const glm::vec2& size, const glm::vec4& uvRect, const glm::vec4& tint) {
+    if (this->software != nullptr) {
+        this->software->drawSprite(region, position, rotation, size, uvRect, tint);
+        return;
+    }
+
+    reserve(region.textureId, 4);
+
+    // Mesma composição de translate * rotate * scale das matrizes de modelo, feita só em 2D.
+    const float cosine = std::cos(rotation);
+    const float sine = std::sin(rotation);
+    const glm::vec2 axisX = glm::vec2(cosine, sine) * (size.x * 0.5f);
+    const glm::vec2 axisY = glm::vec2(-sine, cosine) * (size.y * 0.5f);
+    const uint32_t color = packColor(tint);
+    const glm::vec4 bounds = glm::vec4(
+        region.uvRect.x,
+        region.uvRect.y,
+        region.uvRect.z - region.uvRect.x,
+        region.uvRect.w - region.uvRect.y
+    );
+
+    const auto first = static_cast<GLushort>(this->vertices.size());
+    this->indices.insert(this->indices.end(), {first, static_cast<GLushort>(first + 1),
+                                               static_cast<GLushort>(first + 2), static_cast<GLushort>(first + 2),
+                                               static_cast<GLushort>(first + 3), first});
+
+    this->vertices.push_back({position - axisX - axisY, glm::vec2(uvRect.x, uvRect.y), color, bounds});
+    this->vertices.push_back({position + axisX - axisY, glm::vec2(uvRect.z, uvRect.y), color, bounds});
+    this->vertices.push_back({position + axisX + axisY, glm::vec2(uvRect.z, uvRect.w), color, bounds});
+    this->vertices.push_back({position - axisX + axisY, glm::vec2(uvRect.x, uvRect.w), color, bounds});
+}
+
+void SpriteBatch::draw(const AtlasRegion& region, const SpriteMesh& mesh, const glm::vec2& position,
+                       const float rotation, const glm::vec2& size, const glm::vec4& uvRect, const glm::vec4& tint) {
+    if (this->software != nullptr) {
+        this->software->drawSprite(region, position, rotation, size, uvRect, tint);
+        return;
+    }
+
+    const size_t count = mesh.vertices.size();
+    if (count < 3) {
+        return;
+    }
+
+    reserve(region.textureId, count);
+
+    const float cosine = std::cos(rotation);
+    const float sine = std::sin(rotation);
+    const glm::vec2 axisX = glm::vec2(cosine, sine) * size.x;
+    const glm::vec2 axisY = glm::vec2(-sine, cosine) * size.y;
+    const uint32_t color = packColor(tint);
+    const glm::vec4 bounds = glm::vec4(
+        region.uvRect.x,
+        region.uvRect.y,
+        region.uvRect.z - region.uvRect.x,
+        region.uvRect.w - region.uvRect.y
+    );
+
+    // O mesh tem u e v crescentes dentro do quadro; com o uvRect espelhado o canto (u0, v0) do quad
+    // fica do outro lado, então cada vértice é posicionado pela fração do uvRect que ele ocupa.
+    const glm::vec2 frameStart = glm::vec2(std::min(uvRect.x, uvRect.z), std::min(uvRect.y, uvRect.w));
+    const glm::vec2 frameSize = glm::vec2(std::abs(uvRect.z - uvRect.x), std::abs(uvRect.w - uvRect.y));
+    const glm::vec2 uvStart = glm::vec2(uvRect.x, uvRect.y);
+    const glm::vec2 uvSpan = glm::vec2(uvRect.z - uvRect.x, uvRect.w - uvRect.y);
+
+    const auto first = static_cast<GLushort>(this->vertices.size());
+    for (const glm::vec2& vertex : mesh.vertices) {
+        const glm::vec2 uv = frameStart + vertex * frameSize;
+        const float localX = (uv.x - uvStart.x) / uvSpan.x - 0.5f;
+        const float localY = (uv.y - uvStart.y) / uvSpan.y - 0.5f;
+        this->vertices.push_back({position + axisX * localX + axisY * localY, uv, color, bounds});
+    }
+
+    for (size_t i = 1; i + 1 < count; i++) {
+        this->indices.insert(this->indices.end(), {first, static_cast<GLushort>(first + i),
+                                                   static_cast<GLushort>(first + i + 1)});
+    }
+}
+
+void SpriteBatch::end() {
+    flush();
+}
+
+void SpriteBatch::reserve(const GLuint textureId, const size_t vertexCount) {
+    if (textureId != this->textureId || this->vertices.size() + vertexCount > static_cast<size_t>(MAX_VERTICES)) {
+        flush();
+        this->textureId = textureId;
+    }
+}
+
+void SpriteBatch::flush() {
+    if (this->vertices.empty()) {
+        return;
+    }
+
+    PROFILE_ZONE("sprite batch flush");
+
+    useProgram(this->program);
+    bindTexture(GL_TEXTURE_2D, this->textureId);
+    bindVertexArray(this->VAO);
+
+    // Orfana o buffer antes de escrever para o driver não precisar esperar o draw anterior.
+    glBindBuffer(GL_ARRAY_BUFFER, this->VBO);
+    glBufferData(GL_ARRAY_BUFFER, MAX_VERTICES * sizeof(SpriteVertex), nullptr, GL_STREAM_DRAW);
+    glBufferSubData(GL_ARRAY_BUFFER, 0, this->vertices.size() * sizeof(SpriteVertex), this->vertices.data());
+
+    // O EBO faz parte do VAO, que já está ligado.
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, MAX_INDICES * sizeof(GLushort), nullptr, GL_STREAM_DRAW);
+    glBufferSubData(GL_ELEMENT_ARRAY_BUFFER, 0, this->indices.size() * sizeof(GLushort), this->indices.data());
+
+    drawElements(GL_TRIANGLES, static_cast<GLsizei>(this->indices.size()), GL_UNSIGNED_SHORT, nullptr);
+
+    this->frameDrawCalls++;
+    this->vertices.clear();
+    this->indices.clear();
+}
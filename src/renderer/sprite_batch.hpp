@@ -0,0 +1,90 @@
+#pragma once
+
+#include <glad.h>
+
+#include <cstdint>
+#include <vector>
+
+#include "glm/vec2.hpp"
+#include "glm/vec4.hpp"
+#include "renderer/sprite_mesh.hpp"
+#include "renderer/texture_atlas.hpp"
+
+class SoftwareRasterizer;
+
+// Layout de vértice usado pelo SpriteBatch. Os shaders que desenham com ele devem declarar:
+//   layout (location = 0) in vec2 position;
+//   layout (location = 1) in vec2 texc;
+//   layout (location = 2) in vec4 color;
+//   layout (location = 3) in vec4 region;
+// e amostrar em region.xy + fract(texc) * region.zw, o que repete a imagem dentro da região do
+// atlas do mesmo jeito que GL_REPEAT faria com uma textura própria.
+struct SpriteVertex {
+    glm::vec2 position;
+    glm::vec2 uv;
+    uint32_t color;
+    glm::vec4 region;
+};
+
+// Junta quads e polígonos já transformados em um único vertex buffer de streaming e só emite um
+// draw quando a textura ou o programa mudam (ou quando o buffer enche).
+//
+// Cada sprite é um quad unitário centrado na origem ([-0.5, 0.5]) que é escalado, rotacionado e
+// transladado na CPU. uvRect é (u0, v0, u1, v1): (u0, v0) vai no canto (-0.5, -0.5) e (u1, v1) no
+// canto (0.5, 0.5), então um retângulo invertido espelha a imagem. O uvRect é relativo à imagem:
+// com uma AtlasRegion ele é mapeado para dentro da região ocupada no atlas.
+class SpriteBatch {
+public:
+    static constexpr int MAX_SPRITES = 8192;
+    static constexpr int MAX_VERTICES = MAX_SPRITES * 4;
+
+    void create();
+
+    void destroy();
+
+    void begin(GLuint program);
+
+    // Troca o programa no meio de um begin/end, descarregando o que estava acumulado.
+    void setProgram(GLuint program);
+
+    void draw(GLuint textureId, const glm::vec2& position, float rotation, const glm::vec2& size,
+              const glm::vec4& uvRect, const glm::vec4& tint = glm::vec4(1.0f));
+
+    void draw(const AtlasRegion& region, const glm::vec2& position, float rotation, const glm::vec2& size,
+              const glm::vec4& uvRect, const glm::vec4& tint = glm::vec4(1.0f));
+
+    // Desenha só o polígono do mesh dentro do quad, cortando o blend dos texels transparentes. O mesh
+    // é o do quadro mostrado por uvRect, que precisa ser exatamente esse quadro (pode estar espelhado
+    // ou deslocado por um inteiro, não rolando dentro dele). Na CPU vira o quad inteiro: o
+    // SoftwareRasterizer já pula os texels transparentes.
+    void draw(const AtlasRegion& region, const SpriteMesh& mesh, const glm::vec2& position, float rotation,
+              const glm::vec2& size, const glm::vec4& uvRect, const glm::vec4& tint = glm::vec4(1.0f));
+
+    void end();
+
+    int drawCalls() const { return this->frameDrawCalls; }
+
+    // Com um rasterizador os sprites vão para ele em vez do vertex buffer, e o programa é ignorado:
+    // ele amostra como os shaders de sprite. nullptr volta para a GPU.
+    void setSoftware(SoftwareRasterizer* rasterizer) { this->software = rasterizer; }
+
+private:
+    void flush();
+
+    // Descarrega se a textura mudou ou se não cabem mais vertexCount vértices.
+    void reserve(GLuint textureId, size_t vertexCount);
+
+    GLuint VAO = 0;
+    GLuint VBO = 0;
+    GLuint EBO = 0;
+
+    GLuint program = 0;
+    GLuint textureId = 0;
+
+    int frameDrawCalls = 0;
+
+    SoftwareRasterizer* software = nullptr;
+
+    std::vector<SpriteVertex> vertices;
+    std::vector<GLushort> indices;
+};
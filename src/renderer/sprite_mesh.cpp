@@ -0,0 +1,277 @@
+#include "renderer/sprite_mesh.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+
+#include "renderer/profiler.hpp"
+
+namespace {
+    constexpr int MESH_CACHE_VERSION = 1;
+
+    // Área do quadro que um vértice precisa poupar para valer o triângulo a mais.
+    constexpr double MIN_AREA_PER_VERTEX = 0.02;
+
+    struct Point {
+        double x, y;
+    };
+
+    Point operator-(const Point& a, const Point& b) {
+        return Point{a.x - b.x, a.y - b.y};
+    }
+
+    double cross(const Point& a, const Point& b) {
+        return a.x * b.y - a.y * b.x;
+    }
+
+    double cross(const Point& origin, const Point& a, const Point& b) {
+        return cross(a - origin, b - origin);
+    }
+
+    // Cantos dos texels das pontas de cada linha: o fecho deles cobre todos os texels visíveis.
+    std::vector<Point> opaqueCorners(const Image& image, const int left, const int top, const int width,
+                                     const int height) {
+        std::vector<Point> corners;
+
+        for (int y = 0; y < height; y++) {
+            const unsigned char* row = &image.pixels[(static_cast<size_t>(top + y) * image.width + left) * 4];
+
+            int first = 0;
+            while (first < width && row[first * 4 + 3] == 0) {
+                first++;
+            }
+            if (first == width) {
+                continue;
+            }
+
+            int last = width - 1;
+            while (row[last * 4 + 3] == 0) {
+                last--;
+            }
+
+            corners.push_back(Point{static_cast<double>(first), static_cast<double>(y)});
+            corners.push_back(Point{static_cast<double>(first), static_cast<double>(y + 1)});
+            corners.push_back(Point{static_cast<double>(last + 1), static_cast<double>(y)});
+            corners.push_back(Point{static_cast<double>(last + 1), static_cast<double>(y + 1)});
+        }
+
+        return corners;
+    }
+
+    // Monotone chain. Pontos colineares ficam de fora: só aumentariam o número de vértices.
+    std::vector<Point> convexHull(std::vector<Point> points) {
+        std::sort(points.begin(), points.end(), [](const Point& a, const Point& b) {
+            return a.x < b.x || (a.x == b.x && a.y < b.y);
+        });
+
+        std::vector<Point> hull(points.size() * 2);
+        size_t size = 0;
+
+        for (const Point& point : points) {
+            while (size >= 2 && cross(hull[size - 2], hull[size - 1], point) <= 0.0) {
+                size--;
+            }
+            hull[size++] = point;
+        }
+
+        const size_t lowerSize = size + 1;
+        for (auto point = points.rbegin() + 1; point != points.rend(); ++point) {
+            while (size >= lowerSize && cross(hull[size - 2], hull[size - 1], *point) <= 0.0) {
+                size--;
+            }
+            hull[size++] = *point;
+        }
+
+        hull.resize(size - 1);
+        return hull;
+    }
+
+    // Tira a aresta cuja remoção acrescenta menos área: as duas vizinhas são estendidas até se
+    // encontrarem. O novo vértice precisa ficar dentro do quadro, senão o polígono amostraria o
+    // quadro ao lado. Devolve false se nenhuma aresta pode sair acrescentando até maxArea.
+    bool removeCheapestEdge(std::vector<Point>& polygon, const double width, const double height,
+                            const double maxArea) {
+        const size_t count = polygon.size();
+        size_t best = count;
+        double bestArea = std::numeric_limits<double>::max();
+        Point bestPoint{};
+
+        for (size_t i = 0; i < count; i++) {
+            const Point& previous = polygon[(i + count - 1) % count];
+            const Point& a = polygon[i];
+            const Point& b = polygon[(i + 1) % count];
+            const Point& next = polygon[(i + 2) % count];
+
+            const Point forward = a - previous;
+            const Point backward = b - next;
+            const double denominator = cross(forward, backward);
+            if (std::abs(denominator) < 1e-9) {
+                continue;
+            }
+
+            const double s = cross(b - a, backward) / denominator;
+            const double r = cross(b - a, forward) / denominator;
+            if (s <= 0.0 || r <= 0.0) {
+                continue;
+            }
+
+            const Point point{a.x + forward.x * s, a.y + forward.y * s};
+            if (point.x < -1e-6 || point.y < -1e-6 || point.x > width + 1e-6 || point.y > height + 1e-6) {
+                continue;
+            }
+
+            const double area = std::abs(cross(point, a, b)) * 0.5;
+            if (area < bestArea) {
+                best = i;
+                bestArea = area;
+                bestPoint = Point{std::clamp(point.x, 0.0, width), std::clamp(point.y, 0.0, height)};
+            }
+        }
+
+        if (best == count || bestArea > maxArea) {
+            return false;
+        }
+
+        polygon[best] = bestPoint;
+        polygon.erase(polygon.begin() + static_cast<std::ptrdiff_t>((best + 1) % count));
+        return true;
+    }
+
+    SpriteMesh buildFrameMesh(const Image& image, const int left, const int top, const int width, const int height,
+                              const int maxVertices) {
+        SpriteMesh mesh;
+
+        const std::vector<Point> corners = opaqueCorners(image, left, top, width, height);
+        if (corners.empty()) {
+            return mesh;
+        }
+
+        std::vector<Point> polygon = convexHull(corners);
+        while (static_cast<int>(polygon.size()) > maxVertices &&
+               removeCheapestEdge(polygon, width, height, std::numeric_limits<double>::max())) {
+        }
+        while (polygon.size() > 3 && removeCheapestEdge(polygon, width, height, MIN_AREA_PER_VERTEX * width * height)) {
+        }
+
+        // Sem como reduzir mais, o retângulo envolvente ainda cobre tudo com 4 vértices.
+        if (static_cast<int>(polygon.size()) > maxVertices) {
+            double minX = width, minY = height, maxX = 0.0, maxY = 0.0;
+            for (const Point& point : polygon) {
+                minX = std::min(minX, point.x);
+                minY = std::min(minY, point.y);
+                maxX = std::max(maxX, point.x);
+                maxY = std::max(maxY, point.y);
+            }
+            polygon = {Point{minX, minY}, Point{maxX, minY}, Point{maxX, maxY}, Point{minX, maxY}};
+        }
+
+        for (const Point& point : polygon) {
+            mesh.vertices.emplace_back(static_cast<float>(point.x / width), static_cast<float>(point.y / height));
+        }
+        return mesh;
+    }
+
+    std::string cacheHeader(const std::string& filePath, const Image& image, const int columns, const int rows,
+                            const int maxVertices) {
+        std::error_code error;
+        const auto modified = std::filesystem::last_write_time(filePath, error);
+        const long long modifiedTime = error ? 0 : static_cast<long long>(modified.time_since_epoch().count());
+
+        return "sprite-mesh " + std::to_string(MESH_CACHE_VERSION) + " " + std::to_string(image.width) + " " +
+               std::to_string(image.height) + " " + std::to_string(columns) + " " + std::to_string(rows) + " " +
+               std::to_string(maxVertices) + " " + std::to_string(modifiedTime);
+    }
+
+    bool readMeshCache(const std::string& cachePath, const std::string& header, const size_t frames,
+                       std::vector<SpriteMesh>& meshes) {
+        std::ifstream file(cachePath);
+        std::string line;
+        if (!file || !std::getline(file, line) || line != header) {
+            return false;
+        }
+
+        meshes.assign(frames, SpriteMesh());
+        for (SpriteMesh& mesh : meshes) {
+            int count = 0;
+            if (!(file >> count) || count < 0) {
+                return false;
+            }
+
+            mesh.vertices.resize(count);
+            for (glm::vec2& vertex : mesh.vertices) {
+                if (!(file >> vertex.x >> vertex.y)) {
+                    return false;
+                }
+            }
+        }
+        return true;
+    }
+
+    void writeMeshCache(const std::string& cachePath, const std::string& header,
+                        const std::vector<SpriteMesh>& meshes) {
+        std::ofstream file(cachePath);
+        file << header << "\n" << std::setprecision(9);
+
+        for (const SpriteMesh& mesh : meshes) {
+            file << mesh.vertices.size();
+            for (const glm::vec2& vertex : mesh.vertices) {
+                file << " " << vertex.x << " " << vertex.y;
+            }
+            file << "\n";
+        }
+
+        if (!file) {
+            std::cout << "Failed to write sprite mesh cache " << cachePath << std::endl;
+        }
+    }
+}
+
+std::vector<SpriteMesh> buildSpriteMeshes(const Image& image, const int columns, const int rows,
+                                          const int maxVertices) {
+    PROFILE_ZONE("build sprite meshes");
+
+    std::vector<SpriteMesh> meshes;
+    const int frameWidth = image.width / columns;
+    const int frameHeight = image.height / rows;
+
+    for (int row = 0; row < rows; row++) {
+        for (int column = 0; column < columns; column++) {
+            meshes.push_back(buildFrameMesh(image, column * frameWidth, row * frameHeight, frameWidth, frameHeight,
+                                            std::max(maxVertices, 3)));
+        }
+    }
+
+    return meshes;
+}
+
+std::vector<SpriteMesh> loadSpriteMeshes(const std::string& filePath, const Image& image, const int columns,
+                                         const int rows, const int maxVertices) {
+    const std::string cachePath = filePath + ".mesh";
+    const std::string header = cacheHeader(filePath, image, columns, rows, maxVertices);
+
+    std::vector<SpriteMesh> meshes;
+    if (readMeshCache(cachePath, header, static_cast<size_t>(columns) * rows, meshes)) {
+        return meshes;
+    }
+
+    meshes = buildSpriteMeshes(image, columns, rows, maxVertices);
+    // Uma imagem que falhou ao carregar não deve deixar um cache que sobreviva a ela.
+    if (!image.pixels.empty()) {
+        writeMeshCache(cachePath, header, meshes);
+    }
+    return meshes;
+}
+
+float spriteMeshArea(const SpriteMesh& mesh) {
+    float area = 0.0f;
+    for (size_t i = 0; i < mesh.vertices.size(); i++) {
+        const glm::vec2& a = mesh.vertices[i];
+        const glm::vec2& b = mesh.vertices[(i + 1) % mesh.vertices.size()];
+        area += a.x * b.y - a.y * b.x;
+    }
+    return std::abs(area) * 0.5f;
+}
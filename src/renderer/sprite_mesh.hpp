@@ -0,0 +1,33 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "glm/vec2.hpp"
+#include "renderer/texture.hpp"
+
+// Limite de vértices do polígono de cada quadro. Mais vértices recortam mais transparência, mas cada
+// um é mais um vértice no batch e mais um triângulo; com 8 quase todo sprite já fica justo.
+constexpr int SPRITE_MESH_MAX_VERTICES = 8;
+
+// Polígono convexo que cobre todos os texels não transparentes de um quadro, em coordenadas do
+// quadro ([0, 1] nos dois eixos, v crescendo para baixo como nas linhas da imagem). Vazio quando o
+// quadro é todo transparente.
+struct SpriteMesh {
+    std::vector<glm::vec2> vertices;
+};
+
+// Um polígono por quadro de uma spritesheet com columns x rows quadros do mesmo tamanho, linha por
+// linha. O fecho convexo dos texels com alpha > 0 é reduzido até maxVertices estendendo as arestas
+// vizinhas, então o polígono só cresce e nunca corta um texel visível. Abaixo disso um vértice só
+// fica se poupar pelo menos 2% da área do quadro.
+std::vector<SpriteMesh> buildSpriteMeshes(const Image& image, int columns = 1, int rows = 1,
+                                          int maxVertices = SPRITE_MESH_MAX_VERTICES);
+
+// Como buildSpriteMeshes, mas guarda o resultado em <filePath>.mesh, ao lado da textura, e o reaproveita
+// enquanto a imagem e a divisão em quadros forem as mesmas.
+std::vector<SpriteMesh> loadSpriteMeshes(const std::string& filePath, const Image& image, int columns = 1,
+                                         int rows = 1, int maxVertices = SPRITE_MESH_MAX_VERTICES);
+
+// Área do polígono, na mesma unidade do quadro (1 é o quadro inteiro).
+float spriteMeshArea(const SpriteMesh& mesh);
@@ -0,0 +1,110 @@
+#include "renderer/texture.hpp"
+
+#include <iostream>
+
+#include "renderer/gl_state.hpp"
+
+#define STB_IMAGE_IMPLEMENTATION
+#include <stb_image.h>
+
+#define STB_IMAGE_WRITE_IMPLEMENTATION
+#include <stb_image_write.h>
+
+bool loadImage(const std::string& filePath, Image& image) {
+    int width, height, nrChannels;
+
+    unsigned char* data = stbi_load(filePath.c_str(), &width, &height, &nrChannels, 4);
+
+    if (!data) {
+        std::cout << "Failed to load image " << filePath << std::endl;
+        return false;
+    }
+
+    image.width = width;
+    image.height = height;
+    image.pixels.assign(data, data + static_cast<size_t>(width) * height * 4);
+
+    stbi_image_free(data);
+
+    return true;
+}
+
+bool writeImage(const std::string& filePath, const Image& image) {
+    if (!stbi_write_png(filePath.c_str(), image.width, image.height, 4, image.pixels.data(), image.width * 4)) {
+        std::cout << "Failed to write image " << filePath << std::endl;
+        return false;
+    }
+
+    return true;
+}
+
+GLuint loadTexture(const std::string& filePath) {
+    GLuint texID;
+
+    glGenTextures(1, &texID);
+    bindTexture(GL_TEXTURE_2D, texID);
+
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+
+    int width, height, nrChannels;
+
+    unsigned char* data = stbi_load(filePath.c_str(), &width, &height, &nrChannels, 0);
+
+    if (data) {
+        if (nrChannels == 3) {
+            glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, width, height, 0, GL_RGB, GL_UNSIGNED_BYTE, data);
+        } else // png
+        {
+            glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, data);
+        }
+        glGenerateMipmap(GL_TEXTURE_2D);
+    } else {
+        std::cout << "Failed to load texture" << std::endl;
+    }
+
+    stbi_image_free(data);
+
+    return texID;
+}
+
+GLuint loadTextureArray(const std::vector<std::string>& filePaths) {
+    std::vector<Image> layers(filePaths.size());
+    for (size_t i = 0; i < filePaths.size(); i++) {
+        loadImage(filePaths[i], layers[i]);
+    }
+
+    const int width = layers.empty() ? 0 : layers[0].width;
+    const int height = layers.empty() ? 0 : layers[0].height;
+
+    GLuint texID;
+
+    glGenTextures(1, &texID);
+    bindTexture(GL_TEXTURE_2D_ARRAY, texID);
+
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_REPEAT);
+
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+
+    glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_RGBA8, width, height, static_cast<GLsizei>(layers.size()), 0,
+                 GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+
+    for (size_t i = 0; i < layers.size(); i++) {
+        const Image& layer = layers[i];
+
+        if (layer.width != width || layer.height != height) {
+            std::cout << "Failed to load texture array layer " << filePaths[i] << ": size mismatch" << std::endl;
+            continue;
+        }
+
+        glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, 0, 0, static_cast<GLint>(i), width, height, 1,
+                        GL_RGBA, GL_UNSIGNED_BYTE, layer.pixels.data());
+    }
+
+    return texID;
+}
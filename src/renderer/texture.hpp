@@ -0,0 +1,23 @@
+#pragma once
+
+#include <glad.h>
+
+#include <string>
+#include <vector>
+
+// Imagem decodificada na CPU, sempre em RGBA8 com a primeira linha no topo.
+struct Image {
+    int width = 0;
+    int height = 0;
+    std::vector<unsigned char> pixels;
+};
+
+bool loadImage(const std::string& filePath, Image& image);
+
+// Grava a imagem como PNG RGBA8.
+bool writeImage(const std::string& filePath, const Image& image);
+
+GLuint loadTexture(const std::string& filePath);
+
+// Carrega imagens do mesmo tamanho como camadas de uma GL_TEXTURE_2D_ARRAY, na ordem recebida.
+GLuint loadTextureArray(const std::vector<std::string>& filePaths);
@@ -0,0 +1,262 @@
+#include "renderer/texture_atlas.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include <numeric>
+
+#include "renderer/gl_state.hpp"
+
+namespace {
+    // Skyline: o contorno superior das imagens já colocadas, como segmentos horizontais da esquerda
+    // para a direita. Cada imagem nova vai na posição mais baixa (e depois mais à esquerda) onde cabe.
+    class SkylinePacker {
+    public:
+        SkylinePacker(const int width, const int height) : width(width), height(height) {
+            this->skyline.push_back({0, 0, width});
+        }
+
+        bool insert(const int rectWidth, const int rectHeight, int& outX, int& outY) {
+            int bestIndex = -1;
+            int bestY = this->height;
+            int bestX = 0;
+
+            for (size_t i = 0; i < this->skyline.size(); i++) {
+                int y;
+                if (fits(i, rectWidth, rectHeight, y) && y < bestY) {
+                    bestIndex = static_cast<int>(i);
+                    bestY = y;
+                    bestX = this->skyline[i].x;
+                }
+            }
+
+            if (bestIndex < 0) {
+                return false;
+            }
+
+            addSegment(bestIndex, bestX, bestY + rectHeight, rectWidth);
+            this->usedHeight = std::max(this->usedHeight, bestY + rectHeight);
+
+            outX = bestX;
+            outY = bestY;
+            return true;
+        }
+
+        int pageWidth() const { return this->width; }
+
+        int usedHeight = 0;
+
+    private:
+        struct Segment {
+            int x;
+            int y;
+            int width;
+        };
+
+        bool fits(const size_t index, const int rectWidth, const int rectHeight, int& y) const {
+            const int x = this->skyline[index].x;
+            if (x + rectWidth > this->width) {
+                return false;
+            }
+
+            y = 0;
+            int remaining = rectWidth;
+            for (size_t i = index; remaining > 0; i++) {
+                y = std::max(y, this->skyline[i].y);
+                if (y + rectHeight > this->height) {
+                    return false;
+                }
+                remaining -= this->skyline[i].width;
+            }
+
+            return true;
+        }
+
+        void addSegment(const int index, const int x, const int y, const int segmentWidth) {
+            this->skyline.insert(this->skyline.begin() + index, {x, y, segmentWidth});
+
+            // Corta ou remove os segmentos que ficaram embaixo do novo.
+            for (size_t i = index + 1; i < this->skyline.size(); i++) {
+                Segment& previous = this->skyline[i - 1];
+                Segment& current = this->skyline[i];
+                const int shrink = previous.x + previous.width - current.x;
+
+                if (shrink <= 0) {
+                    break;
+                }
+
+                current.x += shrink;
+                current.width -= shrink;
+
+                if (current.width > 0) {
+                    break;
+                }
+
+                this->skyline.erase(this->skyline.begin() + i);
+                i--;
+            }
+
+            // Junta segmentos vizinhos na mesma altura.
+            for (size_t i = 0; i + 1 < this->skyline.size(); i++) {
+                if (this->skyline[i].y == this->skyline[i + 1].y) {
+                    this->skyline[i].width += this->skyline[i + 1].width;
+                    this->skyline.erase(this->skyline.begin() + i + 1);
+                    i--;
+                }
+            }
+        }
+
+        int width;
+        int height;
+        std::vector<Segment> skyline;
+    };
+
+    struct Placement {
+        int page = 0;
+        int x = 0;
+        int y = 0;
+    };
+
+    // Copia a imagem para a página e replica as bordas dentro do padding.
+    void blitWithExtrusion(std::vector<unsigned char>& page, const int pageWidth, const Image& image,
+                           const int x, const int y, const int padding) {
+        for (int row = -padding; row < image.height + padding; row++) {
+            const int sourceRow = std::clamp(row, 0, image.height - 1);
+
+            for (int column = -padding; column < image.width + padding; column++) {
+                const int sourceColumn = std::clamp(column, 0, image.width - 1);
+
+                const unsigned char* source = &image.pixels[(static_cast<size_t>(sourceRow) * image.width + sourceColumn) * 4];
+                unsigned char* destination = &page[(static_cast<size_t>(y + row) * pageWidth + x + column) * 4];
+                std::memcpy(destination, source, 4);
+            }
+        }
+    }
+}
+
+TextureAtlas::TextureAtlas(const int pageSize, const int padding) : pageSize(pageSize), padding(padding) {
+}
+
+int TextureAtlas::add(const std::string& filePath) {
+    Image image;
+    if (!loadImage(filePath, image)) {
+        std::cout << "Failed to add " << filePath << " to the atlas" << std::endl;
+    }
+
+    return add(std::move(image));
+}
+
+int TextureAtlas::add(Image image) {
+    this->images.push_back(std::move(image));
+    this->regions.emplace_back();
+
+    return static_cast<int>(this->images.size()) - 1;
+}
+
+void TextureAtlas::build() {
+    // Imagens mais altas primeiro deixam o skyline mais plano e desperdiçam menos espaço.
+    std::vector<int> order(this->images.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::sort(order.begin(), order.end(), [this](const int a, const int b) {
+        return this->images[a].height > this->images[b].height;
+    });
+
+    std::vector<SkylinePacker> packers;
+    std::vector<Placement> placements(this->images.size());
+
+    for (const int id : order) {
+        const Image& image = this->images[id];
+        if (image.pixels.empty()) {
+            continue;
+        }
+
+        const int paddedWidth = image.width + 2 * this->padding;
+        const int paddedHeight = image.height + 2 * this->padding;
+
+        Placement& placement = placements[id];
+        bool placed = false;
+
+        for (size_t page = 0; page < packers.size() && !placed; page++) {
+            if (packers[page].insert(paddedWidth, paddedHeight, placement.x, placement.y)) {
+                placement.page = static_cast<int>(page);
+                placed = true;
+            }
+        }
+
+        if (!placed) {
+            // Imagens maiores que a página ganham uma página só delas.
+            packers.emplace_back(std::max(this->pageSize, paddedWidth), std::max(this->pageSize, paddedHeight));
+            packers.back().insert(paddedWidth, paddedHeight, placement.x, placement.y);
+            placement.page = static_cast<int>(packers.size()) - 1;
+        }
+    }
+
+    for (size_t page = 0; page < packers.size(); page++) {
+        // A página só precisa ser tão alta quanto o que foi ocupado.
+        const int pageWidth = packers[page].pageWidth();
+        const int pageHeight = packers[page].usedHeight;
+
+        std::vector<unsigned char> pixels(static_cast<size_t>(pageWidth) * pageHeight * 4, 0);
+
+        for (size_t id = 0; id < this->images.size(); id++) {
+            const Image& image = this->images[id];
+            const Placement& placement = placements[id];
+            if (image.pixels.empty() || placement.page != static_cast<int>(page)) {
+                continue;
+            }
+
+            const int x = placement.x + this->padding;
+            const int y = placement.y + this->padding;
+            blitWithExtrusion(pixels, pageWidth, image, x, y, this->padding);
+
+            AtlasRegion& region = this->regions[id];
+            region.width = image.width;
+            region.height = image.height;
+            region.uvRect = glm::vec4(
+                (float) x / (float) pageWidth,
+                (float) y / (float) pageHeight,
+                (float) (x + image.width) / (float) pageWidth,
+                (float) (y + image.height) / (float) pageHeight
+            );
+        }
+
+        GLuint texID;
+        glGenTextures(1, &texID);
+        bindTexture(GL_TEXTURE_2D, texID);
+
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, pageWidth, pageHeight, 0, GL_RGBA, GL_UNSIGNED_BYTE, pixels.data());
+
+        this->pageTextures.push_back(texID);
+        if (this->keepPageImages) {
+            this->pageImageList.push_back(Image{pageWidth, pageHeight, std::move(pixels)});
+        }
+
+        for (size_t id = 0; id < this->images.size(); id++) {
+            if (!this->images[id].pixels.empty() && placements[id].page == static_cast<int>(page)) {
+                this->regions[id].textureId = texID;
+            }
+        }
+    }
+
+    // Depois de enviadas para a GPU as imagens não são mais necessárias.
+    this->images.clear();
+    this->images.shrink_to_fit();
+}
+
+const AtlasRegion& TextureAtlas::region(const int id) const {
+    return this->regions[id];
+}
+
+void TextureAtlas::destroy() {
+    for (const GLuint texture : this->pageTextures) {
+        deleteTexture(texture);
+    }
+    this->pageTextures.clear();
+    this->pageImageList.clear();
+}
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <glad.h>
+
+#include <string>
+#include <vector>
+
+#include "glm/vec4.hpp"
+#include "renderer/texture.hpp"
+
+// Pedaço de uma página do atlas. uvRect é (u0, v0, u1, v1) dentro da textura da página.
+struct AtlasRegion {
+    GLuint textureId = 0;
+    glm::vec4 uvRect = glm::vec4(0.0f, 0.0f, 1.0f, 1.0f);
+    int width = 0;
+    int height = 0;
+};
+
+// Empacota várias imagens em poucas texturas grandes usando skyline bottom-left.
+// Cada imagem ganha `padding` pixels de borda preenchidos com a própria borda da imagem,
+// para o sampling nos limites da região não pegar os vizinhos.
+//
+// Uso: add() para cada arquivo, build() uma vez com o contexto ativo, depois region(id).
+class TextureAtlas {
+public:
+    explicit TextureAtlas(int pageSize = 2048, int padding = 2);
+
+    int add(const std::string& filePath);
+
+    // Para imagens que já foram decodificadas em outro lugar, como no AsyncTextureLoader.
+    int add(Image image);
+
+    void build();
+
+    const AtlasRegion& region(int id) const;
+
+    const std::vector<GLuint>& pages() const { return this->pageTextures; }
+
+    // Com keepPageImages ligado antes do build() as páginas também ficam na CPU, na ordem de pages(),
+    // para quem desenha sem a GPU.
+    bool keepPageImages = false;
+
+    const std::vector<Image>& pageImages() const { return this->pageImageList; }
+
+    void destroy();
+
+private:
+    int pageSize;
+    int padding;
+
+    std::vector<Image> images;
+    std::vector<AtlasRegion> regions;
+    std::vector<GLuint> pageTextures;
+    std::vector<Image> pageImageList;
+};
@@ -0,0 +1,72 @@
+#include "renderer/thread_pool.hpp"
+
+#include "renderer/profiler.hpp"
+
+ThreadPool::ThreadPool(unsigned int threads) {
+    if (threads == 0) {
+        threads = std::thread::hardware_concurrency();
+    }
+    if (threads == 0) {
+        threads = 1;
+    }
+
+    for (unsigned int i = 0; i < threads; i++) {
+        this->workers.emplace_back([this] { run(); });
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(this->mutex);
+        this->stopping = true;
+    }
+    this->taskAvailable.notify_all();
+
+    for (std::thread& worker : this->workers) {
+        worker.join();
+    }
+}
+
+void ThreadPool::submit(std::function<void()> task) {
+    {
+        std::lock_guard<std::mutex> lock(this->mutex);
+        this->tasks.push_back(std::move(task));
+    }
+    this->taskAvailable.notify_one();
+}
+
+void ThreadPool::wait() {
+    std::unique_lock<std::mutex> lock(this->mutex);
+    this->tasksFinished.wait(lock, [this] { return this->tasks.empty() && this->running == 0; });
+}
+
+void ThreadPool::run() {
+    nameProfilerThread("ThreadPool worker");
+
+    while (true) {
+        std::function<void()> task;
+
+        {
+            std::unique_lock<std::mutex> lock(this->mutex);
+            this->taskAvailable.wait(lock, [this] { return this->stopping || !this->tasks.empty(); });
+
+            if (this->tasks.empty()) {
+                return;
+            }
+
+            task = std::move(this->tasks.front());
+            this->tasks.pop_front();
+            this->running++;
+        }
+
+        task();
+
+        {
+            std::lock_guard<std::mutex> lock(this->mutex);
+            this->running--;
+            if (this->tasks.empty() && this->running == 0) {
+                this->tasksFinished.notify_all();
+            }
+        }
+    }
+}
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Pool fixo de threads com uma fila única de tarefas.
+class ThreadPool {
+public:
+    // 0 usa uma thread por núcleo.
+    explicit ThreadPool(unsigned int threads = 0);
+
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    void submit(std::function<void()> task);
+
+    // Bloqueia até a fila esvaziar e todas as tarefas em andamento terminarem.
+    void wait();
+
+    unsigned int size() const { return static_cast<unsigned int>(this->workers.size()); }
+
+private:
+    void run();
+
+    std::vector<std::thread> workers;
+    std::deque<std::function<void()>> tasks;
+
+    std::mutex mutex;
+    std::condition_variable taskAvailable;
+    std::condition_variable tasksFinished;
+
+    int running = 0;
+    bool stopping = false;
+};
@@ -0,0 +1,27 @@
+#include "renderer/uniform_buffer.hpp"
+
+static_assert(sizeof(FrameUniforms) == 80, "FrameUniforms precisa seguir o layout std140 do bloco Frame");
+
+void bindUniformBlocks(const GLuint program) {
+    const GLuint frameIndex = glGetUniformBlockIndex(program, "Frame");
+    if (frameIndex != GL_INVALID_INDEX) {
+        glUniformBlockBinding(program, frameIndex, FRAME_UNIFORM_BINDING);
+    }
+}
+
+void FrameUniformBuffer::create() {
+    glGenBuffers(1, &this->UBO);
+    glBindBuffer(GL_UNIFORM_BUFFER, this->UBO);
+    glBufferData(GL_UNIFORM_BUFFER, sizeof(FrameUniforms), nullptr, GL_DYNAMIC_DRAW);
+    glBindBufferBase(GL_UNIFORM_BUFFER, FRAME_UNIFORM_BINDING, this->UBO);
+}
+
+void FrameUniformBuffer::destroy() {
+    glDeleteBuffers(1, &this->UBO);
+    this->UBO = 0;
+}
+
+void FrameUniformBuffer::update(const FrameUniforms& uniforms) {
+    glBindBuffer(GL_UNIFORM_BUFFER, this->UBO);
+    glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(FrameUniforms), &uniforms);
+}
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <glad.h>
+
+#include "glm/mat4x4.hpp"
+
+// Blocos de uniforms compartilhados entre programas. Os shaders incluem as declarações por
+// concatenação de strings, logo depois da linha #version:
+//
+//   constexpr auto vertexShaderSource = "#version 330 core\n" FRAME_UNIFORM_BLOCK_GLSL R"GLSL(...)GLSL";
+//
+// e o programa precisa passar por bindUniformBlocks() depois de linkado.
+
+constexpr GLuint FRAME_UNIFORM_BINDING = 0;
+
+#define FRAME_UNIFORM_BLOCK_GLSL \
+    "layout (std140) uniform Frame {\n" \
+    "    mat4 projection;\n" \
+    "    float time;\n" \
+    "};\n"
+
+// Espelha o layout std140 do bloco acima.
+struct FrameUniforms {
+    glm::mat4 projection = glm::mat4(1);
+    float time = 0.0f;
+    float padding[3] = {};
+};
+
+void bindUniformBlocks(GLuint program);
+
+class FrameUniformBuffer {
+public:
+    void create();
+
+    void destroy();
+
+    void update(const FrameUniforms& uniforms);
+
+private:
+    GLuint UBO = 0;
+};